@@ -1,30 +1,45 @@
 #include <chrono>
+#include <cstdlib>
 #include <iostream>
 
 #include <hckt/tree.hpp>
 #include <hckt/lmemvector.hpp>
 #include "inc_populate_2d_a.cpp"
 
-int main()
+template <typename Alloc, typename Growth = hckt::exact_growth>
+void run(const size_t depth, const char * name)
 {
-    for(size_t i=0; i<8; ++i) {
-        std::cout << "DEPTH " << i << std::endl;
-        auto pstart = std::chrono::steady_clock::now();
-        hckt::tree<short> m;
-        populate(m, i);
-        auto pend = std::chrono::steady_clock::now();
-        auto pdiff = pend-pstart;
-        auto mstart = std::chrono::steady_clock::now();
-        m.mem_usage_info();
-        auto mend = std::chrono::steady_clock::now();
-        auto mdiff = mend - mstart;
-        std::cout << std::endl;
-        std::cout << "poptime: " << std::chrono::duration<double, std::milli>(pdiff).count() << " ms" << std::endl;
-        std::cout << "memtime: " << std::chrono::duration<double, std::milli>(mdiff).count() << " ms" << std::endl;
-        std::cout << std::endl;
-        std::cout << std::endl;
+    std::cout << "DEPTH " << depth << " " << name << std::endl;
+    auto pstart = std::chrono::steady_clock::now();
+    hckt::tree<short, Alloc, Growth> m;
+    populate(m, depth);
+    auto pend = std::chrono::steady_clock::now();
+    auto pdiff = pend-pstart;
+    auto mstart = std::chrono::steady_clock::now();
+    m.mem_usage_info();
+    auto mend = std::chrono::steady_clock::now();
+    auto mdiff = mend - mstart;
+    auto fstart = std::chrono::steady_clock::now();
+    m.collapse();
+    auto fend = std::chrono::steady_clock::now();
+    auto fdiff = fend - fstart;
+    std::cout << std::endl;
+    std::cout << "poptime:  " << std::chrono::duration<double, std::milli>(pdiff).count() << " ms" << std::endl;
+    std::cout << "memtime:  " << std::chrono::duration<double, std::milli>(mdiff).count() << " ms" << std::endl;
+    std::cout << "freetime: " << std::chrono::duration<double, std::milli>(fdiff).count() << " ms" << std::endl;
+    std::cout << std::endl;
+    std::cout << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    const size_t max_depth = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+
+    for(size_t i=0; i<max_depth; ++i) {
+        run<hckt::heap_allocator>(i, "heap");
+        run<hckt::pool_allocator>(i, "pool");
+        run<hckt::pool_allocator, hckt::geometric_growth>(i, "pool geometric");
     }
 
     return 0;
 }
-
@@ -0,0 +1,167 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/aggregate.hpp>
+#include <hckt/range.hpp>
+
+typedef hckt::sum_aggregate<std::uint64_t> policy;
+
+struct rect
+{
+    std::uint64_t x0, y0, x1, y1;
+};
+
+template <typename F>
+double time_ns(const std::size_t amount, const F & f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / amount;
+}
+
+std::uint64_t scan(const hckt::tree<std::uint64_t> & t, const rect & r, const unsigned depth)
+{
+    std::uint64_t sum { 0 };
+
+    hckt::for_each_in_rect(t, r.x0, r.y0, r.x1, r.y1, depth, [&sum](std::uint64_t, std::uint64_t, std::uint64_t, const std::uint64_t v) {
+        sum += v;
+    });
+
+    return sum;
+}
+
+/*
+ * a coarser insert over cells already set replaces them, the aggregates
+ * above have to follow the new leaf and not the cells it dropped
+ */
+bool check_coarse_insert()
+{
+    hckt::tree<std::uint64_t> t;
+
+    hckt::aggregate_insert<policy>(t, 0, 0, std::uint64_t { 5 }, 3);
+    hckt::aggregate_insert<policy>(t, 1, 1, std::uint64_t { 7 }, 3);
+    hckt::aggregate_insert<policy>(t, 0, 0, std::uint64_t { 100 }, 2);
+
+    std::uint64_t leaves { 0 };
+
+    hckt::for_each_in_rect(t, 0, 0, (1 << 9) - 1, (1 << 9) - 1, 3, [&leaves](std::uint64_t, std::uint64_t, std::uint64_t, const std::uint64_t v) {
+        leaves += v;
+    });
+
+    const std::uint64_t * cell { t.find(0, 0, 3) };
+
+    return hckt::aggregate_of<policy>(t) == 100 && leaves == 100 && cell != nullptr && *cell == 100;
+}
+
+int main(int argc, char ** argv)
+{
+    if(! check_coarse_insert()) {
+        std::cerr << "aggregate_insert over a subtree left stale aggregates" << std::endl;
+        return 1;
+    }
+
+    const unsigned      depth   { argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 5 };
+    const std::size_t   amount  { argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000 };
+    const std::size_t   queries { argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000 };
+    const std::uint64_t side    { 1ULL << (3 * depth) };
+
+    std::mt19937_64 rng { 1 };
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> points;
+
+    for(size_t i=0; i<amount; ++i) {
+        points.emplace_back(rng() % side, rng() % side);
+    }
+
+    std::cout << "POINTS " << hckt::render_number(amount) << " DEPTH " << depth << " sum" << std::endl;
+
+    hckt::tree<std::uint64_t> plain;
+    hckt::tree<std::uint64_t> summed;
+
+    std::cout << "insert:            " << time_ns(amount, [&] {
+        for(const auto & p : points) {
+            plain.insert(p.first, p.second, 1, depth);
+        }
+    }) << " ns" << std::endl;
+
+    std::cout << "aggregate_insert:  " << time_ns(amount, [&] {
+        for(const auto & p : points) {
+            hckt::aggregate_insert<policy>(summed, p.first, p.second, std::uint64_t { 1 }, depth);
+        }
+    }) << " ns" << std::endl;
+
+    std::cout << "aggregate_rebuild: " << time_ns(amount, [&] {
+        hckt::aggregate_rebuild<policy>(plain);
+    }) << " ns/point" << std::endl;
+
+    //the region one position of every level covers
+    for(unsigned level=1; level<depth; ++level) {
+        const unsigned shift { 3 * (depth - level) };
+        std::vector<rect> regions;
+
+        for(size_t i=0; i<queries; ++i) {
+            const std::uint64_t x { rng() % (side >> shift) };
+            const std::uint64_t y { rng() % (side >> shift) };
+
+            regions.push_back(rect { x << shift, y << shift, ((x + 1) << shift) - 1, ((y + 1) << shift) - 1 });
+        }
+
+        std::uint64_t a { 0 };
+        std::uint64_t b { 0 };
+
+        const double looked = time_ns(queries, [&] {
+            for(const rect & r : regions) {
+                a += hckt::region_aggregate<policy>(summed, r.x0 >> shift, r.y0 >> shift, level);
+            }
+        });
+
+        const double scanned = time_ns(queries, [&] {
+            for(const rect & r : regions) {
+                b += scan(summed, r, depth);
+            }
+        });
+
+        std::cout << std::endl << "LEVEL " << level << " (" << (1ULL << shift) << "^2 cells)" << std::endl;
+        std::cout << "region_aggregate:  " << looked << " ns (sum " << a << ")" << std::endl;
+        std::cout << "subtree scan:      " << scanned << " ns (sum " << b << ")" << std::endl;
+    }
+
+    //unaligned rectangles of growing size
+    for(std::uint64_t size=side / 64; size<=side / 2; size *= 4) {
+        std::vector<rect> rects;
+
+        for(size_t i=0; i<queries; ++i) {
+            const std::uint64_t x { rng() % (side - size) };
+            const std::uint64_t y { rng() % (side - size) };
+
+            rects.push_back(rect { x, y, x + size - 1, y + size - 1 });
+        }
+
+        std::uint64_t a { 0 };
+        std::uint64_t b { 0 };
+
+        const double aggregated = time_ns(queries, [&] {
+            for(const rect & r : rects) {
+                a += hckt::rect_aggregate<policy>(summed, r.x0, r.y0, r.x1, r.y1, depth);
+            }
+        });
+
+        const double scanned = time_ns(queries, [&] {
+            for(const rect & r : rects) {
+                b += scan(summed, r, depth);
+            }
+        });
+
+        std::cout << std::endl << "RECT " << size << "^2" << std::endl;
+        std::cout << "rect_aggregate:    " << aggregated << " ns (sum " << a << ")" << std::endl;
+        std::cout << "for_each_in_rect:  " << scanned << " ns (sum " << b << ")" << std::endl;
+    }
+
+    return 0;
+}
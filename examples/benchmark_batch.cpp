@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/bulk_load.hpp>
+#include <hckt/batch.hpp>
+
+template <typename Node>
+void single(const char * name, const Node & root, const std::vector<std::uint64_t> & keys, const unsigned depth)
+{
+    std::uint64_t sum { 0 };
+    auto start = std::chrono::steady_clock::now();
+
+    for(const std::uint64_t key : keys) {
+        std::uint32_t v { 0 };
+
+        if(hckt::find_key(root, key, depth, v)) {
+            sum += v;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::cout << name << " single:   " << std::chrono::duration<double, std::nano>(end - start).count() / keys.size() << " ns/lookup (sum " << sum << ")" << std::endl;
+}
+
+template <unsigned Group, typename Node>
+void batched(const char * name, const Node & root, const std::vector<std::uint64_t> & keys, const unsigned depth)
+{
+    std::vector<std::uint32_t> values(keys.size());
+    std::unique_ptr<bool[]> found { new bool[keys.size()] };
+
+    auto start = std::chrono::steady_clock::now();
+    hckt::find_batch<Group>(root, keys.data(), keys.size(), depth, values.data(), found.get());
+    auto end = std::chrono::steady_clock::now();
+
+    std::uint64_t sum { 0 };
+
+    for(size_t i=0; i<keys.size(); ++i) {
+        sum += found[i] ? values[i] : 0;
+    }
+
+    std::cout << name << " batch " << Group << ": " << std::chrono::duration<double, std::nano>(end - start).count() / keys.size() << " ns/lookup (sum " << sum << ")" << std::endl;
+}
+
+template <typename Node>
+void compare(const char * name, const Node & root, const std::vector<std::uint64_t> & keys, const unsigned depth)
+{
+    single(name, root, keys, depth);
+    batched<4>(name, root, keys, depth);
+    batched<16>(name, root, keys, depth);
+    batched<32>(name, root, keys, depth);
+}
+
+int main(int argc, char ** argv)
+{
+    const size_t   amount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000000;
+    const unsigned depth  = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8;
+
+    std::mt19937_64 rng { 1 };
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> points;
+    const std::uint64_t side { std::uint64_t { 1 } << (3 * depth) };
+
+    for(size_t i=0; i<amount; ++i) {
+        points.emplace_back(hckt::morton::encode_2d(rng() % side, rng() % side), i);
+    }
+
+    hckt::tree<std::uint32_t> m;
+    hckt::bulk_load(m, points, depth);
+
+    //half hits, half misses, in random order
+    std::vector<std::uint64_t> keys;
+
+    for(size_t i=0; i<amount; ++i) {
+        keys.push_back(i % 2 ? points[i].first : hckt::morton::encode_2d(rng() % side, rng() % side));
+    }
+
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    std::cout << "POINTS " << hckt::render_number(amount) << " DEPTH " << depth << std::endl;
+    compare("tree  ", m, keys, depth);
+
+    const hckt::frozen_tree<std::uint32_t> f = m.freeze();
+    m.collapse();
+    compare("frozen", *f.root(), keys, depth);
+
+    return 0;
+}
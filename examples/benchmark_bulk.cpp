@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/bulk_load.hpp>
+
+typedef hckt::tree<std::uint32_t> tree_type;
+
+//same masks and values in every node
+bool same(const tree_type & a, const tree_type & b)
+{
+    if(a.set_mask() != b.set_mask() || a.leaf_mask() != b.leaf_mask()) {
+        return false;
+    }
+
+    for(unsigned i=0; i<64; ++i) {
+        if(! a.is_set(i)) {
+            continue;
+        }
+
+        if(a.get_value(i) != b.get_value(i)) {
+            return false;
+        }
+
+        if(! a.is_leaf(i) && ! same(*a.child(i), *b.child(i))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char ** argv)
+{
+    const size_t   amount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+    const unsigned depth  = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 8;
+    const bool     check  = argc > 3 ? std::strtoul(argv[3], nullptr, 10) != 0 : true; //0 skips the insert built tree
+
+    std::mt19937_64 rng { 1 };
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> points;
+    points.reserve(amount);
+
+    const std::uint64_t side { std::uint64_t { 1 } << (3 * depth) };
+
+    for(size_t i=0; i<amount; ++i) {
+        points.emplace_back(hckt::morton::encode_2d(rng() % side, rng() % side), i);
+    }
+
+    std::cout << "POINTS " << hckt::render_number(amount) << " DEPTH " << depth << std::endl;
+
+    tree_type inserted;
+
+    if(check) {
+        auto start = std::chrono::steady_clock::now();
+
+        for(const auto & p : points) {
+            std::uint64_t x, y;
+            hckt::morton::decode_2d(p.first, x, y);
+            inserted.insert(x, y, p.second, depth);
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        std::cout << "inserttime: " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    hckt::parallel_sort(points.begin(), points.end());
+    auto sorted = std::chrono::steady_clock::now();
+
+    tree_type loaded;
+    hckt::bulk_load(loaded, points.begin(), points.end(), depth);
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << "sorttime:   " << std::chrono::duration<double, std::milli>(sorted - start).count() << " ms" << std::endl;
+    std::cout << "loadtime:   " << std::chrono::duration<double, std::milli>(end - sorted).count() << " ms" << std::endl;
+    std::cout << "bulktime:   " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+    if(check) {
+        const bool match { same(inserted, loaded) };
+
+        std::cout << "match:      " << (match ? "yes" : "NO") << std::endl;
+
+        if(! match) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/block_tree.hpp>
+
+struct tree_tag { };
+struct block_tag { };
+
+typedef std::pair<std::uint64_t, std::uint64_t> point;
+
+template <typename Tree>
+void insert(Tree & t, const point & p, const std::uint32_t value, const unsigned depth)
+{
+    hckt::morton::path<2> path { p.first, p.second, depth };
+    Tree * node { &t };
+
+    while(true) {
+        const unsigned pos { path.next() };
+
+        if(path.done()) {
+            if(node->is_set(pos)) {
+                node->set_value(pos, value);
+            } else {
+                node->insert_leaf(pos, value);
+            }
+
+            return;
+        }
+
+        if(! node->is_set(pos)) {
+            node->insert(pos, 0);
+        }
+
+        node = node->child(pos);
+    }
+}
+
+/*
+ * removes the cell and every node left empty above it
+ */
+template <typename Tree>
+void erase(Tree & t, const point & p, const unsigned depth)
+{
+    hckt::morton::path<2> path { p.first, p.second, depth };
+    Tree *   nodes[hckt::morton::max_depth_2d];
+    unsigned positions[hckt::morton::max_depth_2d];
+    unsigned amnt { 0 };
+    Tree *   node { &t };
+
+    while(true) {
+        const unsigned pos { path.next() };
+
+        if(! node->is_set(pos)) {
+            return;
+        }
+
+        nodes[amnt]     = node;
+        positions[amnt] = pos;
+        ++amnt;
+
+        if(path.done()) {
+            break;
+        }
+
+        node = node->child(pos);
+    }
+
+    --amnt;
+    nodes[amnt]->remove(positions[amnt]);
+
+    while(amnt-- > 0 && nodes[amnt]->child(positions[amnt])->set_mask() == 0) {
+        nodes[amnt]->remove(positions[amnt]);
+    }
+}
+
+template <typename Tree>
+std::uint64_t lookup(const Tree & t, const std::vector<point> & queries, const unsigned depth)
+{
+    std::uint64_t sum { 0 };
+
+    for(const point & p : queries) {
+        hckt::morton::path<2> path { p.first, p.second, depth };
+        const Tree * node { &t };
+
+        while(true) {
+            const unsigned pos { path.next() };
+
+            if(! node->is_set(pos)) {
+                break;
+            }
+
+            if(path.done() || node->is_leaf(pos)) {
+                sum += node->get_value(pos);
+                break;
+            }
+
+            node = node->child(pos);
+        }
+    }
+
+    return sum;
+}
+
+template <typename Alloc>
+void report(const char * name, const double ns, const std::uint64_t sum)
+{
+    const hckt::alloc_stats s { Alloc::stats() };
+
+    std::cout << name << hckt::render_number(static_cast<std::uint64_t>(ns)) << " ns/lookup"
+              << " (sum " << sum << ", in-use " << hckt::render_size(s.in_use) << ", reserved " << hckt::render_size(s.reserved) << ", frag " << s.fragmentation() * 100 << " %)" << std::endl;
+}
+
+template <typename Tree, typename Alloc>
+void run(const char * name, const unsigned depth, const std::size_t amount, const std::size_t churn, const std::size_t queries)
+{
+    const std::uint64_t side { 1ULL << (3 * depth) };
+
+    std::mt19937_64 rng { 1 };
+    std::vector<point> live;
+    Tree t;
+
+    for(std::size_t i=0; i<amount; ++i) {
+        live.emplace_back(rng() % side, rng() % side);
+        insert(t, live.back(), static_cast<std::uint32_t>(i), depth);
+    }
+
+    //replace random points, the freed nodes are reused all over the heap
+    for(std::size_t i=0; i<churn; ++i) {
+        point & p = live[rng() % live.size()];
+
+        erase(t, p, depth);
+        p = point { rng() % side, rng() % side };
+        insert(t, p, static_cast<std::uint32_t>(i), depth);
+    }
+
+    std::vector<point> q;
+
+    for(std::size_t i=0; i<queries; ++i) {
+        q.push_back(live[rng() % live.size()]);
+    }
+
+    const auto time = [&](std::uint64_t & sum) {
+        auto start = std::chrono::steady_clock::now();
+        sum = lookup(t, q, depth);
+        auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::duration<double, std::nano>(end - start).count() / queries;
+    };
+
+    std::uint64_t sum { 0 };
+
+    std::cout << name << std::endl;
+
+    const double churned = time(sum);
+    report<Alloc>("churned:     ", churned, sum);
+
+    auto cstart = std::chrono::steady_clock::now();
+    t.compact();
+    auto cend = std::chrono::steady_clock::now();
+
+    const double compacted = time(sum);
+    report<Alloc>("compacted:   ", compacted, sum);
+
+    std::cout << "compacttime: " << std::chrono::duration<double, std::milli>(cend - cstart).count() << " ms" << std::endl;
+    std::cout << "speedup:     " << churned / compacted << " x" << std::endl << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    const unsigned    depth   { argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 6 };
+    const std::size_t amount  { argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000 };
+    const std::size_t churn   { argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 2000000 };
+    const std::size_t queries { argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 5000000 };
+
+    std::cout << "POINTS " << hckt::render_number(amount) << " DEPTH " << depth << " CHURN " << hckt::render_number(churn) << std::endl << std::endl;
+
+    run<hckt::tree<std::uint32_t, hckt::basic_pool_allocator<tree_tag>>, hckt::basic_pool_allocator<tree_tag>>("tree", depth, amount, churn, queries);
+    run<hckt::block_tree<std::uint32_t, hckt::basic_pool_allocator<block_tag>>, hckt::basic_pool_allocator<block_tag>>("block_tree", depth, amount, churn, queries);
+
+    return 0;
+}
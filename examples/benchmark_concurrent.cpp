@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/concurrent_tree.hpp>
+
+/*
+ * readers look up random cells while an optional writer keeps inserting,
+ * every reader times each lookup on its own
+ */
+
+static const unsigned depth { 6 };
+static const std::uint64_t side { std::uint64_t { 1 } << (3 * depth) };
+
+/*
+ * the global lock setup concurrent_tree replaces
+ */
+struct locked_tree
+{
+    std::mutex                     lock;
+    hckt::tree<std::uint32_t>      t;
+
+    locked_tree() : lock { }, t { }
+    {
+    }
+
+    struct reader
+    {
+        locked_tree & l;
+
+        explicit reader(locked_tree & l) : l ( l )
+        {
+        }
+
+        bool find(const std::uint64_t x, const std::uint64_t y, std::uint32_t & value)
+        {
+            std::lock_guard<std::mutex> guard { l.lock };
+            const std::uint32_t * v { l.t.find(x, y, depth) };
+
+            if(v != nullptr) {
+                value = *v;
+            }
+
+            return v != nullptr;
+        }
+    };
+
+    void insert(const std::uint64_t x, const std::uint64_t y, const std::uint32_t value)
+    {
+        std::lock_guard<std::mutex> guard { lock };
+        t.insert(x, y, value, depth);
+    }
+};
+
+struct cow_tree
+{
+    hckt::concurrent_tree<std::uint32_t> t;
+
+    cow_tree() : t { }
+    {
+    }
+
+    struct reader
+    {
+        hckt::concurrent_tree<std::uint32_t>::reader r;
+
+        explicit reader(cow_tree & c) : r { c.t }
+        {
+        }
+
+        bool find(const std::uint64_t x, const std::uint64_t y, std::uint32_t & value)
+        {
+            return r.find(x, y, depth, value);
+        }
+    };
+
+    void insert(const std::uint64_t x, const std::uint64_t y, const std::uint32_t value)
+    {
+        t.insert(x, y, value, depth);
+    }
+};
+
+template <typename Tree>
+void run(const char * name, const unsigned readers, const bool writing, const unsigned ms)
+{
+    Tree t;
+    std::mt19937_64 rng { 1 };
+
+    for(std::size_t i=0; i<200000; ++i) {
+        t.insert(rng() % side, rng() % side, i);
+    }
+
+    std::atomic<bool>                       done    { false };
+    std::atomic<std::uint64_t>              written { 0 };
+    std::vector<std::vector<std::uint32_t>> latencies(readers);
+    std::vector<std::thread>                threads;
+
+    for(unsigned r=0; r<readers; ++r) {
+        threads.emplace_back([&t, &done, &latencies, r]() {
+            typename Tree::reader rd { t };
+            std::mt19937_64 rng { r + 2 };
+            std::uint64_t found { 0 };
+
+            while(! done) {
+                const std::uint64_t x { rng() % side };
+                const std::uint64_t y { rng() % side };
+                std::uint32_t v;
+
+                auto start = std::chrono::steady_clock::now();
+                found += rd.find(x, y, v);
+                auto end = std::chrono::steady_clock::now();
+
+                latencies[r].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            }
+
+            if(found == ~std::uint64_t { 0 }) {
+                std::cout << "unreachable" << std::endl;
+            }
+        });
+    }
+
+    if(writing) {
+        threads.emplace_back([&t, &done, &written]() {
+            std::mt19937_64 rng { 99 };
+
+            while(! done) {
+                t.insert(rng() % side, rng() % side, rng());
+                ++written;
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    done = true;
+
+    for(std::thread & th : threads) {
+        th.join();
+    }
+
+    std::vector<std::uint32_t> all;
+
+    for(const std::vector<std::uint32_t> & l : latencies) {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+
+    std::sort(all.begin(), all.end());
+
+    const auto at = [&all](const double q) { return all[static_cast<std::size_t>(q * (all.size() - 1))]; };
+
+    std::cout << name << (writing ? " +writer" : "        ")
+              << " lookups " << hckt::render_number(all.size())
+              << " writes " << hckt::render_number(written.load())
+              << " p50 " << at(0.5) << " ns"
+              << " p99 " << at(0.99) << " ns"
+              << " p999 " << at(0.999) << " ns"
+              << " max " << all.back() << " ns" << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    const unsigned readers = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4;
+    const unsigned ms      = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+
+    std::cout << "READERS " << readers << std::endl;
+
+    run<locked_tree>("mutex", readers, false, ms);
+    run<locked_tree>("mutex", readers, true, ms);
+    run<cow_tree>("cow  ", readers, false, ms);
+    run<cow_tree>("cow  ", readers, true, ms);
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <hckt/tree.hpp>
+
+struct point
+{
+    std::uint64_t x;
+    std::uint64_t y;
+};
+
+/*
+ * descent the way callers had to write it before tree::find
+ */
+template <typename Tree>
+const Tree * manual_find(const Tree * m, const point p, const unsigned depth, unsigned & pos)
+{
+    for(unsigned level=0; level<depth; ++level) {
+        const unsigned shift = 3 * (depth - 1 - level);
+        const unsigned lx    = (p.x >> shift) & 7;
+        const unsigned ly    = (p.y >> shift) & 7;
+
+        pos = hckt::get_position_2d(
+              ((lx >> 0) & 1) | (((ly >> 0) & 1) << 1)
+            , ((lx >> 1) & 1) | (((ly >> 1) & 1) << 1)
+            , ((lx >> 2) & 1) | (((ly >> 2) & 1) << 1)
+        );
+
+        if(! m->is_set(pos)) {
+            return nullptr;
+        }
+
+        if(level + 1 == depth || m->is_leaf(pos)) {
+            return m;
+        }
+
+        m = m->child(pos);
+    }
+
+    return nullptr;
+}
+
+void run(const char * name, const unsigned depth, const size_t amount, const std::uint64_t spread)
+{
+    std::vector<point> points(amount);
+    hckt::tree<std::uint32_t> m;
+
+    std::srand(depth);
+
+    for(size_t i=0; i<amount; ++i) {
+        points[i] = point {
+              (static_cast<std::uint64_t>(std::rand()) << 31 ^ std::rand()) % spread
+            , (static_cast<std::uint64_t>(std::rand()) << 31 ^ std::rand()) % spread
+        };
+    }
+
+    auto istart = std::chrono::steady_clock::now();
+    for(size_t i=0; i<amount; ++i) {
+        m.insert(points[i].x, points[i].y, i, depth);
+    }
+    auto iend = std::chrono::steady_clock::now();
+
+    std::uint64_t msum { 0 };
+    auto mstart = std::chrono::steady_clock::now();
+    for(const point & p : points) {
+        unsigned pos;
+        const auto * n = manual_find(&m, p, depth, pos);
+        msum += n == nullptr ? 0 : n->get_value(pos);
+    }
+    auto mend = std::chrono::steady_clock::now();
+
+    std::uint64_t fsum { 0 };
+    auto fstart = std::chrono::steady_clock::now();
+    for(const point & p : points) {
+        const std::uint32_t * v = m.find(p.x, p.y, depth);
+        fsum += v == nullptr ? 0 : *v;
+    }
+    auto fend = std::chrono::steady_clock::now();
+
+    std::cout << name << " DEPTH " << depth << std::endl;
+    std::cout << "inserttime: " << std::chrono::duration<double, std::milli>(iend - istart).count() << " ms" << std::endl;
+    std::cout << "manualtime: " << std::chrono::duration<double, std::nano>(mend - mstart).count() / amount << " ns/lookup" << std::endl;
+    std::cout << "findtime:   " << std::chrono::duration<double, std::nano>(fend - fstart).count() / amount << " ns/lookup" << (msum == fsum ? "" : " MISMATCH") << std::endl;
+    std::cout << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    const size_t amount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    //dense: all points in a small square, short shared paths
+    run("dense", 6, amount, 1 << 9);
+
+    //deep sparse: points scattered over the full coordinate range
+    run("sparse", 10, amount, std::uint64_t { 1 } << 30);
+    run("sparse", 21, amount, std::uint64_t { 1 } << 63);
+
+    return 0;
+}
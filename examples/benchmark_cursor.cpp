@@ -0,0 +1,171 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/cursor.hpp>
+
+typedef hckt::tree<std::uint32_t> tree_type;
+
+template <typename F>
+double time_ns(const std::size_t amount, F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(end - start).count() / amount;
+}
+
+void report(const char * name, const double root_ns, const double cursor_ns, const double visits)
+{
+    std::cout << name << std::endl;
+    std::cout << "find:      " << root_ns << " ns" << std::endl;
+    std::cout << "cursor:    " << cursor_ns << " ns (" << visits << " nodes/move)" << std::endl;
+    std::cout << "speedup:   " << root_ns / cursor_ns << " x" << std::endl << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    const unsigned    depth  { argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 4 };
+    const std::size_t amount { argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000000 };
+    const std::size_t steps  { argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 10000000 };
+
+    std::mt19937_64 rng { 1 };
+
+    {
+        const std::uint64_t side { 1ULL << (3 * depth) };
+        tree_type t;
+
+        for(std::size_t i=0; i<amount; ++i) {
+            t.insert(rng() % side, rng() % side, static_cast<std::uint32_t>(i), depth);
+        }
+
+        std::cout << "2D, DEPTH " << depth << ", " << hckt::render_number(amount) << " POINTS" << std::endl << std::endl;
+
+        //scanlines over the whole map until steps cells are read
+        const std::uint64_t rows { (steps + side - 1) / side };
+        std::uint64_t sum { 0 };
+
+        const double scan_root { time_ns(rows * side, [&] {
+            for(std::uint64_t y=0; y<rows; ++y) {
+                for(std::uint64_t x=0; x<side; ++x) {
+                    const std::uint32_t * v { t.find(x, y, depth) };
+                    sum += v == nullptr ? 0 : *v;
+                }
+            }
+        }) };
+
+        hckt::cursor<const tree_type> c { t, depth };
+
+        const double scan_cursor { time_ns(rows * side, [&] {
+            for(std::uint64_t y=0; y<rows; ++y) {
+                for(std::uint64_t x=0; x<side; ++x) {
+                    sum += c.move(x, y) ? c.value() : 0;
+                }
+            }
+        }) };
+
+        report("scanline", scan_root, scan_cursor, static_cast<double>(c.visited()) / (rows * side));
+
+        //random jumps, the cursor has nothing to reuse
+        std::vector<std::uint64_t> jumps;
+
+        for(std::size_t i=0; i<2*steps; ++i) {
+            jumps.push_back(rng() % side);
+        }
+
+        const double jump_root { time_ns(steps, [&] {
+            for(std::size_t i=0; i<steps; ++i) {
+                const std::uint32_t * v { t.find(jumps[2*i], jumps[2*i+1], depth) };
+                sum += v == nullptr ? 0 : *v;
+            }
+        }) };
+
+        hckt::cursor<const tree_type> j { t, depth };
+
+        const double jump_cursor { time_ns(steps, [&] {
+            for(std::size_t i=0; i<steps; ++i) {
+                sum += j.move(jumps[2*i], jumps[2*i+1]) ? j.value() : 0;
+            }
+        }) };
+
+        report("random", jump_root, jump_cursor, static_cast<double>(j.visited()) / steps);
+
+        //filling a scanline through the cursor instead of insert()
+        tree_type a;
+        tree_type b;
+
+        const double fill_root { time_ns(rows * side, [&] {
+            for(std::uint64_t y=0; y<rows; ++y) {
+                for(std::uint64_t x=0; x<side; ++x) {
+                    a.insert(x, y, static_cast<std::uint32_t>(x), depth);
+                }
+            }
+        }) };
+
+        hckt::cursor<tree_type> w { b, depth };
+
+        const double fill_cursor { time_ns(rows * side, [&] {
+            for(std::uint64_t y=0; y<rows; ++y) {
+                for(std::uint64_t x=0; x<side; ++x) {
+                    w.move(x, y);
+                    w.insert(static_cast<std::uint32_t>(x));
+                }
+            }
+        }) };
+
+        report("scanline fill", fill_root, fill_cursor, static_cast<double>(w.visited()) / (rows * side));
+
+        std::cout << "(sum " << sum << ")" << std::endl << std::endl;
+    }
+
+    {
+        const unsigned      depth3 { depth + 2 };
+        const std::uint64_t side   { 1ULL << (2 * depth3) };
+        tree_type t;
+
+        for(std::size_t i=0; i<amount; ++i) {
+            t.insert(rng() % side, rng() % side, rng() % side, static_cast<std::uint32_t>(i), depth3);
+        }
+
+        std::cout << "3D, DEPTH " << depth3 << ", " << hckt::render_number(amount) << " POINTS" << std::endl << std::endl;
+
+        //a random walk to face neighbours
+        std::vector<std::uint64_t> walk;
+        std::uint64_t p[3] { side / 2, side / 2, side / 2 };
+
+        for(std::size_t i=0; i<steps; ++i) {
+            p[rng() % 3] += (rng() & 1) ? 1 : -1;
+            walk.push_back(p[0] % side);
+            walk.push_back(p[1] % side);
+            walk.push_back(p[2] % side);
+        }
+
+        std::uint64_t sum { 0 };
+
+        const double walk_root { time_ns(steps, [&] {
+            for(std::size_t i=0; i<steps; ++i) {
+                const std::uint32_t * v { t.find(walk[3*i], walk[3*i+1], walk[3*i+2], depth3) };
+                sum += v == nullptr ? 0 : *v;
+            }
+        }) };
+
+        hckt::cursor<const tree_type, 3> c { t, depth3 };
+
+        const double walk_cursor { time_ns(steps, [&] {
+            for(std::size_t i=0; i<steps; ++i) {
+                sum += c.move(walk[3*i], walk[3*i+1], walk[3*i+2]) ? c.value() : 0;
+            }
+        }) };
+
+        report("neighbour walk", walk_root, walk_cursor, static_cast<double>(c.visited()) / steps);
+
+        std::cout << "(sum " << sum << ")" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,163 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/persistent_tree.hpp>
+#include "inc_populate_2d_a.cpp"
+
+/*
+ * random root to leaf paths, packed as 6 bits per level
+ * the last level is where the walk stopped
+ */
+struct path
+{
+    std::uint64_t positions;
+    unsigned      length;
+};
+
+template <typename Tree>
+std::vector<path> sample_paths(const Tree & m, const size_t amount)
+{
+    std::vector<path> paths;
+    paths.reserve(amount);
+
+    while(paths.size() < amount) {
+        const Tree * node = &m;
+        path p { 0, 0 };
+
+        while(node->has_children() && p.length < 10) {
+            unsigned pos;
+
+            do {
+                pos = std::rand() % 64;
+            } while(! node->is_set(pos));
+
+            p.positions |= static_cast<std::uint64_t>(pos) << (6 * p.length);
+            ++p.length;
+
+            if(node->is_leaf(pos)) {
+                break;
+            }
+
+            node = node->child(pos);
+        }
+
+        paths.push_back(p);
+    }
+
+    return paths;
+}
+
+template <typename Tree>
+std::uint64_t lookup(const Tree & m, const std::vector<path> & paths)
+{
+    std::uint64_t sum { 0 };
+
+    for(const path & p : paths) {
+        const Tree * node = &m;
+
+        for(unsigned i=0; i<p.length; ++i) {
+            const unsigned pos = (p.positions >> (6 * i)) & 63;
+
+            sum += node->get_value(pos);
+
+            if(i + 1 < p.length) {
+                node = node->child(pos);
+            }
+        }
+    }
+
+    return sum;
+}
+
+template <typename T>
+std::uint64_t run_frozen(const char * name, const hckt::tree<T> & m, const bool dedup, const std::vector<path> & paths)
+{
+    auto fstart = std::chrono::steady_clock::now();
+    const hckt::frozen_tree<T> f = m.freeze(dedup);
+    auto fend = std::chrono::steady_clock::now();
+
+    auto lstart = std::chrono::steady_clock::now();
+    const std::uint64_t sum = lookup(*f.root(), paths);
+    auto lend = std::chrono::steady_clock::now();
+
+    std::cout << name << std::endl;
+    f.mem_usage_info();
+    std::cout << "freezetime:" << std::chrono::duration<double, std::milli>(fend - fstart).count() << " ms" << std::endl;
+    std::cout << "looktime:  " << std::chrono::duration<double, std::milli>(lend - lstart).count() << " ms"
+              << " (" << (std::chrono::duration<double, std::nano>(lend - lstart).count() / paths.size()) << " ns/path, sum " << sum << ")" << std::endl;
+    std::cout << std::endl;
+
+    return sum;
+}
+
+template <typename T>
+void run_persistent(const hckt::tree<T> & m)
+{
+    hckt::persistent_tree<T> p { m };
+
+    std::cout << "persistent_tree" << std::endl;
+    p.mem_usage_info();
+
+    auto dstart = std::chrono::steady_clock::now();
+    p.deduplicate();
+    auto dend = std::chrono::steady_clock::now();
+
+    std::cout << "persistent_tree deduplicated" << std::endl;
+    p.mem_usage_info();
+    std::cout << "deduptime: " << std::chrono::duration<double, std::milli>(dend - dstart).count() << " ms" << std::endl;
+    std::cout << std::endl;
+}
+
+template <typename T>
+void compare(const char * name, const hckt::tree<T> & m, const size_t queries)
+{
+    std::srand(1);
+    const std::vector<path> paths = sample_paths(m, queries);
+
+    std::cout << name << std::endl << std::endl;
+
+    const std::uint64_t plain  = run_frozen("frozen_tree", m, false, paths);
+    const std::uint64_t merged = run_frozen("frozen_tree dedup", m, true, paths);
+
+    if(plain != merged) {
+        std::cout << "MISMATCH " << plain << " != " << merged << std::endl;
+    }
+
+    run_persistent(m);
+}
+
+int main(int argc, char ** argv)
+{
+    const size_t depth   = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5;
+    const size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000;
+
+    //every subtree of a level is the same
+    {
+        hckt::tree<std::uint32_t> m;
+        populate(m, depth);
+
+        std::cout << "DEPTH " << depth << " ";
+        compare("populate_2d_a", m, queries);
+    }
+
+    //distinct values everywhere, nothing to share
+    {
+        const std::uint64_t side { 1ULL << (3 * depth) };
+        std::mt19937_64 rng { 1 };
+        hckt::tree<std::uint32_t> m;
+
+        for(size_t i=0; i<1000000; ++i) {
+            m.insert(rng() % side, rng() % side, static_cast<std::uint32_t>(i), depth);
+        }
+
+        std::cout << "DEPTH " << depth << " ";
+        compare("random", m, queries);
+    }
+
+    return 0;
+}
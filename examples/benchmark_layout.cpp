@@ -0,0 +1,148 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/block_tree.hpp>
+#include "inc_populate_2d_a.cpp"
+
+/*
+ * random root to leaf paths, packed as 6 bits per level
+ * the last level is where the walk stopped
+ */
+struct path
+{
+    std::uint64_t positions;
+    unsigned      length;
+};
+
+template <typename Tree>
+std::vector<path> sample_paths(const Tree & m, const size_t amount)
+{
+    std::vector<path> paths;
+    paths.reserve(amount);
+
+    while(paths.size() < amount) {
+        const Tree * node = &m;
+        path p { 0, 0 };
+
+        while(node->has_children() && p.length < 10) {
+            unsigned pos;
+
+            do {
+                pos = std::rand() % 64;
+            } while(! node->is_set(pos));
+
+            p.positions |= static_cast<std::uint64_t>(pos) << (6 * p.length);
+            ++p.length;
+
+            if(node->is_leaf(pos)) {
+                break;
+            }
+
+            node = node->child(pos);
+        }
+
+        paths.push_back(p);
+    }
+
+    return paths;
+}
+
+template <typename Tree>
+std::uint64_t lookup(const Tree & m, const std::vector<path> & paths)
+{
+    std::uint64_t sum { 0 };
+
+    for(const path & p : paths) {
+        const Tree * node = &m;
+
+        for(unsigned i=0; i<p.length; ++i) {
+            const unsigned pos = (p.positions >> (6 * i)) & 63;
+
+            sum += node->get_value(pos);
+
+            if(i + 1 < p.length) {
+                node = node->child(pos);
+            }
+        }
+    }
+
+    return sum;
+}
+
+template <typename Tree>
+void run(const char * name, const size_t depth, const std::vector<path> & paths)
+{
+    auto pstart = std::chrono::steady_clock::now();
+    Tree m;
+    populate(m, depth);
+    auto pend = std::chrono::steady_clock::now();
+
+    auto lstart = std::chrono::steady_clock::now();
+    const std::uint64_t sum = lookup(m, paths);
+    auto lend = std::chrono::steady_clock::now();
+
+    std::cout << name << std::endl;
+    m.mem_usage_info();
+    std::cout << "poptime:   " << std::chrono::duration<double, std::milli>(pend - pstart).count() << " ms" << std::endl;
+    std::cout << "looktime:  " << std::chrono::duration<double, std::milli>(lend - lstart).count() << " ms"
+              << " (" << (std::chrono::duration<double, std::nano>(lend - lstart).count() / paths.size()) << " ns/path, sum " << sum << ")" << std::endl;
+    std::cout << std::endl;
+}
+
+template <typename T>
+void run_frozen(const size_t depth, const std::vector<path> & paths)
+{
+    hckt::tree<T> m;
+    populate(m, depth);
+
+    auto fstart = std::chrono::steady_clock::now();
+    const hckt::frozen_tree<T> f = m.freeze();
+    auto fend = std::chrono::steady_clock::now();
+
+    m.collapse();
+
+    auto lstart = std::chrono::steady_clock::now();
+    const std::uint64_t sum = lookup(*f.root(), paths);
+    auto lend = std::chrono::steady_clock::now();
+
+    std::cout << "frozen_tree" << std::endl;
+    f.mem_usage_info();
+    std::cout << "freezetime:" << std::chrono::duration<double, std::milli>(fend - fstart).count() << " ms" << std::endl;
+    std::cout << "looktime:  " << std::chrono::duration<double, std::milli>(lend - lstart).count() << " ms"
+              << " (" << (std::chrono::duration<double, std::nano>(lend - lstart).count() / paths.size()) << " ns/path, sum " << sum << ")" << std::endl;
+    std::cout << std::endl;
+}
+
+template <typename T>
+void compare(const size_t depth, const size_t queries)
+{
+    std::vector<path> paths;
+    {
+        hckt::tree<T> m;
+        populate(m, depth);
+        std::srand(1);
+        paths = sample_paths(m, queries);
+    }
+
+    run<hckt::tree<T>>("tree", depth, paths);
+    run<hckt::block_tree<T>>("block_tree", depth, paths);
+    run_frozen<T>(depth, paths);
+}
+
+int main(int argc, char ** argv)
+{
+    const size_t depth   = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5;
+    const size_t queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10000000;
+
+    std::cout << "DEPTH " << depth << " uint32_t" << std::endl;
+    compare<std::uint32_t>(depth, queries);
+
+    std::cout << "DEPTH " << depth << " short" << std::endl;
+    compare<short>(depth, queries);
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <hckt/tree.hpp>
+#include <hckt/mapped_tree.hpp>
+#include "inc_populate_2d_a.cpp"
+
+template <typename Tree>
+std::uint64_t sum_values(const Tree * m)
+{
+    std::uint64_t sum { 0 };
+
+    for(unsigned pos=0; pos<64; ++pos) {
+        if(! m->is_set(pos)) {
+            continue;
+        }
+
+        sum += m->get_value(pos);
+
+        if(! m->is_leaf(pos)) {
+            sum += sum_values(m->child(pos));
+        }
+    }
+
+    return sum;
+}
+
+int main(int argc, char ** argv)
+{
+    const size_t      depth = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5;
+    const std::string path  = argc > 2 ? argv[2] : "benchmark_mapped.hckt";
+
+    auto pstart = std::chrono::steady_clock::now();
+    hckt::tree<short> m;
+    populate(m, depth);
+    auto pend = std::chrono::steady_clock::now();
+
+    auto wstart = std::chrono::steady_clock::now();
+    hckt::write_tree(path, m, 2, depth);
+    auto wend = std::chrono::steady_clock::now();
+
+    const std::uint64_t expected = sum_values(&m);
+    m.collapse();
+
+    auto ostart = std::chrono::steady_clock::now();
+    hckt::mapped_tree<short> f(path);
+    auto oend = std::chrono::steady_clock::now();
+
+    auto vstart = std::chrono::steady_clock::now();
+    const bool ok = f.verify();
+    auto vend = std::chrono::steady_clock::now();
+
+    auto sstart = std::chrono::steady_clock::now();
+    const std::uint64_t sum = sum_values(f.root());
+    auto send = std::chrono::steady_clock::now();
+
+    std::cout << "DEPTH " << depth << std::endl;
+    std::cout << "file:      " << hckt::render_size(f.size()) << std::endl;
+    std::cout << "poptime:   " << std::chrono::duration<double, std::milli>(pend - pstart).count() << " ms" << std::endl;
+    std::cout << "writetime: " << std::chrono::duration<double, std::milli>(wend - wstart).count() << " ms" << std::endl;
+    std::cout << "opentime:  " << std::chrono::duration<double, std::milli>(oend - ostart).count() << " ms" << std::endl;
+    std::cout << "verify:    " << std::chrono::duration<double, std::milli>(vend - vstart).count() << " ms " << (ok ? "ok" : "FAILED") << std::endl;
+    std::cout << "scantime:  " << std::chrono::duration<double, std::milli>(send - sstart).count() << " ms " << (sum == expected ? "ok" : "MISMATCH") << std::endl;
+
+    return ok && sum == expected ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include <hckt/tree.hpp>
+#include <hckt/merkle.hpp>
+
+typedef hckt::tree<std::uint32_t>  tree_type;
+typedef hckt::merkle_index<tree_type> index_type;
+
+template <typename F>
+double time_ms(const F & f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+int main(int argc, char ** argv)
+{
+    const unsigned      depth  { argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 5 };
+    const std::size_t   amount { argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000000 };
+    const std::uint64_t side   { 1ULL << (3 * depth) };
+
+    std::mt19937_64 rng { 1 };
+
+    tree_type  source;
+    tree_type  replica;
+    index_type s { source };
+    index_type r { replica };
+
+    const double loadtime = time_ms([&] {
+        for(size_t i=0; i<amount; ++i) {
+            s.insert(rng() % side, rng() % side, static_cast<std::uint32_t>(i), depth);
+        }
+    });
+
+    std::cout << "POINTS " << hckt::render_number(amount) << " DEPTH " << depth << std::endl;
+    std::cout << "loadtime:  " << loadtime << " ms (hashed inserts)" << std::endl;
+    std::cout << "rehash:    " << time_ms([&] { s.rebuild(); }) << " ms (whole tree)" << std::endl;
+
+    //initial sync ships everything
+    index_type::delta_type full;
+
+    std::cout << "diff:      " << time_ms([&] { full = r.diff(s); }) << " ms (" << hckt::render_number(full.size()) << " entries, empty replica)" << std::endl;
+    std::cout << "apply:     " << time_ms([&] { r.apply(full); }) << " ms" << std::endl;
+
+    //then only what changed since
+    for(std::size_t writes=10; writes<=100000; writes *= 10) {
+        for(size_t i=0; i<writes; ++i) {
+            const std::uint64_t x { rng() % side };
+            const std::uint64_t y { rng() % side };
+
+            if(rng() % 4 == 0) {
+                s.erase(x, y, depth);
+            } else {
+                s.insert(x, y, static_cast<std::uint32_t>(rng()), depth);
+            }
+        }
+
+        index_type::delta_type delta;
+
+        const double difftime  = time_ms([&] { delta = r.diff(s); });
+        const double applytime = time_ms([&] { r.apply(delta); });
+
+        std::cout << std::endl << "WRITES " << hckt::render_number(writes) << std::endl;
+        std::cout << "diff:      " << difftime << " ms (" << hckt::render_number(delta.size()) << " entries)" << std::endl;
+        std::cout << "apply:     " << applytime << " ms" << std::endl;
+        std::cout << "in sync:   " << (r.hash() == s.hash() ? "yes" : "NO") << std::endl;
+    }
+
+    return 0;
+}
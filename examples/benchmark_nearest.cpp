@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/nearest.hpp>
+
+namespace dense
+{
+#include "inc_populate_2d_a.cpp"
+};
+
+namespace sparse
+{
+#include "inc_populate_2d_sparse.cpp"
+};
+
+struct point
+{
+    double x, y;
+};
+
+/*
+ * the baseline: every cell of the tree, distances computed for all of them
+ */
+template <typename Tree>
+void brute_force(const Tree & m, const std::vector<point> & queries, const unsigned depth, const std::size_t k)
+{
+    std::vector<hckt::rect_hit<short>> cells;
+    const std::uint64_t last { (std::uint64_t { 1 } << (3 * depth)) - 1 };
+
+    hckt::copy_in_rect(m, 0, 0, last, last, depth, std::back_inserter(cells));
+
+    std::vector<double> distances(cells.size());
+    double sum { 0 };
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(const point & q : queries) {
+        for(std::size_t i=0; i<cells.size(); ++i) {
+            const double lx { static_cast<double>(cells[i].x) };
+            const double ly { static_cast<double>(cells[i].y) };
+            const double dx { q.x < lx ? lx - q.x : q.x > lx + cells[i].size ? q.x - lx - cells[i].size : 0.0 };
+            const double dy { q.y < ly ? ly - q.y : q.y > ly + cells[i].size ? q.y - ly - cells[i].size : 0.0 };
+
+            distances[i] = dx * dx + dy * dy;
+        }
+
+        const std::size_t n { std::min(k, distances.size()) };
+        std::partial_sort(distances.begin(), distances.begin() + n, distances.end());
+
+        for(std::size_t i=0; i<n; ++i) {
+            sum += std::sqrt(distances[i]);
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "brute force (" << cells.size() << " cells): " << std::chrono::duration<double, std::micro>(end - start).count() / queries.size() << " us/query (sum " << sum << ")" << std::endl;
+}
+
+template <typename Tree>
+void nearest(const Tree & m, const std::vector<point> & queries, const unsigned depth, const std::size_t k)
+{
+    std::vector<hckt::neighbor<hckt::rect_hit<short>>> found;
+    double sum { 0 };
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(const point & q : queries) {
+        found.clear();
+        hckt::nearest_2d(m, q.x, q.y, k, depth, std::back_inserter(found));
+
+        for(const auto & n : found) {
+            sum += n.distance;
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "nearest " << k << ":    " << std::chrono::duration<double, std::micro>(end - start).count() / queries.size() << " us/query (sum " << sum << ")" << std::endl;
+}
+
+template <typename Tree>
+void radius(const Tree & m, const std::vector<point> & queries, const unsigned depth, const double r)
+{
+    std::uint64_t hits { 0 };
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(const point & q : queries) {
+        hckt::for_each_in_circle(m, q.x, q.y, r, depth, [&hits](std::uint64_t, std::uint64_t, std::uint64_t, short) {
+            ++hits;
+        });
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "radius " << r << ":   " << std::chrono::duration<double, std::micro>(end - start).count() / queries.size() << " us/query (hits " << hits << ")" << std::endl;
+}
+
+template <typename Tree>
+void run(const char * name, const Tree & m, const unsigned depth, const double extent)
+{
+    std::mt19937_64 rng { 1 };
+    std::uniform_real_distribution<double> coord { 0, extent };
+    std::vector<point> queries;
+
+    for(std::size_t i=0; i<1000; ++i) {
+        queries.push_back(point { coord(rng), coord(rng) });
+    }
+
+    std::cout << name << " DEPTH " << depth << std::endl;
+    brute_force(m, queries, depth, 16);
+    nearest(m, queries, depth, 1);
+    nearest(m, queries, depth, 16);
+    radius(m, queries, depth, 4);
+    std::cout << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    const unsigned depth = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4;
+
+    {
+        hckt::tree<short> m;
+        dense::populate(m, depth);
+        run("dense", m, depth + 1, std::pow(8.0, depth + 1));
+    }
+
+    {
+        hckt::tree<short> m;
+        sparse::populate(m, depth);
+        run("sparse", m, depth, std::pow(8.0, depth));
+    }
+
+    return 0;
+}
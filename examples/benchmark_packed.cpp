@@ -0,0 +1,139 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/block_tree.hpp>
+#include <hckt/packed_tree.hpp>
+#include "inc_populate_2d_sparse.cpp"
+
+typedef std::pair<std::uint64_t, std::uint64_t> point;
+
+template <typename Tree>
+void insert(Tree & t, const point & p, const std::uint32_t value, const unsigned depth)
+{
+    hckt::morton::path<2> path { p.first, p.second, depth };
+    Tree * node { &t };
+
+    while(true) {
+        const unsigned pos { path.next() };
+
+        if(path.done()) {
+            if(node->is_set(pos)) {
+                node->set_value(pos, value);
+            } else {
+                node->insert_leaf(pos, value);
+            }
+
+            return;
+        }
+
+        if(! node->is_set(pos)) {
+            node->insert(pos, 0);
+        }
+
+        node = node->child(pos);
+    }
+}
+
+template <typename Tree>
+std::uint64_t lookup(const Tree & t, const std::vector<point> & queries, const unsigned depth)
+{
+    std::uint64_t sum { 0 };
+
+    for(const point & p : queries) {
+        hckt::morton::path<2> path { p.first, p.second, depth };
+        const Tree * node { &t };
+
+        while(true) {
+            const unsigned pos { path.next() };
+
+            if(! node->is_set(pos)) {
+                break;
+            }
+
+            if(path.done() || node->is_leaf(pos)) {
+                sum += node->get_value(pos);
+                break;
+            }
+
+            node = node->child(pos);
+        }
+    }
+
+    return sum;
+}
+
+/*
+ * the deep sparse map of 2d_zoom_render_deep_sparse, values 8..15
+ */
+template <typename Tree>
+void run_sparse(const char * name, const int depth)
+{
+    Tree m;
+
+    std::srand(1);
+    populate(m, depth);
+
+    std::cout << name << std::endl;
+    m.mem_usage_info();
+    std::cout << std::endl;
+}
+
+/*
+ * random points with values 0..15
+ */
+template <typename Tree>
+void run_points(const char * name, const unsigned depth, const std::size_t amount, const std::size_t queries)
+{
+    const std::uint64_t side { 1ULL << (3 * depth) };
+
+    std::mt19937_64 rng { 1 };
+    std::vector<point> points;
+    Tree t;
+
+    for(std::size_t i=0; i<amount; ++i) {
+        points.emplace_back(rng() % side, rng() % side);
+        insert(t, points.back(), static_cast<std::uint32_t>(rng() % 16), depth);
+    }
+
+    std::vector<point> q;
+
+    for(std::size_t i=0; i<queries; ++i) {
+        q.push_back(points[rng() % points.size()]);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const std::uint64_t sum { lookup(t, q, depth) };
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << name << std::endl;
+    t.mem_usage_info();
+    std::cout << "lookup:    " << std::chrono::duration<double, std::nano>(end - start).count() / queries << " ns (sum " << sum << ")" << std::endl << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    const int         sparse_depth { argc > 1 ? std::atoi(argv[1]) : 16006 };
+    const unsigned    depth        { argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 5 };
+    const std::size_t amount       { argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000000 };
+    const std::size_t queries      { argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 5000000 };
+
+    std::cout << "DEEP SPARSE, DEPTH " << sparse_depth << std::endl << std::endl;
+
+    run_sparse<hckt::tree<std::uint32_t>>("tree<u32>", sparse_depth);
+    run_sparse<hckt::block_tree<std::uint32_t>>("block_tree<u32>", sparse_depth);
+    run_sparse<hckt::packed_tree<std::uint32_t, 4>>("packed_tree<u32, 4>", sparse_depth);
+
+    std::cout << "POINTS " << hckt::render_number(amount) << " DEPTH " << depth << std::endl << std::endl;
+
+    run_points<hckt::tree<std::uint32_t>>("tree<u32>", depth, amount, queries);
+    run_points<hckt::block_tree<std::uint32_t>>("block_tree<u32>", depth, amount, queries);
+    run_points<hckt::packed_tree<std::uint32_t, 4>>("packed_tree<u32, 4>", depth, amount, queries);
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include <hckt/tree.hpp>
+#include <hckt/parallel.hpp>
+
+#include "inc_populate_2d_a.cpp"
+
+typedef hckt::tree<short> tree_type;
+
+template <typename Executor>
+double sum_leaves(Executor & executor, const tree_type & m, std::uint64_t & sum)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    sum = hckt::parallel_map_reduce(executor, m, std::uint64_t { 0 }, [](const short v) {
+        return static_cast<std::uint64_t>(v);
+    }, [](const std::uint64_t a, const std::uint64_t b) {
+        return a + b;
+    });
+
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+template <typename Executor>
+double count_children(Executor & executor, const tree_type & m, std::uint64_t & amnt)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    amnt = hckt::parallel_reduce_nodes(executor, m, std::uint64_t { 0 }, [](const tree_type & n) {
+        return static_cast<std::uint64_t>(n.children_amnt());
+    }, [](const std::uint64_t a, const std::uint64_t b) {
+        return a + b;
+    });
+
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+template <typename Executor>
+void run(const char * name, Executor & executor, const tree_type & m)
+{
+    std::uint64_t sum  { 0 };
+    std::uint64_t amnt { 0 };
+
+    const double sumtime   { sum_leaves(executor, m, sum) };
+    const double counttime { count_children(executor, m, amnt) };
+
+    tree_type copy;
+
+    auto cstart = std::chrono::steady_clock::now();
+    hckt::parallel_clone(executor, m, copy);
+    auto cend = std::chrono::steady_clock::now();
+
+    std::uint64_t copy_sum { 0 };
+    sum_leaves(executor, copy, copy_sum);
+
+    auto fstart = std::chrono::steady_clock::now();
+    hckt::parallel_collapse(executor, copy);
+    auto fend = std::chrono::steady_clock::now();
+
+    std::cout << name << std::endl;
+    std::cout << "sumtime:   " << sumtime << " ms (sum " << sum << ")" << std::endl;
+    std::cout << "counttime: " << counttime << " ms (children " << amnt << ")" << std::endl;
+    std::cout << "clonetime: " << std::chrono::duration<double, std::milli>(cend - cstart).count() << " ms" << (copy_sum == sum ? "" : " MISMATCH") << std::endl;
+    std::cout << "freetime:  " << std::chrono::duration<double, std::milli>(fend - fstart).count() << " ms" << std::endl;
+    std::cout << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    const int      depth   = argc > 1 ? std::atoi(argv[1]) : 5;
+    const unsigned max_thr = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+
+    tree_type m;
+    populate(m, depth);
+
+    std::cout << "DEPTH " << depth << std::endl;
+    std::cout << std::endl;
+
+    hckt::serial_executor serial;
+    run("serial", serial, m);
+
+    for(unsigned threads=1; threads<=max_thr; threads *= 2) {
+        hckt::work_stealing_pool pool { threads };
+        std::cout << "THREADS " << threads << " ";
+        run("pool", pool, m);
+    }
+
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/bulk_load.hpp>
+#include <hckt/range.hpp>
+
+struct query
+{
+    std::uint64_t x0, y0, x1, y1;
+};
+
+/*
+ * the traversal range queries replace, every position of every
+ * intersecting node is tested on its own
+ */
+template <typename Node>
+void scan_rect(const Node & node, const std::uint64_t ox, const std::uint64_t oy, const unsigned shift, const query & q, std::uint64_t & hits, std::uint64_t & sum)
+{
+    for(unsigned pos=0; pos<64; ++pos) {
+        if(! node.is_set(pos)) {
+            continue;
+        }
+
+        std::uint64_t lx, ly;
+        hckt::morton::decode_2d(pos, lx, ly);
+
+        const std::uint64_t x    { ox + (lx << shift) };
+        const std::uint64_t y    { oy + (ly << shift) };
+        const std::uint64_t last { (std::uint64_t { 1 } << shift) - 1 };
+
+        if(x > q.x1 || y > q.y1 || x + last < q.x0 || y + last < q.y0) {
+            continue;
+        }
+
+        if(shift == 0 || node.is_leaf(pos)) {
+            ++hits;
+            sum += node.get_value(pos);
+        } else {
+            scan_rect(*node.child(pos), x, y, shift - 3, q, hits, sum);
+        }
+    }
+}
+
+template <typename Node>
+void run(const char * name, const Node & root, const std::vector<query> & queries, const unsigned depth)
+{
+    std::uint64_t hits { 0 };
+    std::uint64_t sum  { 0 };
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(const query & q : queries) {
+        hckt::for_each_in_rect(root, q.x0, q.y0, q.x1, q.y1, depth, [&hits, &sum](std::uint64_t, std::uint64_t, std::uint64_t, const std::uint32_t value) {
+            ++hits;
+            sum += value;
+        });
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    const double ns { std::chrono::duration<double, std::nano>(end - start).count() };
+
+    std::cout << name << ": " << ns / queries.size() << " ns/query " << ns / (hits ? hits : 1) << " ns/hit (hits " << hits << " sum " << sum << ")" << std::endl;
+}
+
+template <typename Node>
+void run_scan(const char * name, const Node & root, const std::vector<query> & queries, const unsigned depth)
+{
+    std::uint64_t hits { 0 };
+    std::uint64_t sum  { 0 };
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(const query & q : queries) {
+        scan_rect(root, 0, 0, 3 * (depth - 1), q, hits, sum);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    const double ns { std::chrono::duration<double, std::nano>(end - start).count() };
+
+    std::cout << name << ": " << ns / queries.size() << " ns/query " << ns / (hits ? hits : 1) << " ns/hit (hits " << hits << " sum " << sum << ")" << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    const size_t   amount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000000;
+    const unsigned depth  = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 6;
+
+    std::mt19937_64 rng { 1 };
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> points;
+    const std::uint64_t side { std::uint64_t { 1 } << (3 * depth) };
+
+    for(size_t i=0; i<amount; ++i) {
+        points.emplace_back(hckt::morton::encode_2d(rng() % side, rng() % side), i);
+    }
+
+    hckt::tree<std::uint32_t> m;
+    hckt::bulk_load(m, points, depth);
+
+    const hckt::frozen_tree<std::uint32_t> f = m.freeze();
+
+    std::cout << "POINTS " << hckt::render_number(amount) << " DEPTH " << depth << std::endl;
+
+    //square queries covering a growing share of the area
+    for(std::uint64_t extent=side / 4096; extent<=side / 4; extent *= 8) {
+        std::vector<query> queries;
+
+        for(size_t i=0; i<1000; ++i) {
+            const std::uint64_t x { rng() % (side - extent) };
+            const std::uint64_t y { rng() % (side - extent) };
+
+            queries.push_back(query { x, y, x + extent - 1, y + extent - 1 });
+        }
+
+        std::cout << "EXTENT " << extent << std::endl;
+        run_scan("scan  ", m, queries, depth);
+        run("tree  ", m, queries, depth);
+        run("frozen", *f.root(), queries, depth);
+    }
+
+    return 0;
+}
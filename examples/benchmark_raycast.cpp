@@ -0,0 +1,184 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/bulk_load.hpp>
+#include <hckt/raycast.hpp>
+
+typedef hckt::neighbor<hckt::box_hit<std::uint8_t>> hit_type;
+
+/*
+ * rolling terrain, the surface of every column down to its lowest
+ * neighbour so the shell has no holes
+ */
+std::vector<std::pair<std::uint64_t, std::uint8_t>> terrain(const unsigned depth)
+{
+    const std::uint64_t side { std::uint64_t { 1 } << (2 * depth) };
+    const double        s    ( static_cast<double>(side) );
+    std::vector<std::pair<std::uint64_t, std::uint8_t>> voxels;
+
+    const auto height = [side, s](const std::uint64_t x, const std::uint64_t z) -> std::uint64_t {
+        const double h { 0.3 + 0.1 * std::sin(x * 12.0 / s) * std::cos(z * 9.0 / s) + 0.05 * std::sin((x + 2 * z) * 40.0 / s) };
+        return std::min<std::uint64_t>(side - 1, static_cast<std::uint64_t>(h * s));
+    };
+
+    for(std::uint64_t x=0; x<side; ++x) {
+        for(std::uint64_t z=0; z<side; ++z) {
+            const std::uint64_t h { height(x, z) };
+            std::uint64_t       low { h };
+
+            if(x > 0)        low = std::min(low, height(x - 1, z));
+            if(x + 1 < side) low = std::min(low, height(x + 1, z));
+            if(z > 0)        low = std::min(low, height(x, z - 1));
+            if(z + 1 < side) low = std::min(low, height(x, z + 1));
+
+            for(std::uint64_t y=low; y<=h; ++y) {
+                voxels.emplace_back(hckt::morton::encode_3d(x, y, z), static_cast<std::uint8_t>(1 + y % 255));
+            }
+        }
+    }
+
+    return voxels;
+}
+
+/*
+ * primary rays of a camera looking down onto the terrain, emitted in
+ * 8x8 pixel tiles so neighbouring rays end up in the same packet
+ */
+std::vector<hckt::ray> camera(const unsigned depth, const unsigned width)
+{
+    const double s ( static_cast<double>(std::uint64_t { 1 } << (2 * depth)) );
+    std::vector<hckt::ray> rays;
+
+    for(unsigned ty=0; ty<width; ty += 8) {
+        for(unsigned tx=0; tx<width; tx += 8) {
+            for(unsigned py=ty; py<ty + 8; ++py) {
+                for(unsigned px=tx; px<tx + 8; ++px) {
+                    const double u { (px + 0.5) / width - 0.5 };
+                    const double v { (py + 0.5) / width - 0.5 };
+                    hckt::ray r { { 0.5 * s, 0.9 * s, -0.2 * s }, { u, v - 0.6, 1.0 } };
+                    const double len { std::sqrt(r.direction[0] * r.direction[0] + r.direction[1] * r.direction[1] + r.direction[2] * r.direction[2]) };
+
+                    for(unsigned d=0; d<3; ++d) {
+                        r.direction[d] /= len;
+                    }
+
+                    rays.push_back(r);
+                }
+            }
+        }
+    }
+
+    return rays;
+}
+
+std::vector<hckt::ray> scattered(const unsigned depth, const std::size_t amount)
+{
+    const double s ( static_cast<double>(std::uint64_t { 1 } << (2 * depth)) );
+    std::mt19937_64 rng { 1 };
+    std::uniform_real_distribution<double> pos { 0, s };
+    std::normal_distribution<double> dir { 0, 1 };
+    std::vector<hckt::ray> rays;
+
+    for(std::size_t i=0; i<amount; ++i) {
+        hckt::ray r { { pos(rng), pos(rng), pos(rng) }, { dir(rng), dir(rng), dir(rng) } };
+        const double len { std::sqrt(r.direction[0] * r.direction[0] + r.direction[1] * r.direction[1] + r.direction[2] * r.direction[2]) };
+
+        for(unsigned d=0; d<3; ++d) {
+            r.direction[d] /= len;
+        }
+
+        rays.push_back(r);
+    }
+
+    return rays;
+}
+
+template <typename Node>
+void run(const char * name, const Node & root, const std::vector<hckt::ray> & rays, const unsigned depth)
+{
+    {
+        std::size_t hits { 0 };
+        double      sum  { 0 };
+        auto start = std::chrono::steady_clock::now();
+
+        for(const hckt::ray & r : rays) {
+            hit_type h;
+
+            if(hckt::raycast_first(root, r, depth, h)) {
+                ++hits;
+                sum += h.distance;
+            }
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        std::cout << name << " first:  " << rays.size() / std::chrono::duration<double, std::micro>(end - start).count() << " Mrays/s (hits " << hits << " sum " << sum << ")" << std::endl;
+    }
+
+    {
+        std::vector<hit_type> hits(rays.size());
+        std::unique_ptr<bool[]> found { new bool[rays.size()] };
+        auto start = std::chrono::steady_clock::now();
+
+        hckt::raycast_packet(root, rays.data(), rays.size(), depth, hits.data(), found.get());
+
+        auto end = std::chrono::steady_clock::now();
+        std::size_t amnt { 0 };
+        double      sum  { 0 };
+
+        for(std::size_t i=0; i<rays.size(); ++i) {
+            if(found[i]) {
+                ++amnt;
+                sum += hits[i].distance;
+            }
+        }
+
+        std::cout << name << " packet: " << rays.size() / std::chrono::duration<double, std::micro>(end - start).count() << " Mrays/s (hits " << amnt << " sum " << sum << ")" << std::endl;
+    }
+
+    {
+        std::size_t hits { 0 };
+        auto start = std::chrono::steady_clock::now();
+
+        for(const hckt::ray & r : rays) {
+            hckt::for_each_on_ray(root, r, depth, [&hits](std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t, std::uint8_t, double) {
+                ++hits;
+                return true;
+            });
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        std::cout << name << " all:    " << rays.size() / std::chrono::duration<double, std::micro>(end - start).count() << " Mrays/s (hits " << hits << ")" << std::endl;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    const unsigned depth = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5;
+    const unsigned width = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 512;
+
+    std::vector<std::pair<std::uint64_t, std::uint8_t>> voxels { terrain(depth) };
+    hckt::tree<std::uint8_t> m;
+    hckt::bulk_load(m, voxels, depth);
+
+    const hckt::frozen_tree<std::uint8_t> f = m.freeze();
+    const std::vector<hckt::ray> primary { camera(depth, width) };
+    const std::vector<hckt::ray> random  { scattered(depth, primary.size()) };
+
+    std::cout << "VOXELS " << hckt::render_number(voxels.size()) << " DEPTH " << depth << " RAYS " << hckt::render_number(primary.size()) << std::endl;
+    std::cout << "camera" << std::endl;
+    run("tree  ", m, primary, depth);
+    run("frozen", *f.root(), primary, depth);
+    std::cout << "scattered" << std::endl;
+    run("tree  ", m, random, depth);
+    run("frozen", *f.root(), random, depth);
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/reclaim.hpp>
+
+//the background reclaimer frees from its own thread, every mode uses the same allocator
+struct reclaim_tag { };
+typedef hckt::locked_allocator<hckt::basic_pool_allocator<reclaim_tag>> alloc_type;
+typedef hckt::tree<std::uint32_t, alloc_type>                           tree_type;
+
+/*
+ * removing a subtree, synchronously or through a reclaimer
+ */
+struct sync_mode
+{
+    void remove(tree_type & t, const unsigned pos) { t.remove(pos); }
+    void step()                                    { }
+    void finish()                                  { }
+};
+
+struct deferred_mode
+{
+    hckt::deferred_reclaimer<tree_type> r;
+    std::size_t                         budget;
+
+    void remove(tree_type & t, const unsigned pos) { r.remove(t, pos); }
+    void step()                                    { r.drain(budget); }
+    void finish()                                  { r.drain_all(); }
+};
+
+struct background_mode
+{
+    hckt::background_reclaimer<tree_type> r;
+
+    background_mode() : r { }
+    {
+    }
+
+    void remove(tree_type & t, const unsigned pos) { r.remove(t, pos); }
+    void step()                                    { }
+    void finish()                                  { r.wait_idle(); }
+};
+
+/*
+ * inserts, with every removes-th operation dropping a whole subtree below
+ * the root, each timed on its own
+ */
+template <typename Mode>
+void run(const std::string & name, Mode & mode, const unsigned depth, const std::size_t preload, const std::size_t ops, const std::size_t removes)
+{
+    const std::uint64_t side { 1ULL << (3 * depth) };
+
+    std::mt19937_64 rng { 1 };
+    tree_type t;
+
+    for(std::size_t i=0; i<preload; ++i) {
+        t.insert(rng() % side, rng() % side, static_cast<std::uint32_t>(i), depth);
+    }
+
+    std::vector<std::uint32_t> latencies;
+    latencies.reserve(ops);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for(std::size_t i=0; i<ops; ++i) {
+        auto ostart = std::chrono::steady_clock::now();
+
+        if(i % removes == removes - 1) {
+            const unsigned pos ( rng() % 64 );
+
+            if(t.is_set(pos)) {
+                mode.remove(t, pos);
+            }
+        } else {
+            t.insert(rng() % side, rng() % side, static_cast<std::uint32_t>(i), depth);
+        }
+
+        mode.step();
+
+        auto oend = std::chrono::steady_clock::now();
+        latencies.push_back(static_cast<std::uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(oend - ostart).count()));
+    }
+
+    mode.finish();
+
+    auto end = std::chrono::steady_clock::now();
+
+    std::sort(latencies.begin(), latencies.end());
+
+    const auto at = [&latencies](const double q) { return latencies[static_cast<std::size_t>(q * (latencies.size() - 1))]; };
+
+    std::cout << name
+              << " total " << std::chrono::duration<double, std::milli>(end - start).count() << " ms"
+              << " p50 " << at(0.5) << " ns"
+              << " p99 " << at(0.99) << " ns"
+              << " p999 " << at(0.999) << " ns"
+              << " max " << latencies.back() << " ns" << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    const unsigned    depth   { argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 5 };
+    const std::size_t preload { argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000000 };
+    const std::size_t ops     { argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000000 };
+    const std::size_t removes { argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 500 };
+
+    std::cout << "PRELOAD " << hckt::render_number(preload) << " DEPTH " << depth
+              << " OPS " << hckt::render_number(ops) << " subtree remove every " << removes << std::endl;
+
+    {
+        sync_mode mode;
+        run("sync             ", mode, depth, preload, ops, removes);
+    }
+
+    for(std::size_t budget : { 16, 64, 256 }) {
+        deferred_mode mode { { }, budget };
+        run("deferred " + std::to_string(budget) + std::string(8 - std::to_string(budget).size(), ' '), mode, depth, preload, ops, removes);
+    }
+
+    {
+        background_mode mode;
+        run("background       ", mode, depth, preload, ops, removes);
+    }
+
+    return 0;
+}
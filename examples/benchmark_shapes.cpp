@@ -0,0 +1,173 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include <hckt/shaped_tree.hpp>
+
+struct point
+{
+    std::uint64_t x, y, z;
+};
+
+typedef std::integral_constant<unsigned, 2> dim_2d;
+typedef std::integral_constant<unsigned, 3> dim_3d;
+
+template <typename Tree>
+void put(Tree & t, const point & p, const std::uint32_t value, const unsigned depth, dim_2d)
+{
+    t.insert(p.x, p.y, value, depth);
+}
+
+template <typename Tree>
+void put(Tree & t, const point & p, const std::uint32_t value, const unsigned depth, dim_3d)
+{
+    t.insert(p.x, p.y, p.z, value, depth);
+}
+
+template <typename Tree>
+const std::uint32_t * get(const Tree & t, const point & p, const unsigned depth, dim_2d)
+{
+    return t.find(p.x, p.y, depth);
+}
+
+template <typename Tree>
+const std::uint32_t * get(const Tree & t, const point & p, const unsigned depth, dim_3d)
+{
+    return t.find(p.x, p.y, p.z, depth);
+}
+
+/*
+ * same cells for every shape, depth is picked so a tree resolves bits
+ * bits of every coordinate
+ */
+template <typename Shape>
+void run(const std::vector<point> & points, const std::vector<point> & queries, const unsigned bits)
+{
+    typedef std::integral_constant<unsigned, Shape::dim> dim;
+
+    const unsigned depth { bits / Shape::axis_bits };
+    hckt::shaped_tree<std::uint32_t, Shape> t;
+
+    auto istart = std::chrono::steady_clock::now();
+
+    for(std::size_t i=0; i<points.size(); ++i) {
+        put(t, points[i], static_cast<std::uint32_t>(i), depth, dim { });
+    }
+
+    auto iend = std::chrono::steady_clock::now();
+
+    std::uint64_t sum { 0 };
+
+    auto lstart = std::chrono::steady_clock::now();
+
+    for(const point & p : queries) {
+        const std::uint32_t * v { get(t, p, depth, dim { }) };
+        sum += v == nullptr ? 0 : *v;
+    }
+
+    auto lend = std::chrono::steady_clock::now();
+
+    const std::size_t memsize { t.calculate_memory_size() };
+
+    std::cout << Shape::fanout << "-ary, " << depth << " levels" << std::endl;
+    std::cout << "insert:    " << std::chrono::duration<double, std::nano>(iend - istart).count() / points.size() << " ns" << std::endl;
+    std::cout << "lookup:    " << std::chrono::duration<double, std::nano>(lend - lstart).count() / queries.size() << " ns (sum " << sum << ")" << std::endl;
+    std::cout << "nodes:     " << hckt::render_number(t.calculate_node_amnt()) << std::endl;
+    std::cout << "total:     " << hckt::render_size(memsize) << std::endl;
+    std::cout << "per-val:   " << static_cast<double>(memsize) / points.size() << " B" << std::endl << std::endl;
+}
+
+std::vector<point> dense(const std::uint64_t edge, const bool three)
+{
+    std::vector<point> points;
+
+    for(std::uint64_t z=0; z<(three ? edge : 1); ++z) {
+        for(std::uint64_t y=0; y<edge; ++y) {
+            for(std::uint64_t x=0; x<edge; ++x) {
+                points.push_back(point { x, y, z });
+            }
+        }
+    }
+
+    return points;
+}
+
+std::vector<point> sparse(const std::size_t amount, const unsigned bits, std::mt19937_64 & rng)
+{
+    const std::uint64_t side { 1ULL << bits };
+    std::vector<point> points;
+
+    for(std::size_t i=0; i<amount; ++i) {
+        points.push_back(point { rng() % side, rng() % side, rng() % side });
+    }
+
+    return points;
+}
+
+std::vector<point> sample(const std::vector<point> & points, const std::size_t amount, std::mt19937_64 & rng)
+{
+    std::vector<point> queries;
+
+    for(std::size_t i=0; i<amount; ++i) {
+        queries.push_back(points[rng() % points.size()]);
+    }
+
+    return queries;
+}
+
+int main(int argc, char ** argv)
+{
+    const std::size_t amount  { argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000 };
+    const std::size_t queries { argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000000 };
+
+    //12 bits is a whole number of levels for 1, 2, 3 and 4 bits per level
+    const unsigned bits { 12 };
+
+    std::mt19937_64 rng { 1 };
+
+    {
+        const std::vector<point> points (dense(128, true));
+        const std::vector<point> q      (sample(points, queries, rng));
+
+        std::cout << "3D DENSE, 128^3 CELLS" << std::endl << std::endl;
+        run<hckt::shape<3, 1>>(points, q, bits);
+        run<hckt::shape_3d>(points, q, bits);
+        run<hckt::shape_3d_512>(points, q, bits);
+    }
+
+    {
+        const std::vector<point> points (sparse(amount, bits, rng));
+        const std::vector<point> q      (sample(points, queries, rng));
+
+        std::cout << "3D SPARSE, " << hckt::render_number(amount) << " RANDOM CELLS" << std::endl << std::endl;
+        run<hckt::shape<3, 1>>(points, q, bits);
+        run<hckt::shape_3d>(points, q, bits);
+        run<hckt::shape_3d_512>(points, q, bits);
+    }
+
+    {
+        const std::vector<point> points (dense(1024, false));
+        const std::vector<point> q      (sample(points, queries, rng));
+
+        std::cout << "2D DENSE, 1024^2 CELLS" << std::endl << std::endl;
+        run<hckt::shape<2, 2>>(points, q, bits);
+        run<hckt::shape_2d>(points, q, bits);
+        run<hckt::shape_2d_256>(points, q, bits);
+    }
+
+    {
+        const std::vector<point> points (sparse(amount, bits, rng));
+        const std::vector<point> q      (sample(points, queries, rng));
+
+        std::cout << "2D SPARSE, " << hckt::render_number(amount) << " RANDOM CELLS" << std::endl << std::endl;
+        run<hckt::shape<2, 2>>(points, q, bits);
+        run<hckt::shape_2d>(points, q, bits);
+        run<hckt::shape_2d_256>(points, q, bits);
+    }
+
+    return 0;
+}
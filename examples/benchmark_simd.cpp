@@ -0,0 +1,100 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/simd.hpp>
+
+/*
+ * many queries landing on the same node: ranks, membership and values
+ * for a batch of positions, per call versus the batch kernels
+ */
+template <typename T>
+void run(const char * name, const size_t rounds)
+{
+    std::mt19937_64 rng { 1 };
+    hckt::tree<T> m;
+
+    for(unsigned pos=0; pos<64; ++pos) {
+        if(rng() % 4 == 0) {
+            continue;
+        }
+
+        if(rng() % 2) {
+            m.insert(pos, static_cast<T>(rng()));
+        } else {
+            m.insert_leaf(pos, static_cast<T>(rng()));
+        }
+    }
+
+    std::vector<std::uint32_t> any_positions(256);
+    std::vector<std::uint32_t> set_positions;
+
+    for(std::uint32_t & p : any_positions) {
+        p = rng() % 64;
+
+        if(m.is_set(p)) {
+            set_positions.push_back(p);
+        }
+    }
+
+    std::vector<std::uint32_t> ranks(any_positions.size());
+    std::vector<std::uint8_t>  flags(any_positions.size());
+    std::vector<T>             values(set_positions.size());
+    std::uint64_t sink { 0 };
+
+    auto time = [&](const char * what, const size_t per_round, void (*body)(const hckt::tree<T> &, const std::vector<std::uint32_t> &, const std::vector<std::uint32_t> &, std::vector<std::uint32_t> &, std::vector<std::uint8_t> &, std::vector<T> &)) {
+        auto start = std::chrono::steady_clock::now();
+
+        for(size_t r=0; r<rounds; ++r) {
+            body(m, any_positions, set_positions, ranks, flags, values);
+            sink += ranks[r % ranks.size()] + flags[r % flags.size()] + static_cast<std::uint64_t>(values[r % values.size()]);
+        }
+
+        auto end = std::chrono::steady_clock::now();
+        std::cout << name << " " << what << std::chrono::duration<double, std::nano>(end - start).count() / (rounds * per_round) << " ns/position" << std::endl;
+    };
+
+    time("rank   scalar: ", any_positions.size(), [](const hckt::tree<T> & t, const std::vector<std::uint32_t> & p, const std::vector<std::uint32_t> &, std::vector<std::uint32_t> & r, std::vector<std::uint8_t> &, std::vector<T> &) {
+        for(size_t i=0; i<p.size(); ++i) {
+            r[i] = t.get_children_position(p[i]);
+        }
+    });
+    time("rank   batch:  ", any_positions.size(), [](const hckt::tree<T> & t, const std::vector<std::uint32_t> & p, const std::vector<std::uint32_t> &, std::vector<std::uint32_t> & r, std::vector<std::uint8_t> &, std::vector<T> &) {
+        t.get_children_positions(p.data(), p.size(), r.data());
+    });
+    time("test   scalar: ", any_positions.size(), [](const hckt::tree<T> & t, const std::vector<std::uint32_t> & p, const std::vector<std::uint32_t> &, std::vector<std::uint32_t> &, std::vector<std::uint8_t> & f, std::vector<T> &) {
+        for(size_t i=0; i<p.size(); ++i) {
+            f[i] = t.is_set(p[i]);
+        }
+    });
+    time("test   batch:  ", any_positions.size(), [](const hckt::tree<T> & t, const std::vector<std::uint32_t> & p, const std::vector<std::uint32_t> &, std::vector<std::uint32_t> &, std::vector<std::uint8_t> & f, std::vector<T> &) {
+        t.are_set(p.data(), p.size(), f.data());
+    });
+    time("gather scalar: ", set_positions.size(), [](const hckt::tree<T> & t, const std::vector<std::uint32_t> &, const std::vector<std::uint32_t> & p, std::vector<std::uint32_t> &, std::vector<std::uint8_t> &, std::vector<T> & v) {
+        for(size_t i=0; i<p.size(); ++i) {
+            v[i] = t.get_value(p[i]);
+        }
+    });
+    time("gather batch:  ", set_positions.size(), [](const hckt::tree<T> & t, const std::vector<std::uint32_t> &, const std::vector<std::uint32_t> & p, std::vector<std::uint32_t> &, std::vector<std::uint8_t> &, std::vector<T> & v) {
+        t.get_values(p.data(), p.size(), v.data());
+    });
+
+    std::cout << name << " (sink " << sink << ")" << std::endl << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+    const size_t rounds = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200000;
+
+    std::cout << "AVX2 " << (hckt::simd::has_avx2() ? "available" : "not available") << std::endl << std::endl;
+
+    run<std::uint32_t>("uint32_t", rounds);
+    run<std::uint64_t>("uint64_t", rounds);
+    run<short>("short   ", rounds);
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <hckt/tree.hpp>
+#include <hckt/bulk_load.hpp>
+#include <hckt/persistent_tree.hpp>
+
+struct snapshot_tag;
+typedef hckt::basic_pool_allocator<snapshot_tag> alloc_type;
+typedef hckt::persistent_tree<std::uint32_t, alloc_type> tree_type;
+
+int main(int argc, char ** argv)
+{
+    const size_t   amount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000000;
+    const unsigned depth  = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 6;
+
+    std::mt19937_64 rng { 1 };
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> points;
+    const std::uint64_t side { std::uint64_t { 1 } << (3 * depth) };
+
+    for(size_t i=0; i<amount; ++i) {
+        points.emplace_back(hckt::morton::encode_2d(rng() % side, rng() % side), i);
+    }
+
+    hckt::tree<std::uint32_t> source;
+    hckt::bulk_load(source, points, depth);
+
+    auto cstart = std::chrono::steady_clock::now();
+    tree_type t { source };
+    auto cend = std::chrono::steady_clock::now();
+
+    const std::size_t base { alloc_type::stats().in_use };
+
+    std::cout << "POINTS " << hckt::render_number(amount) << " DEPTH " << depth << std::endl;
+    std::cout << "tree:      " << hckt::render_size(base) << std::endl;
+    std::cout << "copytime:  " << std::chrono::duration<double, std::milli>(cend - cstart).count() << " ms (full copy)" << std::endl;
+
+    std::vector<tree_type::snapshot_type> snapshots;
+
+    //a snapshot, then a batch of writes, repeated
+    for(std::size_t writes=1000; writes<=100000; writes *= 10) {
+        auto sstart = std::chrono::steady_clock::now();
+        snapshots.push_back(t.snapshot());
+        auto send = std::chrono::steady_clock::now();
+
+        const std::size_t before { alloc_type::stats().in_use };
+
+        auto wstart = std::chrono::steady_clock::now();
+
+        for(std::size_t i=0; i<writes; ++i) {
+            t.insert(rng() % side, rng() % side, i, depth);
+        }
+
+        auto wend = std::chrono::steady_clock::now();
+
+        const std::size_t grown { alloc_type::stats().in_use - before };
+
+        std::cout << std::endl;
+        std::cout << "WRITES " << hckt::render_number(writes) << std::endl;
+        std::cout << "snaptime:  " << std::chrono::duration<double, std::micro>(send - sstart).count() << " us" << std::endl;
+        std::cout << "writetime: " << std::chrono::duration<double, std::nano>(wend - wstart).count() / writes << " ns/write" << std::endl;
+        std::cout << "grown:     " << hckt::render_size(grown) << " (" << static_cast<double>(grown) / writes << " B/write)" << std::endl;
+    }
+
+    snapshots.clear();
+
+    std::cout << std::endl;
+    std::cout << "after dropping snapshots: " << hckt::render_size(alloc_type::stats().in_use) << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include <hckt/tree.hpp>
+#include <hckt/uniform.hpp>
+
+/*
+ * a solid sphere of material 1 inside a shell of material 2, the
+ * classic sparse voxel scene where whole nodes end up uniform
+ */
+std::uint32_t material(const std::int64_t x, const std::int64_t y, const std::int64_t z, const std::int64_t side)
+{
+    const std::int64_t c  { side / 2 };
+    const std::int64_t d2 { (x - c) * (x - c) + (y - c) * (y - c) + (z - c) * (z - c) };
+    const std::int64_t r  { side / 2 - 1 };
+
+    if(d2 < (r - 8) * (r - 8)) {
+        return 1;
+    }
+
+    return d2 < r * r ? 2 : 0;
+}
+
+template <typename Insert>
+double fill(const std::uint64_t side, const Insert & insert)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for(std::uint64_t x=0; x<side; ++x) {
+        for(std::uint64_t y=0; y<side; ++y) {
+            for(std::uint64_t z=0; z<side; ++z) {
+                const std::uint32_t m { material(x, y, z, side) };
+
+                if(m != 0) {
+                    insert(x, y, z, m);
+                }
+            }
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+std::size_t mismatches(const hckt::tree<std::uint32_t> & a, const hckt::tree<std::uint32_t> & b, const std::uint64_t side, const unsigned depth)
+{
+    std::mt19937_64 rng { 1 };
+    std::size_t bad { 0 };
+
+    for(size_t i=0; i<1000000; ++i) {
+        const std::uint64_t x { rng() % side };
+        const std::uint64_t y { rng() % side };
+        const std::uint64_t z { rng() % side };
+
+        const std::uint32_t * va { a.find(x, y, z, depth) };
+        const std::uint32_t * vb { b.find(x, y, z, depth) };
+
+        bad += (va == nullptr) != (vb == nullptr) || (va && *va != *vb);
+    }
+
+    return bad;
+}
+
+int main(int argc, char ** argv)
+{
+    const unsigned      depth { argc > 1 ? static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10)) : 4 };
+    const std::uint64_t side  { 1ULL << (2 * depth) };
+
+    std::cout << "SPHERE " << side << "^3 DEPTH " << depth << std::endl << std::endl;
+
+    hckt::tree<std::uint32_t> plain;
+    const double plaintime = fill(side, [&](std::uint64_t x, std::uint64_t y, std::uint64_t z, std::uint32_t m) {
+        plain.insert(x, y, z, m, depth);
+    });
+
+    std::cout << "insert" << std::endl;
+    plain.mem_usage_info();
+    std::cout << "filltime:  " << plaintime << " ms" << std::endl << std::endl;
+
+    hckt::tree<std::uint32_t> merged;
+    const double mergedtime = fill(side, [&](std::uint64_t x, std::uint64_t y, std::uint64_t z, std::uint32_t m) {
+        hckt::uniform_insert(merged, x, y, z, m, depth);
+    });
+
+    std::cout << "uniform_insert" << std::endl;
+    merged.mem_usage_info();
+    std::cout << "filltime:  " << mergedtime << " ms" << std::endl;
+    std::cout << "mismatch:  " << mismatches(plain, merged, side, depth) << std::endl << std::endl;
+
+    auto mstart = std::chrono::steady_clock::now();
+    const std::size_t changed { hckt::merge_uniform(plain) };
+    auto mend = std::chrono::steady_clock::now();
+
+    std::cout << "insert + merge_uniform" << std::endl;
+    plain.mem_usage_info();
+    std::cout << "merged:    " << hckt::render_number(changed) << " nodes" << std::endl;
+    std::cout << "mergetime: " << std::chrono::duration<double, std::milli>(mend - mstart).count() << " ms" << std::endl;
+    std::cout << "mismatch:  " << mismatches(plain, merged, side, depth) << std::endl << std::endl;
+
+    //carve an unaligned box out of the core, the merged regions on its border split again
+    const std::uint64_t lo { side / 4 + 1 };
+    const std::uint64_t hi { side / 2 + 1 };
+
+    auto estart = std::chrono::steady_clock::now();
+
+    for(std::uint64_t x=lo; x<hi; ++x) {
+        for(std::uint64_t y=lo; y<hi; ++y) {
+            for(std::uint64_t z=lo; z<hi; ++z) {
+                hckt::uniform_erase(merged, x, y, z, depth);
+            }
+        }
+    }
+
+    auto eend = std::chrono::steady_clock::now();
+
+    std::cout << "uniform_erase of a " << (hi - lo) << "^3 box" << std::endl;
+    merged.mem_usage_info();
+    std::cout << "erasetime: " << std::chrono::duration<double, std::milli>(eend - estart).count() << " ms" << std::endl;
+
+    return 0;
+}
@@ -1,28 +1,24 @@
 #include <hckt/util.hpp>
 
+/*
+ * fills every position of a node and continues below position 0,
+ * iterative since depth goes into the thousands
+ */
 template <typename Tree>
-void recursive_populate(Tree * m, const int depth, const int max_depth)
+void populate(Tree & m, const int depth)
 {
-    if(depth >= max_depth) {
-        return;
-    }
-
-    for(size_t a=0; a<4; ++a) {
-        for(size_t b=0; b<4; ++b) {
-            for(size_t c=0; c<4; ++c) {
-                const auto pos = hckt::get_position_2d(a, b, c);
-                m->insert(pos, 8 + rand() % 8);
+    Tree * node = &m;
 
-                if(pos == 0) {
-                    recursive_populate(m->child(pos), depth + 1, max_depth);
+    for(int level=0; level<depth; ++level) {
+        for(size_t a=0; a<4; ++a) {
+            for(size_t b=0; b<4; ++b) {
+                for(size_t c=0; c<4; ++c) {
+                    const auto pos = hckt::get_position_2d(a, b, c);
+                    node->insert(pos, 8 + rand() % 8);
                 }
             }
         }
-    }
-}
 
-template <typename Tree>
-void populate(Tree & m, const int depth)
-{
-    recursive_populate(&m, 0, depth);
+        node = node->child(0);
+    }
 }
@@ -1,40 +1,62 @@
 #include <SFML/Window.hpp>
 #include <SFML/Graphics.hpp>
 #include <SFML/System.hpp>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <hckt/morton.hpp>
+#include <hckt/traversal.hpp>
 #include <hckt/util.hpp>
 
+/*
+ * draw every set position of the nodes that are on screen and at least a
+ * pixel large, rsize is the size of a root position
+ * nodes are visited through an explicit stack, so deep trees are fine
+ */
 template <typename Tree>
-void recursive_render(sf::RenderWindow & window, Tree * m, const double rsize, const float offset_x, const float offset_y)
+void render_tree(sf::RenderWindow & window, const Tree & m, const double rsize)
 {
-    if(offset_x > window_width || offset_y > window_height) {
-        return;
-    }
+    std::vector<double> origin_x; //origin of the current node on each level
+    std::vector<double> origin_y;
 
-    if(! m->has_children()) {
-        return;
-    }
+    for(auto it = hckt::preorder(m).begin(), end = hckt::preorder(m).end(); it != end; ++it) {
+        const unsigned level { it.level() };
+        const double   size  { rsize / std::pow(8.0, level) };
 
-    if(rsize < 1) {
-        return;
-    }
+        origin_x.resize(level + 1);
+        origin_y.resize(level + 1);
 
-    for(size_t a=0; a<4; ++a) {
-        for(size_t b=0; b<4; ++b) {
-            for(size_t c=0; c<4; ++c) {
-                const auto pos   = hckt::get_position_2d(a, b, c);
-                const auto ox    = offset_x + (rsize * hckt::get_x_2d(a, b, c));
-                const auto oy    = offset_y + (rsize * hckt::get_y_2d(a, b, c));
-                const sf::Uint8 col = m->get_value(pos) * (255 / (4 * 4 * 4));
-
-                if(rsize < window_width) {
-                    sf::RectangleShape square { sf::Vector2f { static_cast<float>(rsize), static_cast<float>(rsize) } };
-                    square.setFillColor(sf::Color { col, col, col, 255 } );
-                    square.setPosition(ox, oy);
-                    window.draw(square);
-                }
-
-                recursive_render(window, m->child(pos), rsize / 8.0f, ox, oy);
-            }
+        if(level == 0) {
+            origin_x[0] = 0;
+            origin_y[0] = 0;
+        } else {
+            std::uint64_t lx, ly;
+            hckt::morton::decode_2d(it.position(), lx, ly);
+
+            origin_x[level] = origin_x[level - 1] + (size * 8 * lx);
+            origin_y[level] = origin_y[level - 1] + (size * 8 * ly);
+        }
+
+        if(origin_x[level] > window_width || origin_y[level] > window_height || size < 1) {
+            it.skip_children();
+            continue;
+        }
+
+        if(size >= window_width) {
+            continue;
+        }
+
+        for(std::uint64_t set = it->set_mask(); set != 0; set &= set - 1) {
+            const unsigned pos = __builtin_ctzll(set);
+            std::uint64_t lx, ly;
+            hckt::morton::decode_2d(pos, lx, ly);
+
+            const sf::Uint8 col = it->get_value(pos) * (255 / (4 * 4 * 4));
+
+            sf::RectangleShape square { sf::Vector2f { static_cast<float>(size), static_cast<float>(size) } };
+            square.setFillColor(sf::Color { col, col, col, 255 } );
+            square.setPosition(origin_x[level] + (size * lx), origin_y[level] + (size * ly));
+            window.draw(square);
         }
     }
 }
@@ -45,7 +67,7 @@ int zoom_render(sf::RenderWindow & window, const Tree & m, double speed)
     double rsize = 64;
 
     while(1) {
-        recursive_render(window, &m, rsize, 0, 0);
+        render_tree(window, m, rsize);
         rsize *= speed;
 
         sf::Event event;
@@ -72,7 +94,7 @@ int static_render(sf::RenderWindow & window, const Tree & m)
     double rsize = 64;
 
     while(1) {
-        recursive_render(window, &m, rsize, 0, 0);
+        render_tree(window, m, rsize);
 
         sf::Event event;
         while (window.pollEvent(event)) {
@@ -0,0 +1,450 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_AGGREGATE_H
+#define HCKT_AGGREGATE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include "morton.hpp"
+#include "range.hpp"
+#include "traversal.hpp"
+
+namespace hckt
+{
+
+/*
+ * per node aggregates for level of detail
+ *
+ * the value of every interior position is kept as the aggregate of the
+ * subtree below it, so the value of a region at a coarser resolution is
+ * a plain lookup at that depth and range aggregates stop at the nodes
+ * the range covers completely
+ *
+ * a Policy is a monoid over the value type of the tree:
+ *
+ *   identity()       neutral element
+ *   leaf(v)          what a leaf holding v contributes
+ *   combine(a, b)    associative
+ *
+ * a leaf above the deepest level counts once, whatever it covers
+ */
+template <typename T>
+struct sum_aggregate
+{
+    static T identity()                        { return T { }; }
+    static T leaf(const T & v)                 { return v; }
+    static T combine(const T & a, const T & b) { return a + b; }
+};
+
+template <typename T>
+struct min_aggregate
+{
+    static T identity()                        { return std::numeric_limits<T>::max(); }
+    static T leaf(const T & v)                 { return v; }
+    static T combine(const T & a, const T & b) { return std::min(a, b); }
+};
+
+template <typename T>
+struct max_aggregate
+{
+    static T identity()                        { return std::numeric_limits<T>::lowest(); }
+    static T leaf(const T & v)                 { return v; }
+    static T combine(const T & a, const T & b) { return std::max(a, b); }
+};
+
+/*
+ * interior positions hold the number of leaves below them
+ */
+template <typename T>
+struct count_aggregate
+{
+    static T identity()                        { return T { 0 }; }
+    static T leaf(const T &)                   { return T { 1 }; }
+    static T combine(const T & a, const T & b) { return a + b; }
+};
+
+/*
+ * value type for averages, a leaf is inserted as { v, 1 }
+ */
+template <typename T>
+struct mean
+{
+    T             sum;
+    std::uint64_t count;
+
+    T value() const
+    {
+        return count == 0 ? T { } : sum / static_cast<T>(count);
+    }
+
+    bool operator==(const mean & other) const
+    {
+        return sum == other.sum && count == other.count;
+    }
+};
+
+template <typename T>
+struct mean_aggregate
+{
+    static mean<T> identity()                              { return mean<T> { T { }, 0 }; }
+    static mean<T> leaf(const mean<T> & v)                 { return v; }
+    static mean<T> combine(const mean<T> & a, const mean<T> & b) { return mean<T> { a.sum + b.sum, a.count + b.count }; }
+};
+
+namespace detail
+{
+    /*
+     * contribution of one set position
+     */
+    template <typename Policy, typename Node>
+    auto position_aggregate(const Node & node, const unsigned pos) -> decltype(Policy::identity())
+    {
+        return node.is_leaf(pos) ? Policy::leaf(node.get_value(pos)) : node.get_value(pos);
+    }
+
+    /*
+     * origin is the lowest cell of node, shift the log2 of the cells one
+     * position covers, lo and hi the query box at full resolution
+     * positions the box covers completely are taken as they are, the
+     * ones it only cuts are entered
+     */
+    template <typename Policy, unsigned Dim, typename Node>
+    auto range_aggregate(const Node & node, const std::uint64_t * origin, const unsigned shift, const std::uint64_t * lo, const std::uint64_t * hi) -> decltype(Policy::identity())
+    {
+        constexpr unsigned axis_bits { 6 / Dim };
+        constexpr unsigned last      { (1u << axis_bits) - 1 };
+
+        auto result = Policy::identity();
+
+        unsigned l[Dim];
+        unsigned h[Dim];
+
+        if(! clip<Dim>(origin, shift, lo, hi, l, h)) {
+            return result;
+        }
+
+        const std::integral_constant<unsigned, Dim> dim { };
+        std::uint64_t hits { node.set_mask() & mask(dim, l, h) };
+
+        //positions whose cells all lie inside the box
+        unsigned il[Dim];
+        unsigned ih[Dim];
+        bool     inner { true };
+
+        for(unsigned d=0; d<Dim; ++d) {
+            const std::uint64_t span   { std::uint64_t { 1 } << shift };
+            const std::uint64_t bottom { lo[d] <= origin[d] ? 0 : (lo[d] - origin[d] + span - 1) >> shift };
+            const std::uint64_t top    { (hi[d] - origin[d] + 1) >> shift };
+
+            if(bottom > last || top == 0 || bottom > top - 1) {
+                inner = false;
+                break;
+            }
+
+            il[d] = static_cast<unsigned>(bottom);
+            ih[d] = top - 1 < last ? static_cast<unsigned>(top - 1) : last;
+        }
+
+        std::uint64_t covered { inner ? hits & mask(dim, il, ih) : 0 };
+
+        //cut leaves are hits like in for_each_in_rect, only cut nodes need a walk
+        covered |= hits & node.leaf_mask();
+        hits    &= ~covered;
+
+        for(; covered != 0; covered &= covered - 1) {
+            result = Policy::combine(result, position_aggregate<Policy>(node, __builtin_ctzll(covered)));
+        }
+
+        for(; hits != 0; hits &= hits - 1) {
+            const unsigned pos ( __builtin_ctzll(hits) );
+            std::uint64_t  cell[Dim];
+
+            position_cell<Dim>(pos, origin, shift, cell);
+            result = Policy::combine(result, range_aggregate<Policy, Dim>(*node.child(pos), cell, shift - axis_bits, lo, hi));
+        }
+
+        return result;
+    }
+};
+
+/*
+ * aggregate of all positions of node, for the root of a tree this is
+ * the aggregate of the whole tree
+ */
+template <typename Policy, typename Node>
+auto aggregate_of(const Node & node) -> decltype(Policy::identity())
+{
+    auto result = Policy::identity();
+
+    for(std::uint64_t set=node.set_mask(); set != 0; set &= set - 1) {
+        result = Policy::combine(result, detail::position_aggregate<Policy>(node, __builtin_ctzll(set)));
+    }
+
+    return result;
+}
+
+namespace detail
+{
+    /*
+     * after a write below (path[level - 1], positions[level - 1]) refold
+     * every interior position on the path, dropping emptied nodes
+     */
+    template <typename Policy, typename Tree>
+    void settle_aggregates(Tree * const * path, const unsigned * positions, unsigned level)
+    {
+        while(level-- > 0) {
+            Tree &         node = *path[level];
+            const unsigned pos { positions[level] };
+
+            if(! node.is_set(pos) || node.is_leaf(pos)) {
+                continue;
+            }
+
+            const Tree * c { node.child(pos) };
+
+            if(c->set_mask() == 0) {
+                node.remove(pos);
+            } else {
+                node.set_value(pos, aggregate_of<Policy>(*c));
+            }
+        }
+    }
+};
+
+/*
+ * set the value of a cell like tree::insert_path and bring the
+ * aggregates along the path up to date, one node fold per level
+ * a cell above the leaf depth that holds a subtree is replaced by a leaf
+ * with the value, its subtree is dropped, since an interior value is
+ * the aggregate of the cells below and cannot be set on its own
+ */
+template <typename Policy, typename Tree, typename Path, typename T>
+void aggregate_insert_path(Tree & root, Path & p, const T value)
+{
+    assert(! p.done());
+
+    Tree *   path[morton::max_depth_3d];
+    unsigned positions[morton::max_depth_3d];
+    unsigned level { 0 };
+    Tree *   node { &root };
+
+    while(true) {
+        const unsigned pos { p.next() };
+
+        path[level]      = node;
+        positions[level] = pos;
+        ++level;
+
+        if(p.done()) {
+            if(node->is_set(pos) && node->is_leaf(pos)) {
+                node->set_value(pos, value);
+            } else {
+                if(node->is_set(pos)) {
+                    node->remove(pos);
+                }
+
+                node->insert_leaf(pos, value);
+            }
+
+            break;
+        }
+
+        if(! node->is_set(pos)) {
+            node->insert(pos, Policy::identity());
+        } else if(node->is_leaf(pos)) {
+            node->remove(pos);
+            node->insert(pos, Policy::identity());
+        }
+
+        node = node->child(pos);
+    }
+
+    detail::settle_aggregates<Policy>(path, positions, level - 1);
+}
+
+/*
+ * remove the position find() would return, with its subtree, nodes left
+ * empty are dropped and the aggregates above brought up to date
+ * false if nothing was set there
+ */
+template <typename Policy, typename Tree, typename Path>
+bool aggregate_erase_path(Tree & root, Path & p)
+{
+    assert(! p.done());
+
+    Tree *   path[morton::max_depth_3d];
+    unsigned positions[morton::max_depth_3d];
+    unsigned level { 0 };
+    Tree *   node { &root };
+
+    while(true) {
+        const unsigned pos { p.next() };
+
+        if(! node->is_set(pos)) {
+            return false;
+        }
+
+        path[level]      = node;
+        positions[level] = pos;
+        ++level;
+
+        if(p.done() || node->is_leaf(pos)) {
+            node->remove(pos);
+            break;
+        }
+
+        node = node->child(pos);
+    }
+
+    detail::settle_aggregates<Policy>(path, positions, level - 1);
+
+    return true;
+}
+
+template <typename Policy, typename Tree, typename T>
+void aggregate_insert(Tree & root, const std::uint64_t x, const std::uint64_t y, const T value, const unsigned depth)
+{
+    morton::path<2> p { x, y, depth };
+    aggregate_insert_path<Policy>(root, p, value);
+}
+
+template <typename Policy, typename Tree, typename T>
+void aggregate_insert(Tree & root, const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const T value, const unsigned depth)
+{
+    morton::path<3> p { x, y, z, depth };
+    aggregate_insert_path<Policy>(root, p, value);
+}
+
+template <typename Policy, typename Tree>
+bool aggregate_erase(Tree & root, const std::uint64_t x, const std::uint64_t y, const unsigned depth)
+{
+    morton::path<2> p { x, y, depth };
+    return aggregate_erase_path<Policy>(root, p);
+}
+
+template <typename Policy, typename Tree>
+bool aggregate_erase(Tree & root, const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth)
+{
+    morton::path<3> p { x, y, z, depth };
+    return aggregate_erase_path<Policy>(root, p);
+}
+
+/*
+ * recompute every interior value bottom up, for trees built without
+ * the functions above, ie. by bulk_load
+ */
+template <typename Policy, typename Tree>
+void aggregate_rebuild(Tree & root)
+{
+    //children come first, their own values are final when a parent folds them
+    for(postorder_iterator<Tree> it { root }, end { }; it != end; ++it) {
+        Tree & node = *it;
+
+        for(std::uint64_t dist=node.chidist(); dist != 0; dist &= dist - 1) {
+            const unsigned pos ( __builtin_ctzll(dist) );
+
+            node.set_value(pos, aggregate_of<Policy>(*node.child(pos)));
+        }
+    }
+}
+
+/*
+ * aggregate of the region that the cell (x, y) at level covers, where
+ * level counts from the root like depth does, O(level)
+ */
+template <typename Policy, typename Node, typename Path>
+auto region_aggregate_path(const Node & root, Path & p) -> decltype(Policy::identity())
+{
+    assert(! p.done());
+
+    const Node * node { &root };
+
+    while(true) {
+        const unsigned pos { p.next() };
+
+        if(! node->is_set(pos)) {
+            return Policy::identity();
+        }
+
+        if(p.done() || node->is_leaf(pos)) {
+            return detail::position_aggregate<Policy>(*node, pos);
+        }
+
+        node = node->child(pos);
+    }
+}
+
+template <typename Policy, typename Node>
+auto region_aggregate(const Node & root, const std::uint64_t x, const std::uint64_t y, const unsigned level) -> decltype(Policy::identity())
+{
+    morton::path<2> p { x, y, level };
+    return region_aggregate_path<Policy>(root, p);
+}
+
+template <typename Policy, typename Node>
+auto region_aggregate(const Node & root, const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned level) -> decltype(Policy::identity())
+{
+    morton::path<3> p { x, y, z, level };
+    return region_aggregate_path<Policy>(root, p);
+}
+
+/*
+ * aggregate of the positions for_each_in_rect would visit, nodes inside
+ * the rectangle are not entered
+ */
+template <typename Policy, typename Node>
+auto rect_aggregate(const Node & root, const std::uint64_t x0, const std::uint64_t y0, const std::uint64_t x1, const std::uint64_t y1, const unsigned depth) -> decltype(Policy::identity())
+{
+    assert(depth > 0);
+    assert(depth <= morton::max_depth_2d);
+    assert(x0 <= x1 && y0 <= y1);
+
+    const std::uint64_t origin[2] { 0, 0 };
+    const std::uint64_t lo[2]     { x0, y0 };
+    const std::uint64_t hi[2]     { x1, y1 };
+
+    return detail::range_aggregate<Policy, 2>(root, origin, 3 * (depth - 1), lo, hi);
+}
+
+template <typename Policy, typename Node>
+auto box_aggregate(const Node & root, const std::uint64_t x0, const std::uint64_t y0, const std::uint64_t z0, const std::uint64_t x1, const std::uint64_t y1, const std::uint64_t z1, const unsigned depth) -> decltype(Policy::identity())
+{
+    assert(depth > 0);
+    assert(depth <= morton::max_depth_3d);
+    assert(x0 <= x1 && y0 <= y1 && z0 <= z1);
+
+    const std::uint64_t origin[3] { 0, 0, 0 };
+    const std::uint64_t lo[3]     { x0, y0, z0 };
+    const std::uint64_t hi[3]     { x1, y1, z1 };
+
+    return detail::range_aggregate<Policy, 3>(root, origin, 2 * (depth - 1), lo, hi);
+}
+
+};
+
+#endif
@@ -0,0 +1,995 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_ALLOCATOR_H
+#define HCKT_ALLOCATOR_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <sys/mman.h>
+
+namespace hckt
+{
+
+/*
+ * allocator policies
+ *
+ * a policy is a stateless type exposing:
+ *   static void * allocate(std::size_t bytes);
+ *   static void   deallocate(void * p, std::size_t bytes);
+ *   static void   release();
+ *   static alloc_stats stats();
+ *
+ * deallocate is always called with the same size that was allocated,
+ * so policies do not need to keep per-block headers
+ */
+
+struct alloc_stats
+{
+    std::size_t chunks;    //number of large chunks requested from the system
+    std::size_t reserved;  //bytes held in chunks
+    std::size_t in_use;    //bytes handed out and not yet returned
+    std::size_t free;      //bytes sitting in free lists
+    std::size_t untouched; //bytes at the end of the current chunk never handed out
+
+    /*
+     * share of carved memory that is free but not reusable by
+     * requests of another size class
+     */
+    double fragmentation() const
+    {
+        const std::size_t carved { reserved - untouched };
+
+        return carved == 0 ? 0.0 : static_cast<double>(free) / carved;
+    }
+};
+
+/*
+ * plain operator new / delete, one call per block
+ */
+struct heap_allocator
+{
+    static void * allocate(const std::size_t bytes)
+    {
+        return ::operator new(bytes);
+    }
+
+    static void deallocate(void * p, const std::size_t)
+    {
+        ::operator delete(p);
+    }
+
+    static void release()
+    {
+    }
+
+    static alloc_stats stats()
+    {
+        return alloc_stats { 0, 0, 0, 0, 0 };
+    }
+};
+
+namespace detail
+{
+
+/*
+ * chunks and free lists behind the pool allocators
+ * blocks are carved from large chunks and recycled through one free list
+ * per 8 byte size class, requests above max_block go to operator new,
+ * behind a small header linking them if keep_large is set so drop()
+ * frees them as well
+ *
+ * one thread uses a slab at a time, the counters are atomic only so
+ * stats() can sum them up from another one
+ */
+class slab
+{
+public:
+    static constexpr std::size_t granularity { 8 };
+    static constexpr std::size_t max_block   { 1024 };
+    static constexpr std::size_t chunk_size  { 1 << 20 };
+
+private:
+    static constexpr std::size_t class_amnt  { max_block / granularity };
+
+    struct free_block
+    {
+        free_block * next;
+    };
+
+    struct alignas(16) large_block
+    {
+        large_block * prev;
+        large_block * next;
+    };
+
+    std::vector<char*>       chunks;
+    free_block *             free_lists[class_amnt];
+    large_block *            large; //blocks above max_block, if kept
+    char *                   cursor;
+    char *                   end;
+    bool                     bump; //ignore the free lists
+    const bool               keep_large;
+    std::atomic<std::size_t> chunk_amnt;
+    std::atomic<std::size_t> carved;
+    std::atomic<std::size_t> in_use;
+    std::atomic<std::size_t> free;
+
+    static std::size_t round_up(const std::size_t bytes)
+    {
+        return (bytes + granularity - 1) & ~(granularity - 1);
+    }
+
+    static unsigned size_class(const std::size_t rounded)
+    {
+        return rounded / granularity - 1;
+    }
+
+    //only the owning thread writes, so no read-modify-write is needed
+    static void add(std::atomic<std::size_t> & c, const std::size_t n)
+    {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static void sub(std::atomic<std::size_t> & c, const std::size_t n)
+    {
+        c.store(c.load(std::memory_order_relaxed) - n, std::memory_order_relaxed);
+    }
+
+    void * allocate_large(const std::size_t bytes)
+    {
+        if(! keep_large) {
+            return ::operator new(bytes);
+        }
+
+        large_block * const b { static_cast<large_block*>(::operator new(sizeof(large_block) + bytes)) };
+
+        b->prev = nullptr;
+        b->next = large;
+
+        if(large != nullptr) {
+            large->prev = b;
+        }
+
+        large = b;
+        return b + 1;
+    }
+
+    void deallocate_large(void * ptr)
+    {
+        if(! keep_large) {
+            ::operator delete(ptr);
+            return;
+        }
+
+        large_block * const b { static_cast<large_block*>(ptr) - 1 };
+
+        if(b->prev != nullptr) {
+            b->prev->next = b->next;
+        } else {
+            large = b->next;
+        }
+
+        if(b->next != nullptr) {
+            b->next->prev = b->prev;
+        }
+
+        ::operator delete(b);
+    }
+
+public:
+    explicit slab(const bool keep_large) : chunks     { }
+                                         , free_lists { }
+                                         , large      { nullptr }
+                                         , cursor     { nullptr }
+                                         , end        { nullptr }
+                                         , bump       { false }
+                                         , keep_large { keep_large }
+                                         , chunk_amnt { 0 }
+                                         , carved     { 0 }
+                                         , in_use     { 0 }
+                                         , free       { 0 }
+    {
+    }
+
+    slab(const slab &) = delete;
+    slab & operator=(const slab &) = delete;
+
+    void * allocate(const std::size_t bytes)
+    {
+        assert(bytes > 0);
+
+        const std::size_t rounded { round_up(bytes) };
+
+        if(rounded > max_block) {
+            return allocate_large(bytes);
+        }
+
+        free_block *& head = free_lists[size_class(rounded)];
+
+        add(in_use, rounded);
+
+        if(head != nullptr && ! bump) {
+            free_block * b { head };
+            head = b->next;
+            sub(free, rounded);
+            return b;
+        }
+
+        if(cursor == nullptr || static_cast<std::size_t>(end - cursor) < rounded) {
+            char * c { static_cast<char*>(::operator new(chunk_size)) };
+            chunks.push_back(c);
+            cursor = c;
+            end    = c + chunk_size;
+            add(chunk_amnt, 1);
+            carved.store(chunk_amnt.load(std::memory_order_relaxed) * chunk_size - chunk_size, std::memory_order_relaxed);
+        }
+
+        void * b { cursor };
+        cursor += rounded;
+        add(carved, rounded);
+        return b;
+    }
+
+    void deallocate(void * ptr, const std::size_t bytes)
+    {
+        assert(ptr != nullptr);
+
+        const std::size_t rounded { round_up(bytes) };
+
+        if(rounded > max_block) {
+            deallocate_large(ptr);
+            return;
+        }
+
+        free_block *& head = free_lists[size_class(rounded)];
+        free_block * b { static_cast<free_block*>(ptr) };
+
+        b->next = head;
+        head = b;
+
+        sub(in_use, rounded);
+        add(free, rounded);
+    }
+
+    bool bump_only(const bool on)
+    {
+        const bool was { bump };
+
+        bump = on;
+        return was;
+    }
+
+    /*
+     * return every chunk and kept large block to the system
+     */
+    void drop()
+    {
+        for(char * c : chunks) {
+            ::operator delete(c);
+        }
+
+        chunks.clear();
+
+        while(large != nullptr) {
+            large_block * const b { large };
+            large = b->next;
+            ::operator delete(b);
+        }
+
+        for(unsigned i=0; i<class_amnt; ++i) {
+            free_lists[i] = nullptr;
+        }
+
+        cursor = nullptr;
+        end    = nullptr;
+        chunk_amnt.store(0, std::memory_order_relaxed);
+        carved.store(0, std::memory_order_relaxed);
+        in_use.store(0, std::memory_order_relaxed);
+        free.store(0, std::memory_order_relaxed);
+    }
+
+    /*
+     * adds this slab's counters to s, they are modular so a block freed
+     * into another slab than the one it came from still sums up right
+     */
+    void add_stats(alloc_stats & s) const
+    {
+        const std::size_t amnt { chunk_amnt.load(std::memory_order_relaxed) };
+
+        s.chunks    += amnt;
+        s.reserved  += amnt * chunk_size;
+        s.in_use    += in_use.load(std::memory_order_relaxed);
+        s.free      += free.load(std::memory_order_relaxed);
+        s.untouched += amnt * chunk_size - carved.load(std::memory_order_relaxed);
+    }
+};
+
+constexpr std::size_t slab::granularity;
+constexpr std::size_t slab::max_block;
+constexpr std::size_t slab::chunk_size;
+
+};
+
+/*
+ * slab allocator with one pool per tag, see detail::slab
+ *
+ * a tree with a private tag can drop all of its memory at once with
+ * release() instead of visiting every node
+ *
+ * the pool is never destroyed, so trees with static storage duration
+ * can still free their nodes at exit
+ * not thread safe: meant for one owner, wrap it in locked_allocator to
+ * share it between threads
+ */
+template <typename Tag = void>
+class basic_pool_allocator
+{
+public:
+    static constexpr std::size_t granularity { detail::slab::granularity };
+    static constexpr std::size_t max_block   { detail::slab::max_block };
+    static constexpr std::size_t chunk_size  { detail::slab::chunk_size };
+
+private:
+    static detail::slab & instance()
+    {
+        static detail::slab & s = *new detail::slab(true);
+        return s;
+    }
+
+public:
+    static void * allocate(const std::size_t bytes)
+    {
+        return instance().allocate(bytes);
+    }
+
+    static void deallocate(void * ptr, const std::size_t bytes)
+    {
+        instance().deallocate(ptr, bytes);
+    }
+
+    /*
+     * while on, allocate() carves every block from the current chunk
+     * instead of reusing freed ones, so consecutive requests end up next
+     * to each other, see fresh_memory
+     * returns the previous setting
+     */
+    static bool bump_only(const bool on)
+    {
+        return instance().bump_only(on);
+    }
+
+    /*
+     * return every chunk and large block to the system in O(chunks)
+     * all blocks handed out by this pool become invalid
+     */
+    static void release()
+    {
+        instance().drop();
+    }
+
+    static alloc_stats stats()
+    {
+        alloc_stats s { 0, 0, 0, 0, 0 };
+
+        instance().add_stats(s);
+        return s;
+    }
+};
+
+template <typename Tag>
+constexpr std::size_t basic_pool_allocator<Tag>::granularity;
+
+template <typename Tag>
+constexpr std::size_t basic_pool_allocator<Tag>::max_block;
+
+template <typename Tag>
+constexpr std::size_t basic_pool_allocator<Tag>::chunk_size;
+
+/*
+ * slab allocator with one pool per thread, see detail::slab
+ * the default of tree and friends: trees built on different threads
+ * never share a pool, so they stay as independent as with operator new
+ *
+ * a block may be freed on another thread than the one it came from, it
+ * then joins the free lists of the freeing thread, which is why chunks
+ * are never returned: release() does nothing
+ * when a thread exits its pool is handed to the next thread that starts
+ * allocating, so threads coming and going do not pile up pools
+ */
+class local_pool_allocator
+{
+    struct registry
+    {
+        std::mutex                 lock;
+        std::vector<detail::slab*> all;
+        std::vector<detail::slab*> idle; //pools of threads that exited
+
+        registry() : lock { }
+                   , all  { }
+                   , idle { }
+        {
+        }
+    };
+
+    //gives the pool of the thread back when it exits
+    struct reaper
+    {
+        reaper()
+        {
+        }
+
+        ~reaper();
+
+        reaper(const reaper &) = delete;
+        reaper & operator=(const reaper &) = delete;
+    };
+
+    //never destroyed, trees with static storage duration outlive it otherwise
+    static registry & shared()
+    {
+        static registry & r = *new registry;
+        return r;
+    }
+
+    static detail::slab *& mine()
+    {
+        static thread_local detail::slab * s { nullptr };
+        return s;
+    }
+
+    static bool & exited()
+    {
+        static thread_local bool e { false };
+        return e;
+    }
+
+    static detail::slab * adopt()
+    {
+        registry & r = shared();
+        detail::slab * s;
+
+        {
+            std::lock_guard<std::mutex> guard { r.lock };
+
+            if(r.idle.empty()) {
+                s = new detail::slab(false);
+                r.all.push_back(s);
+            } else {
+                s = r.idle.back();
+                r.idle.pop_back();
+            }
+        }
+
+        //after thread_local destructors ran the pool is simply kept
+        if(! exited()) {
+            static thread_local reaper keep;
+            (void) keep;
+        }
+
+        return s;
+    }
+
+    static detail::slab & instance()
+    {
+        detail::slab *& s = mine();
+
+        if(s == nullptr) {
+            s = adopt();
+        }
+
+        return *s;
+    }
+
+public:
+    static constexpr std::size_t granularity { detail::slab::granularity };
+    static constexpr std::size_t max_block   { detail::slab::max_block };
+    static constexpr std::size_t chunk_size  { detail::slab::chunk_size };
+
+    static void * allocate(const std::size_t bytes)
+    {
+        return instance().allocate(bytes);
+    }
+
+    static void deallocate(void * ptr, const std::size_t bytes)
+    {
+        instance().deallocate(ptr, bytes);
+    }
+
+    /*
+     * as basic_pool_allocator::bump_only, for the pool of this thread
+     */
+    static bool bump_only(const bool on)
+    {
+        return instance().bump_only(on);
+    }
+
+    static void release()
+    {
+    }
+
+    /*
+     * summed over the pools of all threads
+     */
+    static alloc_stats stats()
+    {
+        registry & r = shared();
+        alloc_stats s { 0, 0, 0, 0, 0 };
+        std::lock_guard<std::mutex> guard { r.lock };
+
+        for(const detail::slab * p : r.all) {
+            p->add_stats(s);
+        }
+
+        return s;
+    }
+};
+
+inline local_pool_allocator::reaper::~reaper()
+{
+    registry & r = shared();
+    detail::slab *& s = mine();
+
+    exited() = true;
+
+    if(s != nullptr) {
+        std::lock_guard<std::mutex> guard { r.lock };
+        r.idle.push_back(s);
+        s = nullptr;
+    }
+}
+
+typedef local_pool_allocator pool_allocator;
+
+/*
+ * allocator carving every block out of one contiguous reservation, so a
+ * block can be named by a 32 bit index of 8 byte words from its start
+ * instead of a pointer, see packed_tree.hpp
+ *
+ * Reserve bytes of address space are reserved with mmap up front and
+ * made accessible commit_step bytes at a time as the arena fills up, the
+ * range never moves, so pointers into it stay valid
+ * the reservation itself is PROT_NONE and not charged against the commit
+ * limit, so it works with vm.overcommit_memory=2, but it does count
+ * towards ulimit -v: pick Reserve below that limit, at most 32 GiB since
+ * indices are 32 bit counts of 8 byte words
+ * the first 16 bytes are never handed out and always read as zero, so
+ * index 0 can stand for an empty block, and at least granularity bytes
+ * after every block are readable
+ *
+ * size classes and free lists as in basic_pool_allocator, requests above
+ * max_block or beyond the reservation throw std::bad_alloc since they
+ * cannot be served from outside the arena
+ * not thread safe, wrap it in locked_allocator to share it
+ */
+template <typename Tag = void, std::size_t Reserve = (std::size_t { 1 } << 30)>
+class basic_arena_allocator
+{
+public:
+    static constexpr std::size_t granularity { 8 };
+    static constexpr std::size_t max_block   { 1024 };
+    static constexpr std::size_t max_size    { Reserve };
+    static constexpr std::size_t commit_step { 1 << 20 };
+
+    static_assert(Reserve % commit_step == 0, "the reservation is committed in whole steps");
+    static_assert(Reserve <= (granularity << 32), "blocks are addressed by 32 bit word indices");
+
+private:
+    static constexpr std::size_t  class_amnt { max_block / granularity };
+    static constexpr std::size_t  word_amnt  { (max_size - granularity) / granularity };
+    static constexpr std::uint32_t reserved_words { 2 };
+
+    struct arena
+    {
+        std::uint32_t free_lists[class_amnt]; //index of the first free block, 0 if none
+        std::size_t   cursor;                 //first word never handed out
+        std::size_t   committed;              //accessible bytes from origin
+        std::size_t   in_use;
+        std::size_t   free;
+
+        arena() : free_lists { }
+                , cursor     { reserved_words }
+                , committed  { 0 }
+                , in_use     { 0 }
+                , free       { 0 }
+        {
+        }
+
+        arena(const arena &) = delete;
+        arena & operator=(const arena &) = delete;
+
+        void map()
+        {
+            void * m { mmap(nullptr, max_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0) };
+
+            if(m == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+
+            origin = static_cast<char*>(m);
+        }
+
+        /*
+         * make the first bytes of the arena accessible, in whole steps
+         */
+        void commit(const std::size_t bytes)
+        {
+            if(bytes <= committed) {
+                return;
+            }
+
+            const std::size_t upto { (bytes + commit_step - 1) / commit_step * commit_step };
+
+            if(upto > max_size || mprotect(origin + committed, upto - committed, PROT_READ | PROT_WRITE) != 0) {
+                throw std::bad_alloc();
+            }
+
+            committed = upto;
+        }
+    };
+
+    //outside of arena so at() and index() skip the guard of instance()
+    static char * origin;
+
+    //never destroyed nor unmapped, so trees with static storage duration
+    //can still read and free their nodes at exit
+    static arena & instance()
+    {
+        static arena & a = *new arena;
+        return a;
+    }
+
+    static std::size_t words(const std::size_t bytes)
+    {
+        return (bytes + granularity - 1) / granularity;
+    }
+
+public:
+    static void * allocate(const std::size_t bytes)
+    {
+        assert(bytes > 0);
+
+        const std::size_t w { words(bytes) };
+
+        if(w * granularity > max_block) {
+            throw std::bad_alloc();
+        }
+
+        arena & a = instance();
+        std::uint32_t & head = a.free_lists[w - 1];
+
+        if(origin == nullptr) {
+            a.map();
+        }
+
+        if(head != 0) {
+            void * b { at(head) };
+            head = *static_cast<std::uint32_t*>(b);
+            a.in_use += w * granularity;
+            a.free   -= w * granularity;
+            return b;
+        }
+
+        if(a.cursor + w > word_amnt) {
+            throw std::bad_alloc();
+        }
+
+        //the block and the readable bytes after it
+        a.commit((a.cursor + w) * granularity + granularity);
+        a.in_use += w * granularity;
+
+        void * b { at(static_cast<std::uint32_t>(a.cursor)) };
+        a.cursor += w;
+        return b;
+    }
+
+    static void deallocate(void * ptr, const std::size_t bytes)
+    {
+        assert(ptr != nullptr);
+
+        const std::size_t w { words(bytes) };
+        arena & a = instance();
+        std::uint32_t & head = a.free_lists[w - 1];
+
+        *static_cast<std::uint32_t*>(ptr) = head;
+        head = index(ptr);
+
+        a.in_use -= w * granularity;
+        a.free   += w * granularity;
+    }
+
+    /*
+     * block at a word index, 0 is the zeroed reserved block
+     */
+    static void * at(const std::uint32_t idx)
+    {
+        assert(origin != nullptr || idx == 0);
+
+        return origin == nullptr ? zero() : origin + std::size_t { idx } * granularity;
+    }
+
+    static std::uint32_t index(const void * ptr)
+    {
+        assert(origin != nullptr);
+
+        return static_cast<std::uint32_t>((static_cast<const char*>(ptr) - origin) / granularity);
+    }
+
+    /*
+     * hand every page back to the system, the reservation is kept
+     * all blocks handed out by this arena become invalid
+     */
+    static void release()
+    {
+        arena & a = instance();
+
+        if(origin != nullptr) {
+            madvise(origin, a.committed, MADV_DONTNEED);
+        }
+
+        for(std::size_t i=0; i<class_amnt; ++i) {
+            a.free_lists[i] = 0;
+        }
+
+        a.cursor = reserved_words;
+        a.in_use = 0;
+        a.free   = 0;
+    }
+
+    static alloc_stats stats()
+    {
+        const arena & a = instance();
+        const std::size_t carved { origin == nullptr ? 0 : (a.cursor - reserved_words) * granularity };
+
+        return alloc_stats {
+              origin == nullptr ? 0u : 1u
+            , carved
+            , a.in_use
+            , a.free
+            , 0
+        };
+    }
+
+private:
+    /*
+     * stands in for the reserved block before anything is mapped
+     */
+    static void * zero()
+    {
+        static const std::uint64_t z[reserved_words + 1] { };
+        return const_cast<std::uint64_t*>(z);
+    }
+};
+
+template <typename Tag, std::size_t Reserve>
+char * basic_arena_allocator<Tag, Reserve>::origin { nullptr };
+
+template <typename Tag, std::size_t Reserve>
+constexpr std::size_t basic_arena_allocator<Tag, Reserve>::granularity;
+
+template <typename Tag, std::size_t Reserve>
+constexpr std::size_t basic_arena_allocator<Tag, Reserve>::max_block;
+
+template <typename Tag, std::size_t Reserve>
+constexpr std::size_t basic_arena_allocator<Tag, Reserve>::max_size;
+
+template <typename Tag, std::size_t Reserve>
+constexpr std::size_t basic_arena_allocator<Tag, Reserve>::commit_step;
+
+typedef basic_arena_allocator<> arena_allocator;
+
+/*
+ * serializes every call of Base behind one mutex, so a policy that is not
+ * thread safe can back trees that are built or freed from several
+ * threads, see parallel.hpp
+ */
+template <typename Base>
+struct locked_allocator
+{
+    static std::mutex & lock()
+    {
+        static std::mutex m;
+        return m;
+    }
+
+    static void * allocate(const std::size_t bytes)
+    {
+        std::lock_guard<std::mutex> guard { lock() };
+        return Base::allocate(bytes);
+    }
+
+    static void deallocate(void * p, const std::size_t bytes)
+    {
+        std::lock_guard<std::mutex> guard { lock() };
+        Base::deallocate(p, bytes);
+    }
+
+    static void release()
+    {
+        std::lock_guard<std::mutex> guard { lock() };
+        Base::release();
+    }
+
+    static alloc_stats stats()
+    {
+        std::lock_guard<std::mutex> guard { lock() };
+        return Base::stats();
+    }
+
+    static bool bump_only(const bool on)
+    {
+        std::lock_guard<std::mutex> guard { lock() };
+        return Base::bump_only(on);
+    }
+};
+
+/*
+ * while alive, blocks of Alloc come out in address order from memory
+ * not handed out before, so a structure allocated in the order it is
+ * walked is laid out that way, see tree::compact
+ * does nothing for policies without such a mode
+ */
+template <typename Alloc>
+class fresh_memory
+{
+public:
+    fresh_memory()
+    {
+    }
+
+    fresh_memory(const fresh_memory &) = delete;
+    fresh_memory & operator=(const fresh_memory &) = delete;
+};
+
+template <typename Tag>
+class fresh_memory<basic_pool_allocator<Tag>>
+{
+    const bool was;
+
+public:
+    fresh_memory() : was { basic_pool_allocator<Tag>::bump_only(true) }
+    {
+    }
+
+    ~fresh_memory()
+    {
+        basic_pool_allocator<Tag>::bump_only(was);
+    }
+
+    fresh_memory(const fresh_memory &) = delete;
+    fresh_memory & operator=(const fresh_memory &) = delete;
+};
+
+template <>
+class fresh_memory<local_pool_allocator>
+{
+    const bool was;
+
+public:
+    fresh_memory() : was { local_pool_allocator::bump_only(true) }
+    {
+    }
+
+    ~fresh_memory()
+    {
+        local_pool_allocator::bump_only(was);
+    }
+
+    fresh_memory(const fresh_memory &) = delete;
+    fresh_memory & operator=(const fresh_memory &) = delete;
+};
+
+template <typename Tag>
+class fresh_memory<locked_allocator<basic_pool_allocator<Tag>>>
+{
+    const bool was;
+
+public:
+    fresh_memory() : was { locked_allocator<basic_pool_allocator<Tag>>::bump_only(true) }
+    {
+    }
+
+    ~fresh_memory()
+    {
+        locked_allocator<basic_pool_allocator<Tag>>::bump_only(was);
+    }
+
+    fresh_memory(const fresh_memory &) = delete;
+    fresh_memory & operator=(const fresh_memory &) = delete;
+};
+
+/*
+ * whether Alloc only serves one owner, so dropping all of its memory
+ * with release() cannot free blocks of anybody else
+ * true for pools and arenas with their own tag, the untagged ones and
+ * the per thread pool_allocator are shared by every default tree
+ */
+template <typename Alloc>
+struct is_private_allocator : std::false_type
+{
+};
+
+template <typename Tag>
+struct is_private_allocator<basic_pool_allocator<Tag>> : std::integral_constant<bool, ! std::is_void<Tag>::value>
+{
+};
+
+template <typename Tag, std::size_t Reserve>
+struct is_private_allocator<basic_arena_allocator<Tag, Reserve>> : std::integral_constant<bool, ! std::is_void<Tag>::value>
+{
+};
+
+template <typename Base>
+struct is_private_allocator<locked_allocator<Base>> : is_private_allocator<Base>
+{
+};
+
+namespace detail
+{
+    /*
+     * allocator policy of a tree type taking <T, Alloc, Growth>
+     */
+    template <typename Tree>
+    struct node_allocator;
+
+    template <template <typename, typename, typename> class Tree, typename T, typename Alloc, typename Growth>
+    struct node_allocator<Tree<T, Alloc, Growth>>
+    {
+        typedef Alloc type;
+    };
+};
+
+/*
+ * whether allocate and deallocate may be called concurrently
+ * specialize for own policies that are
+ */
+template <typename Alloc>
+struct is_thread_safe_allocator : std::false_type
+{
+};
+
+template <>
+struct is_thread_safe_allocator<heap_allocator> : std::true_type
+{
+};
+
+template <>
+struct is_thread_safe_allocator<local_pool_allocator> : std::true_type
+{
+};
+
+template <typename Base>
+struct is_thread_safe_allocator<locked_allocator<Base>> : std::true_type
+{
+};
+
+};
+
+#endif
@@ -0,0 +1,595 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_BASIC_TREE_H
+#define HCKT_BASIC_TREE_H
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <vector>
+#include "allocator.hpp"
+#include "lmemvector.hpp"
+#include "shape.hpp"
+#include "util.hpp"
+
+namespace hckt
+{
+
+/*
+ * node code shared by hckt::tree and hckt::shaped_tree
+ *
+ * Node is the class deriving from this one (children are Node*), Shape
+ * gives the number of positions and the mask type, see shape.hpp
+ * the derived class adds coordinate access and whatever is specific to
+ * its node width
+ *
+ * Alloc is the allocator policy used for nodes and their value/children
+ * buffers, see allocator.hpp
+ * Growth decides the capacity of those buffers, see lmemvector.hpp
+ */
+template <typename Node, typename T, typename Shape, typename Alloc, typename Growth>
+class basic_tree
+{
+typedef T value_type;
+
+public:
+    typedef typename Shape::mask_type mask_type;
+
+    static constexpr unsigned fanout { Shape::fanout };
+
+protected:
+    mask_type                                 chiset; //is child set to this position
+    mask_type                                 leaf;   //is leaf
+    hckt::lmemvector<value_type, Alloc, Growth> values;
+    hckt::lmemvector<Node*, Alloc, Growth>      children;
+
+    static Node * create_node()
+    {
+        return new (Alloc::allocate(sizeof(Node))) Node();
+    }
+
+    static void destroy_node(Node * node)
+    {
+        node->~Node();
+        Alloc::deallocate(node, sizeof(Node));
+    }
+
+    basic_tree() : chiset   { }
+                 , leaf     { }
+                 , values   { }
+                 , children { }
+    {
+    }
+
+    ~basic_tree()
+    {
+        collapse();
+    }
+
+    mask_type child_bits() const
+    {
+        return chiset.without(leaf);
+    }
+
+public:
+    basic_tree(const basic_tree &) = delete;
+    basic_tree & operator=(const basic_tree &) = delete;
+
+    unsigned children_amnt() const
+    {
+        return child_bits().count();
+    }
+
+    unsigned leaf_amnt() const
+    {
+        return leaf.count();
+    }
+
+    unsigned value_amount() const
+    {
+        return chiset.count();
+    }
+
+    unsigned get_children_position(const unsigned position) const
+    {
+        assert(position < fanout);
+
+        return child_bits().rank(position);
+    }
+
+    /*
+     * values are kept for every set position, children only for non leaves
+     */
+    unsigned get_value_position(const unsigned position) const
+    {
+        assert(position < fanout);
+
+        return chiset.rank(position);
+    }
+
+    /*
+     * check if we have any children
+     */
+    bool has_children() const
+    {
+        return chiset.any();
+    }
+
+    bool is_set(const unsigned position) const
+    {
+        assert(position < fanout);
+        return chiset.test(position);
+    }
+
+    bool is_leaf(const unsigned position) const
+    {
+        assert(position < fanout);
+        return leaf.test(position);
+    }
+
+    /*
+     * drop values and children buffers of this node only
+     */
+    void clear_node()
+    {
+        children.clear(children_amnt());
+        values.clear(value_amount());
+        chiset = mask_type { };
+        leaf   = mask_type { };
+    }
+
+    /*
+     * destroy children
+     * without recursion, every node is emptied before it is destroyed
+     * so its destructor has nothing left to do
+     */
+    void collapse()
+    {
+        if(children_amnt() == 0) {
+            clear_node();
+            return;
+        }
+
+        std::vector<Node*> pending;
+
+        for(unsigned i=0, c_amnt=children_amnt(); i<c_amnt; ++i) {
+            pending.push_back(children[i]);
+        }
+
+        clear_node();
+
+        while(! pending.empty()) {
+            Node * const node { pending.back() };
+            pending.pop_back();
+
+            for(unsigned i=0, c_amnt=node->children_amnt(); i<c_amnt; ++i) {
+                pending.push_back(node->child_at(i));
+            }
+
+            node->clear_node();
+            destroy_node(node);
+        }
+    }
+
+    /*
+     * move every node below this one and its buffers to fresh memory in
+     * preorder, each node followed by its values and children, so a
+     * lookup walks forward through memory instead of hopping around the
+     * holes insert/remove churn leaves behind
+     * new nodes never reuse freed blocks, that is what lays them out in
+     * order, so the allocator grows by about the size of the tree and
+     * with a pool the old half stays in its free lists afterwards, to be
+     * reused by later inserts or dropped with release()
+     * pointers to nodes below this one are invalidated
+     */
+    void compact()
+    {
+        const hckt::fresh_memory<Alloc> fresh;
+        std::vector<Node**> slots; //children pointers still pointing at old nodes, next on top
+
+        for(unsigned i=children_amnt(); i-- > 0; ) {
+            slots.push_back(&children.buf[i]);
+        }
+
+        while(! slots.empty()) {
+            Node ** const slot { slots.back() };
+            Node * const  old  { *slot };
+            Node * const  node { create_node() };
+            basic_tree &  from { *old };  //members are only reachable through
+            basic_tree &  to   { *node }; //the base class in here
+
+            slots.pop_back();
+
+            to.chiset = from.chiset;
+            to.leaf   = from.leaf;
+            to.values.assign(from.values.buf, from.value_amount());
+            to.children.assign(from.children.buf, from.children_amnt());
+            old->clear_node();
+            destroy_node(old);
+
+            *slot = node;
+
+            for(unsigned i=to.children_amnt(); i-- > 0; ) {
+                slots.push_back(&to.children.buf[i]);
+            }
+        }
+    }
+
+    /*
+     * drop the whole tree in O(chunks) by releasing the allocator
+     * instead of visiting every node
+     * every block of Alloc goes with it, so it only compiles for an
+     * allocator with a tag private to this tree, see is_private_allocator
+     */
+    void release()
+    {
+        static_assert(hckt::is_private_allocator<Alloc>::value, "release() frees all of Alloc, use a basic_pool_allocator with a tag of this tree");
+
+        children.abandon();
+        values.abandon();
+        chiset = mask_type { };
+        leaf   = mask_type { };
+        Alloc::release();
+    }
+
+    /*
+     * node allocated through Alloc, to be handed to assign()
+     */
+    static Node * new_node()
+    {
+        return create_node();
+    }
+
+    /*
+     * free a node from new_node() or detach(), its subtree with it
+     * a node emptied by clear_node() is freed in O(1)
+     */
+    static void delete_node(Node * node)
+    {
+        destroy_node(node);
+    }
+
+    /*
+     * insert a tree into position of tree
+     * position should be result of get_position
+     */
+    void insert(const unsigned position, const value_type value)
+    {
+        assert(position < fanout);
+        assert(! is_set(position));
+
+        const unsigned cpos   { get_children_position(position) };
+        const unsigned c_amnt { children_amnt() };
+        const unsigned vpos   { get_value_position(position) };
+        const unsigned v_amnt { value_amount() };
+
+        children.insert(cpos, create_node(), c_amnt);
+        values.insert(vpos, value, v_amnt);
+        chiset.set(position);
+    }
+
+    /*
+     * insert a leaf into position of tree
+     * position should be result of get_position
+     */
+    void insert_leaf(const unsigned position, const value_type value)
+    {
+        assert(position < fanout);
+        assert(! is_set(position));
+
+        const unsigned vpos   { get_value_position(position) };
+        const unsigned v_amnt { value_amount() };
+
+        values.insert(vpos, value, v_amnt);
+        chiset.set(position);
+        leaf.set(position);
+    }
+
+    /*
+     * removes an item (leaf or subtree) from tree
+     * position should be result of get_position
+     */
+    void remove(const unsigned position)
+    {
+        assert(position < fanout);
+        assert(is_set(position));
+
+        const unsigned vpos   { get_value_position(position) };
+        const unsigned v_amnt { value_amount() };
+
+        if(! is_leaf(position)) {
+            const unsigned cpos   { get_children_position(position) };
+            const unsigned c_amnt { children_amnt() };
+
+            destroy_node(children[cpos]);
+            children.erase(cpos, c_amnt);
+        }
+
+        values.erase(vpos, v_amnt);
+        chiset.reset(position);
+        leaf.reset(position);
+    }
+
+    /*
+     * removes a subtree from tree without freeing it, the caller owns the
+     * returned node and frees it with delete_node(), see reclaim.hpp
+     * position should be result of get_position
+     */
+    Node * detach(const unsigned position)
+    {
+        assert(position < fanout);
+        assert(is_set(position));
+        assert(! is_leaf(position));
+
+        const unsigned vpos   { get_value_position(position) };
+        const unsigned v_amnt { value_amount() };
+        const unsigned cpos   { get_children_position(position) };
+        const unsigned c_amnt { children_amnt() };
+
+        Node * const node { children[cpos] };
+
+        children.erase(cpos, c_amnt);
+        values.erase(vpos, v_amnt);
+        chiset.reset(position);
+
+        return node;
+    }
+
+    /*
+     * get child node
+     * position should be result of get_position
+     */
+    Node * child(const unsigned position) const
+    {
+        assert(position < fanout);
+        assert(is_set(position));
+        assert(! is_leaf(position));
+
+        const unsigned cpos { get_children_position(position) };
+
+        return children[cpos];
+    }
+
+    /*
+     * get child by its index among the children, they are in position order
+     */
+    Node * child_at(const unsigned cpos) const
+    {
+        assert(cpos < children_amnt());
+
+        return children[cpos];
+    }
+
+    /*
+     * address child(position) reads its pointer from, for prefetching
+     */
+    const void * child_address(const unsigned position) const
+    {
+        return &children.buf[get_children_position(position)];
+    }
+
+    /*
+     * sets node to specific value
+     * note: this does not check whether a value has been inserted here yet
+     * position should be result of get_position
+     */
+    void set_value(const unsigned position, const value_type value)
+    {
+        assert(position < fanout);
+        assert(is_set(position));
+
+        const unsigned vpos { get_value_position(position) };
+
+        values[vpos] = value;
+    }
+
+    /*
+     * gets value from specific position
+     * note: this does not check whether a value has been inserted here yet
+     * position should be result of get_position
+     */
+    value_type get_value(const unsigned position) const
+    {
+        assert(position < fanout);
+
+        const unsigned vpos { get_value_position(position) };
+
+        return values[vpos];
+    }
+
+    /*
+     * value stored at the end of a path, see morton.hpp and shape.hpp, or
+     * nullptr if nothing is set there
+     * a leaf above the end of the path covers it and is returned
+     */
+    template <typename Path>
+    const value_type * find_path(Path & p) const
+    {
+        assert(! p.done());
+
+        const basic_tree * node { this };
+
+        while(true) {
+            const unsigned pos { p.next() };
+
+            if(! node->is_set(pos)) {
+                return nullptr;
+            }
+
+            if(p.done() || node->is_leaf(pos)) {
+                return &node->values.buf[node->get_value_position(pos)];
+            }
+
+            node = node->child(pos);
+        }
+    }
+
+    /*
+     * set the value at the end of a path, creating nodes along the way
+     * new interior nodes get a default constructed value
+     */
+    template <typename Path>
+    void insert_path(Path & p, const value_type value)
+    {
+        assert(! p.done());
+
+        basic_tree * node { this };
+
+        while(true) {
+            const unsigned pos { p.next() };
+
+            if(p.done()) {
+                if(node->is_set(pos)) {
+                    node->set_value(pos, value);
+                } else {
+                    node->insert_leaf(pos, value);
+                }
+
+                return;
+            }
+
+            if(! node->is_set(pos)) {
+                node->insert(pos, value_type { });
+            } else if(node->is_leaf(pos)) {
+                const value_type v { node->get_value(pos) };
+                node->remove(pos);
+                node->insert(pos, v);
+            }
+
+            node = node->child(pos);
+        }
+    }
+
+
+    /************************************************
+     *
+     * BENCHMARKING CODE
+     *
+     ***********************************************/
+
+    /*
+     * calls f on every node, this one first
+     */
+    template <typename F>
+    void for_each_node(F f) const
+    {
+        std::vector<const basic_tree*> pending { this };
+
+        while(! pending.empty()) {
+            const basic_tree * const node { pending.back() };
+            pending.pop_back();
+
+            f(static_cast<const Node &>(*node));
+
+            for(unsigned i=0, c_amnt=node->children_amnt(); i<c_amnt; ++i) {
+                pending.push_back(node->child_at(i));
+            }
+        }
+    }
+
+    std::size_t calculate_memory_size() const
+    {
+        std::size_t size { 0 };
+
+        for_each_node([&size](const basic_tree & node) {
+            size += sizeof(node.chiset)
+                  + sizeof(node.leaf)
+                  + sizeof(node.values)   + (node.values.capacity(node.value_amount())    * sizeof(value_type))
+                  + sizeof(node.children) + (node.children.capacity(node.children_amnt()) * sizeof(Node*));
+        });
+
+        return size;
+    }
+
+    std::size_t calculate_node_amnt() const
+    {
+        std::size_t amount { 0 };
+
+        for_each_node([&amount](const basic_tree &) {
+            ++amount;
+        });
+
+        return amount;
+    }
+
+    std::size_t calculate_children_amnt() const
+    {
+        std::size_t amount { 0 };
+
+        for_each_node([&amount](const basic_tree & node) {
+            amount += node.children_amnt();
+        });
+
+        return amount;
+    }
+
+    std::size_t calculate_leaf_amount() const
+    {
+        std::size_t amount { 0 };
+
+        for_each_node([&amount](const basic_tree & node) {
+            amount += node.leaf_amnt();
+        });
+
+        return amount;
+    }
+
+    void mem_usage_info() const
+    {
+        const std::size_t memsize { calculate_memory_size() };
+        const std::size_t c_amnt  { calculate_children_amnt() };
+        const std::size_t l_amnt  { calculate_leaf_amount() };
+        const std::size_t v_amnt  { c_amnt + l_amnt };
+
+        std::cout << "total:     " << hckt::render_size(memsize) << std::endl;
+
+        std::cout << "tree-size: " << hckt::render_size(sizeof(Node)) << std::endl;
+        std::cout << "val-size:  " << hckt::render_size(sizeof(value_type)) << std::endl;
+
+        std::cout << "values:    " << hckt::render_number(v_amnt) << std::endl;
+        std::cout << "children:  " << hckt::render_number(c_amnt) << std::endl;
+        std::cout << "leaves:    " << hckt::render_number(l_amnt) << std::endl;
+
+        std::cout << "per-val:   " << (static_cast<double>(memsize) / v_amnt) << " B" << std::endl;
+        std::cout << "overhead:  " << (static_cast<double>(memsize - (v_amnt * sizeof(value_type))) / v_amnt) << " B" << std::endl;
+
+        const hckt::alloc_stats astats = Alloc::stats();
+
+        if(astats.chunks != 0) {
+            std::cout << "chunks:    " << hckt::render_number(astats.chunks) << " (" << hckt::render_size(astats.reserved) << ")" << std::endl;
+            std::cout << "in-use:    " << hckt::render_size(astats.in_use) << std::endl;
+            std::cout << "frag:      " << (astats.fragmentation() * 100.0) << " %" << std::endl;
+        }
+    }
+
+};
+
+template <typename Node, typename T, typename Shape, typename Alloc, typename Growth>
+constexpr unsigned basic_tree<Node, T, Shape, Alloc, Growth>::fanout;
+
+};
+
+#endif
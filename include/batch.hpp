@@ -0,0 +1,139 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_BATCH_H
+#define HCKT_BATCH_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "morton.hpp"
+
+namespace hckt
+{
+
+/*
+ * point lookups by key, see bulk_load.hpp for the key layout
+ * both work on any node type with the read only tree interface plus
+ * child_address(): tree, block_tree and frozen_node
+ *
+ * like tree::find, a leaf above the requested depth covers the cell
+ */
+
+/*
+ * single lookup, the baseline batches are measured against
+ */
+template <typename Node, typename Value>
+bool find_key(const Node & root, const std::uint64_t key, const unsigned depth, Value & value)
+{
+    assert(depth > 0);
+    assert(depth <= morton::key_levels);
+
+    const Node * node { &root };
+
+    for(unsigned level=0; ; ++level) {
+        const unsigned pos ( (key >> (6 * (depth - 1 - level))) & 63 );
+
+        if(! node->is_set(pos)) {
+            return false;
+        }
+
+        if(level + 1 == depth || node->is_leaf(pos)) {
+            value = node->get_value(pos);
+            return true;
+        }
+
+        node = node->child(pos);
+    }
+}
+
+/*
+ * resolve amnt independent lookups, Group of them at a time in lockstep
+ *
+ * each level takes two passes over the group: the first checks the
+ * current node and prefetches the memory holding the child reference,
+ * the second follows it and prefetches the child node, so every miss of
+ * one query overlaps with work on the others instead of stalling
+ */
+template <unsigned Group = 16, typename Node, typename Value>
+void find_batch(const Node & root, const std::uint64_t * keys, const std::size_t amnt, const unsigned depth, Value * values, bool * found)
+{
+    static_assert(Group > 0, "group needs at least one query");
+
+    assert(depth > 0);
+    assert(depth <= morton::key_levels);
+
+    const Node * nodes[Group];
+    unsigned     positions[Group];
+    unsigned     active[Group];
+
+    for(std::size_t base=0; base<amnt; base += Group) {
+        const unsigned size ( amnt - base < Group ? amnt - base : Group );
+        unsigned       active_amnt { size };
+
+        for(unsigned i=0; i<size; ++i) {
+            nodes[i]  = &root;
+            active[i] = i;
+            found[base + i] = false;
+        }
+
+        for(unsigned level=0; active_amnt != 0; ++level) {
+            const unsigned shift { 6 * (depth - 1 - level) };
+            unsigned       kept  { 0 };
+
+            for(unsigned a=0; a<active_amnt; ++a) {
+                const unsigned     q    { active[a] };
+                const Node *       node { nodes[q] };
+                const unsigned     pos  ( (keys[base + q] >> shift) & 63 );
+
+                if(! node->is_set(pos)) {
+                    continue;
+                }
+
+                if(level + 1 == depth || node->is_leaf(pos)) {
+                    values[base + q] = node->get_value(pos);
+                    found[base + q]  = true;
+                    continue;
+                }
+
+                __builtin_prefetch(node->child_address(pos));
+                positions[q]   = pos;
+                active[kept++] = q;
+            }
+
+            for(unsigned a=0; a<kept; ++a) {
+                const unsigned q { active[a] };
+
+                nodes[q] = nodes[q]->child(positions[q]);
+                __builtin_prefetch(nodes[q]);
+            }
+
+            active_amnt = kept;
+        }
+    }
+}
+
+};
+
+#endif
@@ -0,0 +1,476 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_BLOCK_TREE_H
+#define HCKT_BLOCK_TREE_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <type_traits>
+#include "allocator.hpp"
+#include "frozen_tree.hpp"
+#include "lmemvector.hpp"
+#include "traversal.hpp"
+#include "util.hpp"
+
+namespace hckt
+{
+
+/*
+ * tree with the same interface as hckt::tree, but each node is a single
+ * variable sized block:
+ *
+ *   chiset | inv_leaf | children[children_amnt] | values[value_amount]
+ *
+ * a lookup touches one block per level instead of the node plus two
+ * separate buffers
+ *
+ * the tree object itself is only a pointer to its block, and children
+ * are stored inline in the parent block as block_tree objects, so
+ * child(position) points into the parent block
+ * modifying a node invalidates pointers to its children (not the
+ * children themselves)
+ */
+template <typename T, typename Alloc = hckt::pool_allocator, typename Growth = hckt::exact_growth>
+class block_tree
+{
+typedef T value_type;
+typedef Alloc allocator_type;
+
+static_assert(std::is_trivially_copyable<T>::value, "block_tree moves values with memcpy");
+static_assert(alignof(T) <= alignof(std::uint64_t), "values are placed after 8 byte aligned pointers");
+
+protected:
+    struct header
+    {
+        std::uint64_t chiset;   //is child set to this position
+        std::uint64_t inv_leaf; //opposite of leaf
+    };
+
+    header * block;
+
+    /*
+     * shared by all empty nodes so lookups never test for nullptr
+     */
+    static header * empty_block()
+    {
+        static header h { 0x0000000000000000, 0xFFFFFFFFFFFFFFFF };
+        return &h;
+    }
+
+    static std::size_t block_size(const unsigned c_amnt, const unsigned v_amnt)
+    {
+        return sizeof(header) + (c_amnt * sizeof(block_tree)) + (v_amnt * sizeof(value_type));
+    }
+
+    static std::size_t block_capacity(const unsigned c_amnt, const unsigned v_amnt)
+    {
+        return (c_amnt + v_amnt) == 0 ? 0 : Growth::template capacity<char>(block_size(c_amnt, v_amnt));
+    }
+
+    block_tree * children_buf() const
+    {
+        return reinterpret_cast<block_tree*>(block + 1);
+    }
+
+    value_type * values_buf(const unsigned c_amnt) const
+    {
+        return reinterpret_cast<value_type*>(reinterpret_cast<char*>(block + 1) + c_amnt * sizeof(block_tree));
+    }
+
+    /*
+     * move the block to one fitting c_amnt children and v_amnt values
+     * if its size class changes, layout is left to the caller
+     */
+    void resize_block(const unsigned old_c, const unsigned old_v, const unsigned new_c, const unsigned new_v)
+    {
+        const std::size_t old_cap { block_capacity(old_c, old_v) };
+        const std::size_t new_cap { block_capacity(new_c, new_v) };
+
+        if(old_cap == new_cap) {
+            return;
+        }
+
+        header * nb { empty_block() };
+
+        if(new_cap != 0) {
+            nb = static_cast<header*>(Alloc::allocate(new_cap));
+            const std::size_t keep { old_cap < new_cap ? old_cap : new_cap };
+            std::memcpy(nb, block, keep < sizeof(header) ? sizeof(header) : keep);
+        }
+
+        if(old_cap != 0) {
+            Alloc::deallocate(block, old_cap);
+        }
+
+        block = nb;
+    }
+
+public:
+
+    block_tree() : block { empty_block() }
+    {
+    }
+
+    ~block_tree()
+    {
+        collapse();
+    }
+
+    block_tree(const block_tree &) = delete;
+    block_tree & operator=(const block_tree &) = delete;
+
+    std::uint64_t chidist() const
+    {
+        return block->chiset & block->inv_leaf;
+    }
+
+    std::uint64_t set_mask() const
+    {
+        return block->chiset;
+    }
+
+    std::uint64_t leaf_mask() const
+    {
+        return block->chiset & ~block->inv_leaf;
+    }
+
+    unsigned children_amnt() const
+    {
+        return hckt::popcount(chidist());
+    }
+
+    unsigned leaf_amnt() const
+    {
+        return hckt::popcount(~block->inv_leaf);
+    }
+
+    unsigned value_amount() const
+    {
+        return hckt::popcount(block->chiset);
+    }
+
+    unsigned get_children_position(const unsigned position) const
+    {
+        return hckt::rank(chidist(), position);
+    }
+
+    unsigned get_value_position(const unsigned position) const
+    {
+        return hckt::rank(block->chiset, position);
+    }
+
+    /*
+     * check if we have any children
+     */
+    bool has_children() const
+    {
+        return block->chiset != 0;
+    }
+
+    bool is_set(const unsigned position) const
+    {
+        assert(position < 64);
+        return (block->chiset >> position) & 1;
+    }
+
+    bool is_leaf(const unsigned position) const
+    {
+        assert(position < 64);
+        return !((block->inv_leaf >> position) & 1);
+    }
+
+    /*
+     * destroy children
+     */
+    void collapse()
+    {
+        if(block == empty_block()) {
+            return;
+        }
+
+        //children live in their parent's block, so blocks are freed bottom up
+        for(postorder_iterator<block_tree> it { *this }, end { }; it != end; ) {
+            block_tree & node = *it;
+            ++it;
+
+            const std::size_t cap { block_capacity(node.children_amnt(), node.value_amount()) };
+
+            if(cap != 0) {
+                Alloc::deallocate(node.block, cap);
+            }
+
+            node.block = empty_block();
+        }
+    }
+
+    /*
+     * move this node's block and every block below it to fresh memory
+     * in preorder, to undo the scattering of insert/remove churn
+     * like tree::compact the allocator grows by about the size of the
+     * tree, the old blocks stay in the pool's free lists
+     * pointers to children are invalidated, as by any modification
+     */
+    void compact()
+    {
+        const hckt::fresh_memory<Alloc> fresh;
+
+        //a yielded node's children are read after its block moved
+        for(block_tree & node : hckt::preorder(*this)) {
+            if(node.block == empty_block()) {
+                continue;
+            }
+
+            const unsigned    c_amnt { node.children_amnt() };
+            const unsigned    v_amnt { node.value_amount() };
+            const std::size_t cap    { block_capacity(c_amnt, v_amnt) };
+            header * const    nb     { static_cast<header*>(Alloc::allocate(cap)) };
+
+            std::memcpy(nb, node.block, block_size(c_amnt, v_amnt));
+            Alloc::deallocate(node.block, cap);
+            node.block = nb;
+        }
+    }
+
+    /*
+     * insert a tree into position of tree
+     * position should be result of get_position
+     */
+    void insert(const unsigned position, const value_type value)
+    {
+        assert(position < 64);
+        assert(! is_set(position));
+
+        const unsigned cpos   { get_children_position(position) };
+        const unsigned c_amnt { children_amnt() };
+        const unsigned vpos   { get_value_position(position) };
+        const unsigned v_amnt { value_amount() };
+
+        resize_block(c_amnt, v_amnt, c_amnt + 1, v_amnt + 1);
+
+        //values first, children grow into the space they leave behind
+        value_type * ov { values_buf(c_amnt) };
+        value_type * nv { values_buf(c_amnt + 1) };
+        std::memmove(nv + vpos + 1, ov + vpos, sizeof(value_type) * (v_amnt - vpos));
+        std::memmove(nv, ov, sizeof(value_type) * vpos);
+        nv[vpos] = value;
+
+        block_tree * c { children_buf() };
+        std::memmove(static_cast<void*>(c + cpos + 1), c + cpos, sizeof(block_tree) * (c_amnt - cpos));
+        new (c + cpos) block_tree();
+
+        block->chiset   |= (std::uint64_t { 1 } << position);
+        block->inv_leaf |= (std::uint64_t { 1 } << position);
+    }
+
+    /*
+     * insert a leaf into position of tree
+     * position should be result of get_position
+     */
+    void insert_leaf(const unsigned position, const value_type value)
+    {
+        assert(position < 64);
+        assert(! is_set(position));
+
+        const unsigned c_amnt { children_amnt() };
+        const unsigned vpos   { get_value_position(position) };
+        const unsigned v_amnt { value_amount() };
+
+        resize_block(c_amnt, v_amnt, c_amnt, v_amnt + 1);
+
+        value_type * v { values_buf(c_amnt) };
+        std::memmove(v + vpos + 1, v + vpos, sizeof(value_type) * (v_amnt - vpos));
+        v[vpos] = value;
+
+        block->chiset   |=  (std::uint64_t { 1 } << position);
+        block->inv_leaf &= ~(std::uint64_t { 1 } << position);
+    }
+
+    /*
+     * removes an item (leaf or subtree) from tree
+     * position should be result of get_position
+     */
+    void remove(const unsigned position)
+    {
+        assert(position < 64);
+        assert(is_set(position));
+
+        const unsigned c_amnt { children_amnt() };
+        const unsigned vpos   { get_value_position(position) };
+        const unsigned v_amnt { value_amount() };
+        const bool     leaf   { is_leaf(position) };
+        const unsigned new_c  { leaf ? c_amnt : c_amnt - 1 };
+
+        if(! leaf) {
+            const unsigned cpos { get_children_position(position) };
+            block_tree * c { children_buf() };
+
+            c[cpos].collapse();
+            std::memmove(static_cast<void*>(c + cpos), c + cpos + 1, sizeof(block_tree) * (c_amnt - cpos - 1));
+        }
+
+        value_type * ov { values_buf(c_amnt) };
+        value_type * nv { values_buf(new_c) };
+        std::memmove(nv, ov, sizeof(value_type) * vpos);
+        std::memmove(nv + vpos, ov + vpos + 1, sizeof(value_type) * (v_amnt - vpos - 1));
+
+        block->chiset   &= ~(std::uint64_t { 1 } << position);
+        block->inv_leaf |=  (std::uint64_t { 1 } << position);
+
+        resize_block(c_amnt, v_amnt, new_c, v_amnt - 1);
+    }
+
+    /*
+     * get child node
+     * position should be result of get_position
+     */
+    block_tree * child(const unsigned position) const
+    {
+        assert(position < 64);
+        assert(is_set(position));
+        assert(! is_leaf(position));
+
+        return children_buf() + get_children_position(position);
+    }
+
+    /*
+     * get child by its index among the children, they are in position order
+     */
+    block_tree * child_at(const unsigned cpos) const
+    {
+        assert(cpos < children_amnt());
+
+        return children_buf() + cpos;
+    }
+
+    /*
+     * address child(position) reads its block pointer from, for prefetching
+     */
+    const void * child_address(const unsigned position) const
+    {
+        return children_buf() + get_children_position(position);
+    }
+
+    /*
+     * sets node to specific value
+     * position should be result of get_position
+     */
+    void set_value(const unsigned position, const value_type value)
+    {
+        assert(position < 64);
+        assert(is_set(position));
+
+        values_buf(children_amnt())[get_value_position(position)] = value;
+    }
+
+    /*
+     * gets value from specific position
+     * position should be result of get_position
+     */
+    value_type get_value(const unsigned position) const
+    {
+        assert(position < 64);
+
+        return values_buf(children_amnt())[get_value_position(position)];
+    }
+
+
+    /*
+     * build an immutable flat copy of this tree, see frozen_tree.hpp
+     * dedup stores identical subtrees once
+     */
+    hckt::frozen_tree<value_type> freeze(const bool dedup = false) const
+    {
+        return hckt::frozen_tree<value_type>(*this, dedup);
+    }
+
+
+    /************************************************
+     *
+     * BENCHMARKING CODE
+     *
+     ***********************************************/
+
+    std::size_t calculate_memory_size() const
+    {
+        //child handles are counted in the block of their parent
+        std::size_t size { sizeof(block_tree) };
+
+        for(const block_tree & node : hckt::preorder(*this)) {
+            size += block_capacity(node.children_amnt(), node.value_amount());
+        }
+
+        return size;
+    }
+
+    std::size_t calculate_children_amnt() const
+    {
+        std::size_t amount { 0 };
+
+        for(const block_tree & node : hckt::preorder(*this)) {
+            amount += node.children_amnt();
+        }
+
+        return amount;
+    }
+
+    std::size_t calculate_leaf_amount() const
+    {
+        std::size_t amount { 0 };
+
+        for(const block_tree & node : hckt::preorder(*this)) {
+            amount += node.leaf_amnt();
+        }
+
+        return amount;
+    }
+
+    void mem_usage_info() const
+    {
+        const std::size_t memsize { calculate_memory_size() };
+        const std::size_t c_amnt  { calculate_children_amnt() };
+        const std::size_t l_amnt  { calculate_leaf_amount() };
+        const std::size_t v_amnt  { c_amnt + l_amnt };
+
+        std::cout << "total:     " << hckt::render_size(memsize) << std::endl;
+
+        std::cout << "tree-size: " << hckt::render_size(sizeof(block_tree)) << std::endl;
+        std::cout << "val-size:  " << hckt::render_size(sizeof(value_type)) << std::endl;
+
+        std::cout << "values:    " << hckt::render_number(v_amnt) << std::endl;
+        std::cout << "children:  " << hckt::render_number(c_amnt) << std::endl;
+        std::cout << "leaves:    " << hckt::render_number(l_amnt) << std::endl;
+
+        std::cout << "per-val:   " << (static_cast<double>(memsize) / v_amnt) << " B" << std::endl;
+        std::cout << "overhead:  " << (static_cast<double>(memsize - (v_amnt * sizeof(value_type))) / v_amnt) << " B" << std::endl;
+    }
+
+};
+
+};
+
+#endif
@@ -0,0 +1,382 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_BULK_LOAD_H
+#define HCKT_BULK_LOAD_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "allocator.hpp"
+#include "morton.hpp"
+#include "util.hpp"
+
+namespace hckt
+{
+
+/*
+ * bulk construction from (key, value) pairs
+ *
+ * a key is the path of a cell at a given depth, 6 bits per level with
+ * the root level in the highest used bits, which is exactly
+ * morton::encode_2d(x, y) or morton::encode_3d(x, y, z) of the cell
+ * so depth is limited to morton::key_levels
+ *
+ * interior positions get a default constructed value, like insert(x, y, ...)
+ */
+
+namespace detail
+{
+    /*
+     * runs work(0) .. work(threads - 1), one on the calling thread
+     */
+    template <typename Work>
+    void on_threads(const unsigned threads, const Work & work)
+    {
+        std::vector<std::thread> workers;
+
+        for(unsigned i=1; i<threads; ++i) {
+            workers.emplace_back([&work, i]() { work(i); });
+        }
+
+        work(0);
+
+        for(std::thread & w : workers) {
+            w.join();
+        }
+    }
+
+    /*
+     * chunks are sorted on their own threads and merged pairwise in parallel
+     */
+    template <typename Iterator>
+    void merge_sort(Iterator first, Iterator last, const unsigned threads)
+    {
+        typedef typename std::iterator_traits<Iterator>::value_type pair_type;
+
+        const auto by_key = [](const pair_type & a, const pair_type & b) { return a.first < b.first; };
+        const std::size_t amnt { static_cast<std::size_t>(last - first) };
+
+        std::vector<Iterator> bounds;
+
+        for(unsigned i=0; i<=threads; ++i) {
+            bounds.push_back(first + amnt * i / threads);
+        }
+
+        on_threads(threads, [&bounds, &by_key](const unsigned i) { std::stable_sort(bounds[i], bounds[i + 1], by_key); });
+
+        //merge neighbouring runs until one is left
+        while(bounds.size() > 2) {
+            std::vector<Iterator> merged;
+            std::vector<std::thread> workers;
+
+            for(std::size_t i=0; i + 2 < bounds.size(); i += 2) {
+                workers.emplace_back([&bounds, &by_key, i]() { std::inplace_merge(bounds[i], bounds[i + 1], bounds[i + 2], by_key); });
+                merged.push_back(bounds[i]);
+            }
+
+            if(bounds.size() % 2 == 0) {
+                merged.push_back(bounds[bounds.size() - 2]);
+            }
+
+            merged.push_back(bounds.back());
+
+            for(std::thread & w : workers) {
+                w.join();
+            }
+
+            bounds.swap(merged);
+        }
+    }
+
+    /*
+     * one stable counting pass over the byte of the keys at shift
+     * every thread counts and then scatters its own chunk, slots are
+     * handed out by byte first and chunk second, so equal bytes keep
+     * their order
+     */
+    template <typename In, typename Out>
+    void radix_pass(In from, Out to, const std::size_t amnt, const unsigned shift, const unsigned threads)
+    {
+        std::vector<std::size_t> slots(threads * 256, 0);
+
+        const auto digit = [shift](const std::uint64_t key) -> unsigned { return (key >> shift) & 0xFF; };
+
+        on_threads(threads, [&](const unsigned t) {
+            std::size_t * const count { &slots[t * 256] };
+
+            for(std::size_t i=amnt * t / threads, end=amnt * (t + 1) / threads; i<end; ++i) {
+                ++count[digit(from[i].first)];
+            }
+        });
+
+        std::size_t sum { 0 };
+
+        for(unsigned d=0; d<256; ++d) {
+            for(unsigned t=0; t<threads; ++t) {
+                const std::size_t c { slots[t * 256 + d] };
+                slots[t * 256 + d] = sum;
+                sum += c;
+            }
+        }
+
+        on_threads(threads, [&](const unsigned t) {
+            std::size_t * const slot { &slots[t * 256] };
+
+            for(std::size_t i=amnt * t / threads, end=amnt * (t + 1) / threads; i<end; ++i) {
+                to[slot[digit(from[i].first)]++] = std::move(from[i]);
+            }
+        });
+    }
+
+    /*
+     * least significant byte first, skipping the bytes every key shares,
+     * so keys of a shallow depth take few passes
+     */
+    template <typename Iterator>
+    void radix_sort(Iterator first, Iterator last, const unsigned threads)
+    {
+        typedef typename std::iterator_traits<Iterator>::value_type pair_type;
+
+        const std::size_t amnt { static_cast<std::size_t>(last - first) };
+        std::uint64_t     all  { ~std::uint64_t { 0 } };
+        std::uint64_t     any  { 0 };
+
+        for(Iterator i=first; i!=last; ++i) {
+            all &= i->first;
+            any |= i->first;
+        }
+
+        std::vector<pair_type> buffer(amnt);
+        bool in_buffer { false };
+
+        for(unsigned shift=0; shift<sizeof(first->first) * 8; shift += 8) {
+            if((((all ^ any) >> shift) & 0xFF) == 0) {
+                continue;
+            }
+
+            if(in_buffer) {
+                radix_pass(buffer.begin(), first, amnt, shift, threads);
+            } else {
+                radix_pass(first, buffer.begin(), amnt, shift, threads);
+            }
+
+            in_buffer = ! in_buffer;
+        }
+
+        if(in_buffer) {
+            std::move(buffer.begin(), buffer.end(), first);
+        }
+    }
+
+    template <typename Iterator>
+    void sort_by_key(Iterator first, Iterator last, const unsigned threads, std::true_type)
+    {
+        radix_sort(first, last, threads);
+    }
+
+    template <typename Iterator>
+    void sort_by_key(Iterator first, Iterator last, const unsigned threads, std::false_type)
+    {
+        merge_sort(first, last, threads);
+    }
+};
+
+/*
+ * sorts by key, keeping equal keys in input order
+ * unsigned integer keys such as morton keys are radix sorted, others
+ * merge sorted, both on up to threads threads
+ */
+template <typename Iterator>
+void parallel_sort(Iterator first, Iterator last, unsigned threads = std::thread::hardware_concurrency())
+{
+    typedef typename std::iterator_traits<Iterator>::value_type pair_type;
+    typedef typename pair_type::first_type                      key_type;
+
+    const auto by_key = [](const pair_type & a, const pair_type & b) { return a.first < b.first; };
+    const std::size_t amnt { static_cast<std::size_t>(last - first) };
+
+    if(amnt < 1 << 16) {
+        std::stable_sort(first, last, by_key);
+        return;
+    }
+
+    detail::sort_by_key(first, last, threads < 1 ? 1 : threads, std::integral_constant<bool, std::is_integral<key_type>::value && std::is_unsigned<key_type>::value && sizeof(key_type) <= 8> { });
+}
+
+/*
+ * build an empty tree bottom up from key sorted pairs in one pass
+ * every node gets its masks and arrays written exactly once
+ * works with single pass input iterators, equal keys keep the last value
+ * nodes are carved from fresh memory (see fresh_memory), so the tree is
+ * laid out in build order instead of wherever earlier frees left holes
+ *
+ * throws std::invalid_argument for a depth outside 1..morton::key_levels,
+ * a key deeper than depth or keys out of order, t is left empty then
+ */
+template <typename Tree, typename Iterator>
+void bulk_load(Tree & t, Iterator first, Iterator last, const unsigned depth)
+{
+    typedef typename std::remove_reference<decltype(t.get_value(0))>::type value_type;
+
+    assert(! t.has_children());
+
+    if(depth == 0 || depth > morton::key_levels) {
+        throw std::invalid_argument("bulk_load: depth out of range");
+    }
+
+    struct builder
+    {
+        std::uint64_t chiset;
+        std::uint64_t inv_leaf;
+        unsigned      v_amnt;
+        unsigned      c_amnt;
+        value_type    values[64];
+        Tree *        children[64];
+    };
+
+    const hckt::fresh_memory<typename detail::node_allocator<Tree>::type> fresh;
+    std::vector<builder> open(depth);
+    std::uint64_t prev { 0 };
+    bool          any  { false };
+
+    for(builder & b : open) {
+        b.chiset = 0;
+        b.inv_leaf = 0;
+        b.v_amnt = 0;
+        b.c_amnt = 0;
+    }
+
+    const auto position = [depth](const std::uint64_t key, const unsigned level) -> unsigned {
+        return (key >> (6 * (depth - 1 - level))) & 63;
+    };
+
+    //turn the builder of level into a node and hand it to its parent
+    const auto close = [&open](const unsigned level) {
+        builder & b = open[level];
+        Tree * node { Tree::new_node() };
+
+        node->assign(b.chiset, b.inv_leaf, b.values, b.children);
+        open[level - 1].children[open[level - 1].c_amnt++] = node;
+
+        b.chiset = 0;
+        b.inv_leaf = 0;
+        b.v_amnt = 0;
+        b.c_amnt = 0;
+    };
+
+    //free the nodes built so far and give up
+    const auto fail = [&open](const char * what) {
+        for(builder & b : open) {
+            for(unsigned i=0; i<b.c_amnt; ++i) {
+                Tree::delete_node(b.children[i]);
+            }
+        }
+
+        throw std::invalid_argument(what);
+    };
+
+    for(; first != last; ++first) {
+        const std::uint64_t key { (*first).first };
+        const value_type    value ( (*first).second );
+        unsigned            level { 0 };
+
+        if((key >> (6 * depth)) != 0) {
+            fail("bulk_load: key deeper than depth");
+        }
+
+        if(any) {
+            if(key < prev) {
+                fail("bulk_load: keys not sorted");
+            }
+
+            if(prev == key) {
+                open[depth - 1].values[open[depth - 1].v_amnt - 1] = value;
+                continue;
+            }
+
+            while(position(prev, level) == position(key, level)) {
+                ++level;
+            }
+
+            for(unsigned l=depth - 1; l>level; --l) {
+                close(l);
+            }
+        }
+
+        for(unsigned l=level; l<depth; ++l) {
+            builder & b = open[l];
+            const std::uint64_t bit { std::uint64_t { 1 } << position(key, l) };
+
+            b.chiset |= bit;
+
+            if(l + 1 < depth) {
+                b.inv_leaf |= bit;
+                b.values[b.v_amnt++] = value_type { };
+            } else {
+                b.values[b.v_amnt++] = value;
+            }
+        }
+
+        prev = key;
+        any  = true;
+    }
+
+    if(! any) {
+        return;
+    }
+
+    for(unsigned l=depth - 1; l>0; --l) {
+        close(l);
+    }
+
+    t.assign(open[0].chiset, open[0].inv_leaf, open[0].values, open[0].children);
+}
+
+/*
+ * sort pairs in parallel unless they are sorted by key already, then
+ * bulk load them
+ * sorted = true skips the is_sorted pass, keys out of order still throw
+ */
+template <typename Tree, typename Pair>
+void bulk_load(Tree & t, std::vector<Pair> & pairs, const unsigned depth, const bool sorted = false)
+{
+    const auto by_key = [](const Pair & a, const Pair & b) { return a.first < b.first; };
+
+    if(! sorted && ! std::is_sorted(pairs.begin(), pairs.end(), by_key)) {
+        parallel_sort(pairs.begin(), pairs.end());
+    }
+
+    bulk_load(t, pairs.begin(), pairs.end(), depth);
+}
+
+};
+
+#endif
@@ -0,0 +1,480 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef HCKT_CONCURRENT_TREE_H
+#define HCKT_CONCURRENT_TREE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "allocator.hpp"
+#include "cow_node.hpp"
+#include "morton.hpp"
+#include "traversal.hpp"
+
+namespace hckt
+{
+
+/*
+ * tree for many concurrent readers and one writer
+ *
+ * nodes are never modified once published: the writer copies the nodes
+ * on the path to the change and swaps the root pointer, so a reader sees
+ * either the whole update or none of it
+ *
+ * readers announce the epoch they started in before loading the root,
+ * which is one load and one store, they never wait on the writer or
+ * on each other; replaced nodes are kept until every reader that could
+ * still hold them has left its epoch and are then freed by the writer
+ *
+ * all writes have to come from one thread at a time, only that thread
+ * allocates and frees, so Alloc does not need to be thread safe unless
+ * it is shared with other threads
+ */
+template <typename T, typename Alloc = hckt::heap_allocator>
+class concurrent_tree
+{
+typedef T value_type;
+
+public:
+    typedef cow_node<T> node_type;
+
+private:
+    static constexpr std::uint64_t idle { ~std::uint64_t { 0 } };
+
+    struct reader_slot
+    {
+        std::atomic<std::uint64_t> epoch; //epoch pinned by the reader, idle if none
+        std::atomic<bool>          used;
+        char                       pad[64 - sizeof(std::atomic<std::uint64_t>) - sizeof(std::atomic<bool>)]; //one cache line each
+
+        reader_slot() : epoch { idle }, used { false }, pad { }
+        {
+        }
+    };
+
+    struct retired_node
+    {
+        std::uint64_t     epoch;
+        const node_type * node;
+    };
+
+    typedef cow_draft<T> draft;
+
+    std::atomic<const node_type*>  root_node;
+    std::atomic<std::uint64_t>     global_epoch;
+    std::unique_ptr<reader_slot[]> slots;
+    unsigned                       slot_amnt;
+    std::vector<retired_node>      retired;
+
+    static const node_type * make_node(const draft & d)
+    {
+        if(d.chiset == 0) {
+            return node_type::empty();
+        }
+
+        return d.write(Alloc::allocate(d.bytes()));
+    }
+
+    static void free_node(const node_type * n)
+    {
+        if(n != node_type::empty()) {
+            Alloc::deallocate(const_cast<node_type*>(n), node_type::bytes(n->children_amnt(), n->value_amount()));
+        }
+    }
+
+    static void free_subtree(const node_type * n)
+    {
+        for(postorder_iterator<const node_type> it { *n }, end { }; it != end; ) {
+            const node_type & node = *it;
+            ++it;
+            free_node(&node);
+        }
+    }
+
+    void retire(const node_type * n, const std::uint64_t epoch)
+    {
+        if(n != node_type::empty()) {
+            retired.push_back(retired_node { epoch, n });
+        }
+    }
+
+    void retire_subtree(const node_type * n, const std::uint64_t epoch)
+    {
+        for(const node_type & node : hckt::preorder(*n)) {
+            retire(&node, epoch);
+        }
+    }
+
+    /*
+     * swap in the new root and hand the replaced nodes to reclamation
+     * nodes retired in epoch e are unreachable for every reader that
+     * pins e + 1 or later
+     */
+    void publish(const node_type * new_root, const node_type * const * old, const unsigned amnt, const node_type * dropped)
+    {
+        root_node.store(new_root);
+
+        const std::uint64_t epoch { global_epoch.load() };
+
+        for(unsigned i=0; i<amnt; ++i) {
+            retire(old[i], epoch);
+        }
+
+        if(dropped != nullptr) {
+            retire_subtree(dropped, epoch);
+        }
+
+        global_epoch.store(epoch + 1);
+        collect();
+    }
+
+    reader_slot * acquire_slot()
+    {
+        for(unsigned i=0; i<slot_amnt; ++i) {
+            bool expected { false };
+
+            if(slots[i].used.compare_exchange_strong(expected, true)) {
+                return &slots[i];
+            }
+        }
+
+        throw std::runtime_error("hckt: all reader slots of the concurrent tree are taken");
+    }
+
+public:
+    class reader;
+
+    /*
+     * root as seen by one reader, valid until the guard is destroyed
+     */
+    class read_guard
+    {
+        reader_slot *     slot;
+        const node_type * r;
+
+        friend class reader;
+
+        read_guard(reader_slot * slot, const node_type * r) : slot { slot }, r { r }
+        {
+        }
+
+    public:
+        read_guard(read_guard && other) : slot { other.slot }, r { other.r }
+        {
+            other.slot = nullptr;
+        }
+
+        read_guard(const read_guard &) = delete;
+        read_guard & operator=(const read_guard &) = delete;
+
+        ~read_guard()
+        {
+            if(slot != nullptr) {
+                slot->epoch.store(idle, std::memory_order_release);
+            }
+        }
+
+        const node_type & root() const
+        {
+            return *r;
+        }
+    };
+
+    /*
+     * registration of one reading thread, holds a slot of the tree
+     * a reader is used by one thread and pins one root at a time
+     */
+    class reader
+    {
+        concurrent_tree & t;
+        reader_slot *     slot;
+
+    public:
+        explicit reader(concurrent_tree & t) : t ( t ), slot { t.acquire_slot() }
+        {
+        }
+
+        ~reader()
+        {
+            slot->epoch.store(idle);
+            slot->used.store(false);
+        }
+
+        reader(const reader &) = delete;
+        reader & operator=(const reader &) = delete;
+
+        /*
+         * the writer tests the slot after swapping the root, so either
+         * it sees this epoch and keeps the old nodes or the root loaded
+         * below is already the new one
+         */
+        read_guard pin()
+        {
+            assert(slot->epoch.load(std::memory_order_relaxed) == idle);
+
+            slot->epoch.store(t.global_epoch.load());
+
+            return read_guard { slot, t.root_node.load() };
+        }
+
+        /*
+         * copy of the value find() returns, false if nothing is set there
+         */
+        bool find(const std::uint64_t x, const std::uint64_t y, const unsigned depth, value_type & value)
+        {
+            const read_guard g { pin() };
+            const value_type * v { g.root().find(x, y, depth) };
+
+            if(v != nullptr) {
+                value = *v;
+            }
+
+            return v != nullptr;
+        }
+
+        bool find(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth, value_type & value)
+        {
+            const read_guard g { pin() };
+            const value_type * v { g.root().find(x, y, z, depth) };
+
+            if(v != nullptr) {
+                value = *v;
+            }
+
+            return v != nullptr;
+        }
+    };
+
+    /*
+     * max_readers reader objects can exist at the same time
+     */
+    explicit concurrent_tree(const unsigned max_readers = 64)
+        : root_node    { node_type::empty() }
+        , global_epoch { 0 }
+        , slots        { new reader_slot[max_readers] }
+        , slot_amnt    { max_readers }
+        , retired      { }
+    {
+    }
+
+    /*
+     * no reader may be left
+     */
+    ~concurrent_tree()
+    {
+        for(const retired_node & r : retired) {
+            free_node(r.node);
+        }
+
+        free_subtree(root_node.load());
+    }
+
+    concurrent_tree(const concurrent_tree &) = delete;
+    concurrent_tree & operator=(const concurrent_tree &) = delete;
+
+    /*
+     * current root, for the writing thread only
+     */
+    const node_type & root() const
+    {
+        return *root_node.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * set the value of a cell like tree::insert, creating nodes along
+     * the way
+     */
+    void insert(const std::uint64_t x, const std::uint64_t y, const value_type value, const unsigned depth)
+    {
+        hckt::morton::path<2> p { x, y, depth };
+        insert_path(p, value);
+    }
+
+    void insert(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const value_type value, const unsigned depth)
+    {
+        hckt::morton::path<3> p { x, y, z, depth };
+        insert_path(p, value);
+    }
+
+    /*
+     * remove the position find() would return, with its subtree
+     * false if nothing is set there
+     */
+    bool erase(const std::uint64_t x, const std::uint64_t y, const unsigned depth)
+    {
+        hckt::morton::path<2> p { x, y, depth };
+        return erase_path(p);
+    }
+
+    bool erase(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth)
+    {
+        hckt::morton::path<3> p { x, y, z, depth };
+        return erase_path(p);
+    }
+
+    template <typename Path>
+    void insert_path(Path & p, const value_type value)
+    {
+        assert(! p.done());
+
+        const node_type * old[morton::max_depth_3d];
+        unsigned          positions[morton::max_depth_3d];
+        unsigned          amnt { 0 };
+        const node_type * node { root_node.load(std::memory_order_relaxed) };
+
+        //old nodes on the path, the empty node where none exists yet
+        while(true) {
+            const unsigned pos { p.next() };
+
+            old[amnt]       = node;
+            positions[amnt] = pos;
+            ++amnt;
+
+            if(p.done()) {
+                break;
+            }
+
+            node = node->is_set(pos) && ! node->is_leaf(pos) ? node->child(pos) : node_type::empty();
+        }
+
+        //copies bottom up, a leaf split on the way keeps its value
+        const node_type * built { nullptr };
+
+        for(unsigned l=amnt; l-- > 0; ) {
+            draft d { *old[l] };
+
+            if(l + 1 == amnt) {
+                if(old[l]->is_set(positions[l]) && ! old[l]->is_leaf(positions[l])) {
+                    d.values[positions[l]] = value;
+                } else {
+                    d.set_leaf(positions[l], value);
+                }
+            } else {
+                d.set_child(positions[l], built);
+            }
+
+            built = make_node(d);
+        }
+
+        publish(built, old, amnt, nullptr);
+    }
+
+    template <typename Path>
+    bool erase_path(Path & p)
+    {
+        assert(! p.done());
+
+        const node_type * old[morton::max_depth_3d];
+        unsigned          positions[morton::max_depth_3d];
+        unsigned          amnt { 0 };
+        const node_type * node { root_node.load(std::memory_order_relaxed) };
+
+        while(true) {
+            const unsigned pos { p.next() };
+
+            if(! node->is_set(pos)) {
+                return false;
+            }
+
+            old[amnt]       = node;
+            positions[amnt] = pos;
+            ++amnt;
+
+            if(p.done() || node->is_leaf(pos)) {
+                break;
+            }
+
+            node = node->child(pos);
+        }
+
+        const unsigned    last    { positions[amnt - 1] };
+        const node_type * dropped { old[amnt - 1]->is_leaf(last) ? nullptr : old[amnt - 1]->child(last) };
+        const node_type * built   { nullptr };
+
+        for(unsigned l=amnt; l-- > 0; ) {
+            draft d { *old[l] };
+
+            if(l + 1 == amnt) {
+                d.unset(positions[l]);
+            } else {
+                d.set_child(positions[l], built);
+            }
+
+            built = make_node(d);
+        }
+
+        publish(built, old, amnt, dropped);
+        return true;
+    }
+
+    /*
+     * free every retired node no reader can reach anymore
+     * runs after each write, call it when writes stop to drain the rest
+     */
+    void collect()
+    {
+        std::uint64_t oldest { idle };
+
+        for(unsigned i=0; i<slot_amnt; ++i) {
+            const std::uint64_t e { slots[i].epoch.load() };
+
+            if(e < oldest) {
+                oldest = e;
+            }
+        }
+
+        std::size_t kept { 0 };
+
+        for(const retired_node & r : retired) {
+            if(r.epoch < oldest) {
+                free_node(r.node);
+            } else {
+                retired[kept++] = r;
+            }
+        }
+
+        retired.resize(kept);
+    }
+
+    /*
+     * nodes waiting for readers to move on
+     */
+    std::size_t retired_amnt() const
+    {
+        return retired.size();
+    }
+};
+
+template <typename T, typename Alloc>
+constexpr std::uint64_t concurrent_tree<T, Alloc>::idle;
+
+};
+
+#endif
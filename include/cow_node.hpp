@@ -0,0 +1,311 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef HCKT_COW_NODE_H
+#define HCKT_COW_NODE_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "morton.hpp"
+#include "util.hpp"
+
+namespace hckt
+{
+
+/*
+ * immutable node of concurrent_tree and persistent_tree, one block per node
+ *
+ *   chiset | inv_leaf | children[children_amnt] | values[value_amount]
+ *
+ * offers the read only tree interface, so everything written against it
+ * (find_batch, range queries, traversals, ...) runs on a pinned root
+ */
+template <typename T>
+class cow_node
+{
+typedef T value_type;
+
+static_assert(std::is_trivially_copyable<T>::value, "nodes are copied bytewise");
+static_assert(alignof(T) <= alignof(std::uint64_t), "values are placed after 8 byte aligned pointers");
+
+public:
+    std::uint64_t chiset;   //is child set to this position
+    std::uint64_t inv_leaf; //opposite of leaf
+
+    static std::size_t bytes(const unsigned c_amnt, const unsigned v_amnt)
+    {
+        return sizeof(cow_node) + c_amnt * sizeof(cow_node*) + v_amnt * sizeof(value_type);
+    }
+
+    /*
+     * shared by every empty node, never freed
+     */
+    static const cow_node * empty()
+    {
+        static const cow_node e { 0x0000000000000000, 0xFFFFFFFFFFFFFFFF };
+        return &e;
+    }
+
+    const cow_node * const * children() const
+    {
+        return reinterpret_cast<const cow_node * const *>(this + 1);
+    }
+
+    const value_type * values() const
+    {
+        return reinterpret_cast<const value_type*>(children() + children_amnt());
+    }
+
+    std::uint64_t chidist() const
+    {
+        return chiset & inv_leaf;
+    }
+
+    std::uint64_t set_mask() const
+    {
+        return chiset;
+    }
+
+    std::uint64_t leaf_mask() const
+    {
+        return chiset & ~inv_leaf;
+    }
+
+    unsigned children_amnt() const
+    {
+        return hckt::popcount(chidist());
+    }
+
+    unsigned leaf_amnt() const
+    {
+        return hckt::popcount(~inv_leaf);
+    }
+
+    unsigned value_amount() const
+    {
+        return hckt::popcount(chiset);
+    }
+
+    unsigned get_children_position(const unsigned position) const
+    {
+        return hckt::rank(chidist(), position);
+    }
+
+    unsigned get_value_position(const unsigned position) const
+    {
+        return hckt::rank(chiset, position);
+    }
+
+    bool has_children() const
+    {
+        return chiset != 0;
+    }
+
+    bool is_set(const unsigned position) const
+    {
+        assert(position < 64);
+        return (chiset >> position) & 1;
+    }
+
+    bool is_leaf(const unsigned position) const
+    {
+        assert(position < 64);
+        return !((inv_leaf >> position) & 1);
+    }
+
+    const cow_node * child(const unsigned position) const
+    {
+        assert(position < 64);
+        assert(is_set(position));
+        assert(! is_leaf(position));
+
+        return children()[get_children_position(position)];
+    }
+
+    const cow_node * child_at(const unsigned cpos) const
+    {
+        assert(cpos < children_amnt());
+
+        return children()[cpos];
+    }
+
+    const void * child_address(const unsigned position) const
+    {
+        return children() + get_children_position(position);
+    }
+
+    value_type get_value(const unsigned position) const
+    {
+        assert(position < 64);
+
+        return values()[get_value_position(position)];
+    }
+
+    /*
+     * value stored for the cell, or nullptr if nothing is set there
+     * a leaf above the requested depth covers the cell and is returned
+     */
+    const value_type * find(const std::uint64_t x, const std::uint64_t y, const unsigned depth) const
+    {
+        hckt::morton::path<2> p { x, y, depth };
+        return find_path(p);
+    }
+
+    const value_type * find(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth) const
+    {
+        hckt::morton::path<3> p { x, y, z, depth };
+        return find_path(p);
+    }
+
+    template <typename Path>
+    const value_type * find_path(Path & p) const
+    {
+        assert(! p.done());
+
+        const cow_node * node { this };
+
+        while(true) {
+            const unsigned pos { p.next() };
+
+            if(! node->is_set(pos)) {
+                return nullptr;
+            }
+
+            if(p.done() || node->is_leaf(pos)) {
+                return node->values() + node->get_value_position(pos);
+            }
+
+            node = node->child(pos);
+        }
+    }
+};
+
+/*
+ * node being rebuilt from a cow_node, arrays are indexed by position
+ */
+template <typename T>
+struct cow_draft
+{
+    typedef T           value_type;
+    typedef cow_node<T> node_type;
+
+    std::uint64_t     chiset;
+    std::uint64_t     inv_leaf;
+    value_type        values[64];
+    const node_type * children[64];
+
+    explicit cow_draft(const node_type & n) : chiset { n.chiset }, inv_leaf { n.inv_leaf }, values { }, children { }
+    {
+        unsigned vpos { 0 };
+        unsigned cpos { 0 };
+
+        for(std::uint64_t set=chiset; set != 0; set &= set - 1) {
+            const unsigned pos ( __builtin_ctzll(set) );
+
+            values[pos] = n.values()[vpos++];
+
+            if(! n.is_leaf(pos)) {
+                children[pos] = n.children()[cpos++];
+            }
+        }
+    }
+
+    std::uint64_t chidist() const
+    {
+        return chiset & inv_leaf;
+    }
+
+    bool is_set(const unsigned pos) const
+    {
+        return (chiset >> pos) & 1;
+    }
+
+    bool is_leaf(const unsigned pos) const
+    {
+        return !((inv_leaf >> pos) & 1);
+    }
+
+    void set_leaf(const unsigned pos, const value_type value)
+    {
+        chiset   |= std::uint64_t { 1 } << pos;
+        inv_leaf &= ~(std::uint64_t { 1 } << pos);
+        values[pos] = value;
+    }
+
+    /*
+     * interior position, a new one gets a default constructed value
+     */
+    void set_child(const unsigned pos, const node_type * child)
+    {
+        if(! is_set(pos)) {
+            values[pos] = value_type { };
+        }
+
+        chiset   |= std::uint64_t { 1 } << pos;
+        inv_leaf |= std::uint64_t { 1 } << pos;
+        children[pos] = child;
+    }
+
+    void unset(const unsigned pos)
+    {
+        chiset   &= ~(std::uint64_t { 1 } << pos);
+        inv_leaf |= std::uint64_t { 1 } << pos;
+    }
+
+    std::size_t bytes() const
+    {
+        return node_type::bytes(hckt::popcount(chidist()), hckt::popcount(chiset));
+    }
+
+    /*
+     * write the node into bytes() of memory
+     */
+    const node_type * write(void * mem) const
+    {
+        node_type *        n { static_cast<node_type*>(mem) };
+        const node_type ** c { reinterpret_cast<const node_type**>(n + 1) };
+        value_type *       v { reinterpret_cast<value_type*>(c + hckt::popcount(chidist())) };
+
+        n->chiset   = chiset;
+        n->inv_leaf = inv_leaf;
+
+        for(std::uint64_t set=chidist(); set != 0; set &= set - 1) {
+            *c++ = children[__builtin_ctzll(set)];
+        }
+
+        for(std::uint64_t set=chiset; set != 0; set &= set - 1) {
+            std::memcpy(v++, &values[__builtin_ctzll(set)], sizeof(value_type));
+        }
+
+        return n;
+    }
+};
+
+};
+
+#endif
@@ -0,0 +1,315 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_CURSOR_H
+#define HCKT_CURSOR_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "morton.hpp"
+
+namespace hckt
+{
+
+/*
+ * finger into a tree for spatially coherent access
+ *
+ * a cursor sits on one cell at a fixed depth and keeps the nodes and
+ * positions of the path from the root down to it; moving to another cell
+ * climbs only to the lowest common ancestor of both cells and descends
+ * from there, so walking a scanline or neighbouring voxels visits O(1)
+ * nodes per step amortized instead of depth
+ *
+ * the lowest common ancestor is where the morton keys of the two cells
+ * first differ, ie. the highest bit of their xor, which is also the
+ * highest bit of the or of the per axis xors, so no key is built
+ *
+ * like find(), a leaf above the cursor depth covers the cell
+ * changing the tree other than through the cursor invalidates it, call
+ * reset() afterwards
+ */
+template <typename Tree, unsigned Dim = 2>
+class cursor
+{
+static_assert(Dim == 2 || Dim == 3, "nodes map either 2d or 3d coordinates");
+
+typedef typename std::remove_cv<typename std::remove_reference<decltype(std::declval<Tree &>().get_value(0))>::type>::type value_type;
+
+    static constexpr unsigned axis_bits { 6 / Dim };
+    static constexpr unsigned max_depth { Dim == 2 ? hckt::morton::max_depth_2d : hckt::morton::max_depth_3d };
+
+    Tree *        nodes[max_depth];     //node of every level down to stop
+    unsigned      positions[max_depth]; //position taken in it
+    std::uint64_t coords[Dim];
+    unsigned      depth;
+    unsigned      stop;                 //level the last walk ended at
+    bool          found;                //whether positions[stop] is set in nodes[stop]
+    std::size_t   visits;
+
+    unsigned position(const unsigned level) const
+    {
+        const unsigned      shift { axis_bits * (depth - 1 - level) };
+        const std::uint64_t mask  { (std::uint64_t { 1 } << axis_bits) - 1 };
+
+        return Dim == 2
+            ? static_cast<unsigned>(hckt::morton::encode_2d((coords[0] >> shift) & mask, (coords[1] >> shift) & mask))
+            : static_cast<unsigned>(hckt::morton::encode_3d((coords[0] >> shift) & mask, (coords[1] >> shift) & mask, (coords[Dim - 1] >> shift) & mask));
+    }
+
+    /*
+     * walk from nodes[level], which has to be on the path of coords
+     */
+    void descend(unsigned level)
+    {
+        Tree * node { nodes[level] };
+
+        while(true) {
+            const unsigned pos { position(level) };
+
+            nodes[level]     = node;
+            positions[level] = pos;
+            ++visits;
+
+            if(! node->is_set(pos)) {
+                stop  = level;
+                found = false;
+                return;
+            }
+
+            if(level + 1 == depth || node->is_leaf(pos)) {
+                stop  = level;
+                found = true;
+                return;
+            }
+
+            node = node->child(pos);
+            ++level;
+        }
+    }
+
+    /*
+     * level of the node the new coordinates share with the cached path
+     * diff is the or of the per axis xors of old and new coordinates
+     */
+    unsigned shared_level(const std::uint64_t diff) const
+    {
+        if(diff == 0) {
+            return stop;
+        }
+
+        const unsigned bit   { 63u - static_cast<unsigned>(__builtin_clzll(diff)) };
+        const unsigned above { bit / axis_bits + 1 }; //levels from the bottom that change
+
+        if(above >= depth) {
+            return 0;
+        }
+
+        const unsigned level { depth - above };
+
+        return level < stop ? level : stop;
+    }
+
+public:
+    /*
+     * starts on cell 0
+     */
+    cursor(Tree & root, const unsigned depth)
+        : nodes     { }
+        , positions { }
+        , coords    { }
+        , depth     { depth }
+        , stop      { 0 }
+        , found     { false }
+        , visits    { 0 }
+    {
+        assert(depth > 0 && depth <= max_depth);
+
+        nodes[0] = &root;
+        descend(0);
+    }
+
+    /*
+     * walk again from the root, after the tree changed behind our back
+     */
+    void reset()
+    {
+        descend(0);
+    }
+
+    /*
+     * move to a cell, true if a value covers it
+     */
+    bool move(const std::uint64_t x, const std::uint64_t y)
+    {
+        static_assert(Dim == 2, "2d cursor takes x and y");
+
+        const std::uint64_t diff { (coords[0] ^ x) | (coords[1] ^ y) };
+
+        coords[0] = x;
+        coords[1] = y;
+
+        if(diff != 0) {
+            descend(shared_level(diff));
+        }
+
+        return found;
+    }
+
+    bool move(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z)
+    {
+        static_assert(Dim == 3, "3d cursor takes x, y and z");
+
+        const std::uint64_t diff { (coords[0] ^ x) | (coords[1] ^ y) | (coords[Dim - 1] ^ z) };
+
+        coords[0]       = x;
+        coords[1]       = y;
+        coords[Dim - 1] = z;
+
+        if(diff != 0) {
+            descend(shared_level(diff));
+        }
+
+        return found;
+    }
+
+    /*
+     * move relative to the current cell, coordinates wrap
+     */
+    bool step(const std::int64_t dx, const std::int64_t dy)
+    {
+        return move(coords[0] + static_cast<std::uint64_t>(dx), coords[1] + static_cast<std::uint64_t>(dy));
+    }
+
+    bool step(const std::int64_t dx, const std::int64_t dy, const std::int64_t dz)
+    {
+        return move(coords[0] + static_cast<std::uint64_t>(dx), coords[1] + static_cast<std::uint64_t>(dy), coords[Dim - 1] + static_cast<std::uint64_t>(dz));
+    }
+
+    /*
+     * true if a value covers the current cell
+     */
+    bool has_value() const
+    {
+        return found;
+    }
+
+    /*
+     * value covering the current cell, has_value() has to be true
+     */
+    value_type value() const
+    {
+        assert(found);
+
+        return nodes[stop]->get_value(positions[stop]);
+    }
+
+    /*
+     * level the covering value is stored at, depth - 1 unless a leaf
+     * above the cursor depth covers the cell
+     */
+    unsigned level() const
+    {
+        return stop;
+    }
+
+    std::uint64_t x() const
+    {
+        return coords[0];
+    }
+
+    std::uint64_t y() const
+    {
+        return coords[1];
+    }
+
+    std::uint64_t z() const
+    {
+        static_assert(Dim == 3, "2d cursor has no z");
+        return coords[Dim - 1];
+    }
+
+    /*
+     * nodes visited by every walk so far, for benchmarking
+     */
+    std::size_t visited() const
+    {
+        return visits;
+    }
+
+    /*
+     * set the value of the current cell like insert_path, starting at
+     * the cached path instead of the root
+     * nodes are only added below the node the last walk ended in, so the
+     * cached nodes stay valid for every tree type
+     */
+    void insert(const value_type value)
+    {
+        unsigned level { stop };
+        Tree *   node  { nodes[stop] };
+
+        while(true) {
+            const unsigned pos { positions[level] };
+
+            if(level + 1 == depth) {
+                if(node->is_set(pos)) {
+                    node->set_value(pos, value);
+                } else {
+                    node->insert_leaf(pos, value);
+                }
+
+                break;
+            }
+
+            if(! node->is_set(pos)) {
+                node->insert(pos, value_type { });
+            } else if(node->is_leaf(pos)) {
+                const value_type v { node->get_value(pos) };
+                node->remove(pos);
+                node->insert(pos, v);
+            }
+
+            node = node->child(pos);
+            ++level;
+
+            nodes[level]     = node;
+            positions[level] = position(level);
+        }
+
+        stop  = level;
+        found = true;
+    }
+};
+
+template <typename Tree, unsigned Dim>
+constexpr unsigned cursor<Tree, Dim>::axis_bits;
+
+template <typename Tree, unsigned Dim>
+constexpr unsigned cursor<Tree, Dim>::max_depth;
+
+};
+
+#endif
@@ -0,0 +1,490 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_FROZEN_TREE_H
+#define HCKT_FROZEN_TREE_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "traversal.hpp"
+#include "util.hpp"
+
+namespace hckt
+{
+
+/*
+ * node of a frozen tree, laid out in one flat buffer as
+ *
+ *   chiset | inv_leaf | child offsets (u32)[children_amnt] | pad | values[value_amount]
+ *
+ * child offsets are signed 32 bit counts of 8 byte words from the node
+ * itself, so the buffer is position independent and can be mapped
+ * straight from disk
+ * nodes are in DFS preorder, every empty subtree points at one shared
+ * empty node at the end of the buffer; a deduplicated buffer stores each
+ * distinct subtree once and later copies point back at the first one
+ */
+template <typename T>
+class frozen_node
+{
+typedef T value_type;
+
+static_assert(std::is_trivially_copyable<T>::value, "frozen values are copied bytewise");
+static_assert(alignof(T) <= alignof(std::uint64_t), "nodes are 8 byte aligned");
+
+public:
+    std::uint64_t chiset;   //is child set to this position
+    std::uint64_t inv_leaf; //opposite of leaf
+
+    static constexpr std::size_t word { sizeof(std::uint64_t) };
+
+    static std::size_t values_offset(const unsigned c_amnt)
+    {
+        return (sizeof(frozen_node) + c_amnt * sizeof(std::uint32_t) + alignof(value_type) - 1) & ~(alignof(value_type) - 1);
+    }
+
+    /*
+     * size of a node record in 8 byte words
+     */
+    static std::size_t words(const unsigned c_amnt, const unsigned v_amnt)
+    {
+        return (values_offset(c_amnt) + v_amnt * sizeof(value_type) + word - 1) / word;
+    }
+
+    std::uint64_t chidist() const
+    {
+        return chiset & inv_leaf;
+    }
+
+    std::uint64_t set_mask() const
+    {
+        return chiset;
+    }
+
+    std::uint64_t leaf_mask() const
+    {
+        return chiset & ~inv_leaf;
+    }
+
+    unsigned children_amnt() const
+    {
+        return hckt::popcount(chidist());
+    }
+
+    unsigned leaf_amnt() const
+    {
+        return hckt::popcount(~inv_leaf);
+    }
+
+    unsigned value_amount() const
+    {
+        return hckt::popcount(chiset);
+    }
+
+    unsigned get_children_position(const unsigned position) const
+    {
+        return hckt::rank(chidist(), position);
+    }
+
+    unsigned get_value_position(const unsigned position) const
+    {
+        return hckt::rank(chiset, position);
+    }
+
+    bool has_children() const
+    {
+        return chiset != 0;
+    }
+
+    bool is_set(const unsigned position) const
+    {
+        assert(position < 64);
+        return (chiset >> position) & 1;
+    }
+
+    bool is_leaf(const unsigned position) const
+    {
+        assert(position < 64);
+        return !((inv_leaf >> position) & 1);
+    }
+
+    const std::uint32_t * offsets() const
+    {
+        return reinterpret_cast<const std::uint32_t*>(this + 1);
+    }
+
+    const value_type * values() const
+    {
+        return reinterpret_cast<const value_type*>(reinterpret_cast<const char*>(this) + values_offset(children_amnt()));
+    }
+
+    /*
+     * get child node
+     * position should be result of get_position
+     */
+    const frozen_node * child(const unsigned position) const
+    {
+        assert(position < 64);
+        assert(is_set(position));
+        assert(! is_leaf(position));
+
+        const std::uint64_t * self { reinterpret_cast<const std::uint64_t*>(this) };
+
+        return reinterpret_cast<const frozen_node*>(self + static_cast<std::int32_t>(offsets()[get_children_position(position)]));
+    }
+
+    /*
+     * get child by its index among the children, they are in position order
+     */
+    const frozen_node * child_at(const unsigned cpos) const
+    {
+        assert(cpos < children_amnt());
+
+        return reinterpret_cast<const frozen_node*>(reinterpret_cast<const std::uint64_t*>(this) + static_cast<std::int32_t>(offsets()[cpos]));
+    }
+
+    /*
+     * address child(position) reads its offset from, for prefetching
+     */
+    const void * child_address(const unsigned position) const
+    {
+        return offsets() + get_children_position(position);
+    }
+
+    /*
+     * gets value from specific position
+     * position should be result of get_position
+     */
+    value_type get_value(const unsigned position) const
+    {
+        assert(position < 64);
+
+        return values()[get_value_position(position)];
+    }
+
+    std::size_t calculate_children_amnt() const
+    {
+        std::size_t amount { 0 };
+
+        for(const frozen_node & node : hckt::preorder(*this)) {
+            amount += node.children_amnt();
+        }
+
+        return amount;
+    }
+
+    std::size_t calculate_leaf_amount() const
+    {
+        std::size_t amount { 0 };
+
+        for(const frozen_node & node : hckt::preorder(*this)) {
+            amount += node.leaf_amnt();
+        }
+
+        return amount;
+    }
+};
+
+template <typename T>
+constexpr std::size_t frozen_node<T>::word;
+
+/*
+ * immutable tree stored in one contiguous buffer
+ * offers the read only part of the tree interface and forwards it to the
+ * root node, child() hands out frozen_node pointers
+ */
+template <typename T>
+class frozen_tree
+{
+typedef T value_type;
+typedef frozen_node<T> node_type;
+
+protected:
+    std::vector<std::uint64_t> buf;
+
+    /*
+     * nodes are written in preorder, each one patching its offset into
+     * the slot of its parent, which is still open one level up
+     */
+    struct builder
+    {
+        std::vector<std::uint64_t> & out;
+        std::vector<std::size_t>     empty_refs; //(node, slot) pairs that point at the empty node
+
+        struct open_node
+        {
+            std::size_t at;   //word offset of the node
+            unsigned    cpos; //next child slot to fill
+        };
+
+        template <typename Node>
+        std::size_t emit_node(const Node & n)
+        {
+            const std::uint64_t c_dist { n.chidist() };
+            const unsigned      c_amnt { hckt::popcount(c_dist) };
+            const unsigned      v_amnt { n.value_amount() };
+            const std::size_t   at     { out.size() };
+
+            out.resize(at + node_type::words(c_amnt, v_amnt), 0);
+
+            const std::uint64_t chiset { n.set_mask() };
+            unsigned            vpos   { 0 };
+
+            for(std::uint64_t set=chiset; set != 0; set &= set - 1) {
+                const value_type v { n.get_value(__builtin_ctzll(set)) };
+                std::memcpy(reinterpret_cast<char*>(&out[at]) + node_type::values_offset(c_amnt) + vpos * sizeof(value_type), &v, sizeof(value_type));
+                ++vpos;
+            }
+
+            out[at]     = chiset;
+            out[at + 1] = ~n.leaf_mask();
+
+            return at;
+        }
+
+        /*
+         * number every node so that two nodes get the same id exactly when
+         * their subtrees are equal, bottom up: a node is keyed by its masks,
+         * its values and the ids of its children
+         */
+        template <typename Node>
+        static void identify(const Node & root, std::unordered_map<const Node*, std::uint32_t> & ids)
+        {
+            std::unordered_map<std::string, std::uint32_t> known;
+            std::string key;
+
+            for(const Node & n : hckt::postorder(root)) {
+                const std::uint64_t masks[2] { n.set_mask(), n.leaf_mask() };
+
+                key.assign(reinterpret_cast<const char*>(masks), sizeof(masks));
+
+                for(std::uint64_t set=masks[0]; set != 0; set &= set - 1) {
+                    const value_type v { n.get_value(__builtin_ctzll(set)) };
+                    key.append(reinterpret_cast<const char*>(&v), sizeof(v));
+                }
+
+                for(unsigned i=0, c_amnt=n.children_amnt(); i<c_amnt; ++i) {
+                    const std::uint32_t id { ids[n.child_at(i)] };
+                    key.append(reinterpret_cast<const char*>(&id), sizeof(id));
+                }
+
+                const std::uint32_t next ( known.size() );
+                ids[&n] = known.emplace(key, next).first->second;
+            }
+        }
+
+        template <typename Node>
+        void emit(const Node & root, const bool dedup)
+        {
+            std::vector<open_node> open;
+
+            std::unordered_map<const Node*, std::uint32_t> ids;
+            std::vector<std::size_t>                       emitted; //word offset of the first copy of each id
+
+            if(dedup) {
+                identify(root, ids);
+                emitted.assign(ids.size(), SIZE_MAX);
+            }
+
+            for(auto it=hckt::preorder(root).begin(), end=hckt::preorder(root).end(); it != end; ++it) {
+                const unsigned level { it.level() };
+
+                open.resize(level);
+
+                if(level == 0) {
+                    open.push_back(open_node { emit_node(*it), 0 });
+                    continue;
+                }
+
+                open_node &       parent = open[level - 1];
+                const std::size_t slot { (parent.at + 2) * 2 + parent.cpos++ };
+                std::int64_t      offset { 0 };
+
+                if(! it->has_children()) {
+                    empty_refs.push_back(parent.at);
+                    empty_refs.push_back(slot);
+                    it.skip_children();
+                } else if(dedup && emitted[ids[&*it]] != SIZE_MAX) {
+                    offset = static_cast<std::int64_t>(emitted[ids[&*it]]) - static_cast<std::int64_t>(parent.at);
+                    it.skip_children();
+                } else {
+                    const std::size_t c_at { emit_node(*it) };
+                    offset = static_cast<std::int64_t>(c_at - parent.at);
+                    open.push_back(open_node { c_at, 0 });
+
+                    if(dedup) {
+                        emitted[ids[&*it]] = c_at;
+                    }
+                }
+
+                assert(offset >= INT32_MIN && offset <= INT32_MAX);
+                const std::uint32_t word { static_cast<std::uint32_t>(static_cast<std::int32_t>(offset)) };
+                std::memcpy(reinterpret_cast<std::uint32_t*>(out.data()) + slot, &word, sizeof(word));
+            }
+        }
+
+        void finish()
+        {
+            const std::size_t empty_at { out.size() };
+            out.push_back(0x0000000000000000);
+            out.push_back(0xFFFFFFFFFFFFFFFF);
+
+            for(std::size_t i=0; i<empty_refs.size(); i += 2) {
+                assert(empty_at - empty_refs[i] <= INT32_MAX);
+                const std::uint32_t offset { static_cast<std::uint32_t>(empty_at - empty_refs[i]) };
+                std::memcpy(reinterpret_cast<std::uint32_t*>(out.data()) + empty_refs[i + 1], &offset, sizeof(offset));
+            }
+        }
+    };
+
+public:
+    frozen_tree() : buf { 0x0000000000000000, 0xFFFFFFFFFFFFFFFF }
+    {
+    }
+
+    /*
+     * build from any tree exposing the read only tree interface
+     * with dedup every distinct subtree is stored once, which costs a
+     * hash table entry per source node while building
+     */
+    template <typename Tree>
+    explicit frozen_tree(const Tree & t, const bool dedup = false) : buf { }
+    {
+        builder b { buf, { } };
+        b.emit(t, dedup);
+        b.finish();
+    }
+
+    const node_type * root() const
+    {
+        return reinterpret_cast<const node_type*>(buf.data());
+    }
+
+    const std::uint64_t * data() const
+    {
+        return buf.data();
+    }
+
+    std::size_t size() const
+    {
+        return buf.size() * sizeof(std::uint64_t);
+    }
+
+    bool has_children() const                               { return root()->has_children(); }
+    bool is_set(const unsigned position) const              { return root()->is_set(position); }
+    bool is_leaf(const unsigned position) const             { return root()->is_leaf(position); }
+    const node_type * child(const unsigned position) const  { return root()->child(position); }
+    value_type get_value(const unsigned position) const     { return root()->get_value(position); }
+    unsigned children_amnt() const                          { return root()->children_amnt(); }
+    unsigned leaf_amnt() const                              { return root()->leaf_amnt(); }
+    unsigned value_amount() const                           { return root()->value_amount(); }
+
+
+    /************************************************
+     *
+     * BENCHMARKING CODE
+     *
+     ***********************************************/
+
+    std::size_t calculate_memory_size() const
+    {
+        return sizeof(frozen_tree) + size();
+    }
+
+    /*
+     * node records in the buffer, the empty node appended for empty
+     * children only counts when it is the root
+     */
+    std::size_t calculate_stored_nodes() const
+    {
+        std::size_t amount { 0 };
+
+        for(std::size_t at=0; at<buf.size(); ++amount) {
+            const node_type * n { reinterpret_cast<const node_type*>(&buf[at]) };
+            at += node_type::words(n->children_amnt(), n->value_amount());
+        }
+
+        return amount > 1 ? amount - 1 : amount;
+    }
+
+    /*
+     * nodes the tree would have without sharing, empty children left out
+     */
+    std::size_t calculate_logical_nodes() const
+    {
+        std::size_t amount { 1 };
+
+        for(const node_type & n : hckt::preorder(*root())) {
+            amount += &n != root() && n.set_mask() != 0;
+        }
+
+        return amount;
+    }
+
+    std::size_t calculate_children_amnt() const
+    {
+        return root()->calculate_children_amnt();
+    }
+
+    std::size_t calculate_leaf_amount() const
+    {
+        return root()->calculate_leaf_amount();
+    }
+
+    void mem_usage_info() const
+    {
+        const std::size_t memsize { calculate_memory_size() };
+        const std::size_t c_amnt  { calculate_children_amnt() };
+        const std::size_t l_amnt  { calculate_leaf_amount() };
+        const std::size_t v_amnt  { c_amnt + l_amnt };
+
+        std::cout << "total:     " << hckt::render_size(memsize) << std::endl;
+
+        std::cout << "node-size: " << hckt::render_size(sizeof(node_type)) << std::endl;
+        std::cout << "val-size:  " << hckt::render_size(sizeof(value_type)) << std::endl;
+
+        std::cout << "values:    " << hckt::render_number(v_amnt) << std::endl;
+        std::cout << "children:  " << hckt::render_number(c_amnt) << std::endl;
+        std::cout << "leaves:    " << hckt::render_number(l_amnt) << std::endl;
+
+        std::cout << "per-val:   " << (static_cast<double>(memsize) / v_amnt) << " B" << std::endl;
+        std::cout << "overhead:  " << ((static_cast<double>(memsize) - static_cast<double>(v_amnt * sizeof(value_type))) / v_amnt) << " B" << std::endl;
+
+        const std::size_t stored  { calculate_stored_nodes() };
+        const std::size_t logical { calculate_logical_nodes() };
+
+        std::cout << "nodes:     " << hckt::render_number(stored) << " stored for " << hckt::render_number(logical) << std::endl;
+        std::cout << "dedup:     " << (static_cast<double>(logical) / stored) << " x" << std::endl;
+    }
+};
+
+};
+
+#endif
@@ -25,42 +25,108 @@
 #ifndef LMEMVECTOR_H
 #define LMEMVECTOR_H
 
+#include <cassert>
 #include <cstdint>
-#include <algorithm>
 #include <cstring>
+#include <type_traits>
+#include "allocator.hpp"
 
 namespace hckt
 {
 
-constexpr unsigned init_capacity { 1 };
+/*
+ * growth policies
+ * capacity is a pure function of size, so a node never has to store it
+ */
+
+/*
+ * smallest capacity filling whole 8 byte allocator size classes
+ * every block of a given element count maps to one size class, which
+ * the pool recycles through its own free list
+ */
+struct exact_growth
+{
+    template <typename T>
+    static unsigned capacity(const unsigned size)
+    {
+        constexpr unsigned granularity { sizeof(std::uint64_t) };
+
+        return size == 0
+            ? 0
+            : static_cast<unsigned>(((size * sizeof(T) + granularity - 1) / granularity * granularity) / sizeof(T));
+    }
+};
 
-#pragma pack
-template <typename T>
+/*
+ * capacities grow in powers of two, filling a 64 slot node takes
+ * 7 allocations instead of 64 at the cost of up to 2x slack
+ */
+struct geometric_growth
+{
+    template <typename T>
+    static unsigned capacity(const unsigned size)
+    {
+        if(size == 0) {
+            return 0;
+        }
+
+        unsigned pow2 { 1 };
+
+        while(pow2 < size) {
+            pow2 <<= 1;
+        }
+
+        const unsigned exact { exact_growth::capacity<T>(size) };
+
+        return pow2 > exact ? pow2 : exact;
+    }
+};
+
+/*
+ * minimal vector for tree nodes
+ * size is not stored, the owning node derives it from its bitsets and
+ * passes it in, capacity is derived from size by the Growth policy
+ * memory comes from the Alloc policy with sized deallocation
+ */
+template <typename T, typename Alloc = hckt::pool_allocator, typename Growth = hckt::exact_growth>
 class lmemvector
 {
 typedef T* iterator;
 typedef T value_type;
 
+static_assert(std::is_trivially_copyable<T>::value, "lmemvector moves values with memcpy");
+
 private:
-    void init()
+    static iterator allocate(const unsigned amnt)
     {
-        iterator nb = new value_type[init_capacity];
-        buf = nb;
+        return static_cast<iterator>(Alloc::allocate(sizeof(value_type) * amnt));
+    }
+
+    static void deallocate(const iterator b, const unsigned amnt)
+    {
+        Alloc::deallocate(b, sizeof(value_type) * amnt);
     }
 
 public:
+    //positions of the widest node, see shape.hpp
+    static constexpr unsigned max_size { 512 };
+
     iterator buf;
 
     lmemvector() : buf { nullptr }
     {}
 
+    /*
+     * memory is returned by the owner through clear(size),
+     * since only the owner knows how large buf is
+     */
     ~lmemvector()
     {
-        if(buf != nullptr) {
-            delete[] buf;
-        }
     }
 
+    lmemvector(const lmemvector &) = delete;
+    lmemvector & operator=(const lmemvector &) = delete;
+
     T operator[](const unsigned n) const
     {
         return buf[n];
@@ -71,52 +137,109 @@ public:
         return buf[n];
     }
 
+    static unsigned capacity(const unsigned size)
+    {
+        return Growth::template capacity<value_type>(size);
+    }
+
     void clear(const unsigned size)
     {
+        if(size != 0) {
+            deallocate(buf, capacity(size));
+        }
+
+        buf = nullptr;
+    }
+
+    /*
+     * fill an empty vector with size elements in one allocation
+     */
+    void assign(const value_type * src, const unsigned size)
+    {
+        assert(buf == nullptr);
+        assert(size <= max_size);
+
         if(size == 0) {
-            buf = nullptr;
             return;
         }
 
-        delete[] buf;
+        buf = allocate(capacity(size));
+        std::memcpy(buf, src, sizeof(value_type) * size);
+    }
+
+    /*
+     * forget buf without freeing it
+     * used when the allocator is released as a whole
+     */
+    void abandon()
+    {
         buf = nullptr;
     }
 
+    /*
+     * remove element at position
+     * size is the amount of elements before erasing
+     */
     void erase(const unsigned position, const unsigned size)
     {
-        assert(position < 64);
-        assert(size < 64);
+        assert(size <= max_size);
+        assert(position < size);
 
-        std::memmove(buf + position, buf + position + 1, sizeof(value_type) * (size + 1 - position));
-    }
+        const unsigned cap     { capacity(size) };
+        const unsigned new_cap { capacity(size - 1) };
 
-    void reserve(const unsigned new_capacity)
-    {
-        assert(new_capacity <= 64);
+        if(new_cap == 0) {
+            clear(size);
+            return;
+        }
+
+        if(new_cap == cap) {
+            std::memmove(buf + position, buf + position + 1, sizeof(value_type) * (size - position - 1));
+            return;
+        }
 
-        iterator nb = new value_type[new_capacity];
-        std::copy(&buf[0], &buf[new_capacity - 1], nb);
-        delete[] buf;
+        //hand the block back to its size class and move down a class
+        iterator nb = allocate(new_cap);
+        std::memcpy(nb, buf, sizeof(value_type) * position);
+        std::memcpy(nb + position, buf + position + 1, sizeof(value_type) * (size - position - 1));
+        deallocate(buf, cap);
         buf = nb;
     }
 
+    /*
+     * insert value before position
+     * size is the amount of elements before inserting
+     */
     void insert(const unsigned position, const value_type value, const unsigned size)
     {
-        assert(position < 64);
-        assert(size < 64);
+        assert(size < max_size);
+        assert(position <= size);
+
+        const unsigned cap { capacity(size) };
+
+        if(size < cap) {
+            const iterator it = &buf[position];
+            std::memmove(it + 1, it, sizeof(value_type) * (size - position));
+            *it = value;
+            return;
+        }
+
+        iterator nb = allocate(capacity(size + 1));
 
         if(buf != nullptr) {
-            reserve(size + 1);
-        } else {
-            init();
+            std::memcpy(nb, buf, sizeof(value_type) * position);
+            std::memcpy(nb + position + 1, buf + position, sizeof(value_type) * (size - position));
+            deallocate(buf, cap);
         }
 
-        const iterator it = &buf[position];
-        std::memmove(it + 1, it, sizeof(value_type) * (size - position));
-        *it = value;
+        nb[position] = value;
+        buf = nb;
     }
 };
 
+template <typename T, typename Alloc, typename Growth>
+constexpr unsigned lmemvector<T, Alloc, Growth>::max_size;
+
 };
 
 #endif
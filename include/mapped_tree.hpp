@@ -0,0 +1,340 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_MAPPED_TREE_H
+#define HCKT_MAPPED_TREE_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "frozen_tree.hpp"
+
+namespace hckt
+{
+
+/*
+ * on disk format, all fields little endian
+ *
+ *   offset size
+ *        0    8  magic "HCKTTREE"
+ *        8    4  version
+ *       12    4  header size (64)
+ *       16    4  dimension (2, 3 or 0 if unspecified)
+ *       20    4  depth
+ *       24    4  value type id, see value_type_id
+ *       28    4  reserved
+ *       32    8  payload size in bytes
+ *       40    8  payload checksum, see checksum64
+ *       48   16  reserved
+ *       64       payload, a frozen_tree buffer
+ *
+ * the payload is position independent, so an mmap of the file is
+ * queried in place without any deserialization
+ */
+namespace file_format
+{
+    constexpr char          magic[8]    { 'H', 'C', 'K', 'T', 'T', 'R', 'E', 'E' };
+    constexpr std::uint32_t version     { 2 }; //2: child offsets are signed, deduplicated payloads point backwards
+    constexpr std::uint32_t min_version { 1 };
+    constexpr std::uint32_t header_size { 64 };
+
+    inline bool host_is_little_endian()
+    {
+        const std::uint32_t probe { 1 };
+        unsigned char first;
+        std::memcpy(&first, &probe, 1);
+        return first == 1;
+    }
+
+    inline void store32(unsigned char * p, const std::uint32_t v)
+    {
+        for(unsigned i=0; i<4; ++i) {
+            p[i] = static_cast<unsigned char>(v >> (8 * i));
+        }
+    }
+
+    inline void store64(unsigned char * p, const std::uint64_t v)
+    {
+        for(unsigned i=0; i<8; ++i) {
+            p[i] = static_cast<unsigned char>(v >> (8 * i));
+        }
+    }
+
+    inline std::uint32_t load32(const unsigned char * p)
+    {
+        std::uint32_t v { 0 };
+
+        for(unsigned i=0; i<4; ++i) {
+            v |= static_cast<std::uint32_t>(p[i]) << (8 * i);
+        }
+
+        return v;
+    }
+
+    inline std::uint64_t load64(const unsigned char * p)
+    {
+        std::uint64_t v { 0 };
+
+        for(unsigned i=0; i<8; ++i) {
+            v |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+        }
+
+        return v;
+    }
+
+    /*
+     * FNV-1a over 64 bit words
+     */
+    inline std::uint64_t checksum64(const std::uint64_t * words, const std::size_t amnt)
+    {
+        constexpr std::uint64_t prime { 0x100000001B3 };
+        std::uint64_t h { 0xCBF29CE484222325 };
+
+        for(std::size_t i=0; i<amnt; ++i) {
+            h = (h ^ words[i]) * prime;
+        }
+
+        return h;
+    }
+};
+
+/*
+ * kind in the high byte (0 unsigned, 1 signed, 2 floating), size in the low byte
+ */
+template <typename T>
+struct value_type_id
+{
+    static constexpr std::uint32_t value {
+          ((std::is_floating_point<T>::value ? 2u : std::is_signed<T>::value ? 1u : 0u) << 8)
+        | static_cast<std::uint32_t>(sizeof(T))
+    };
+};
+
+template <typename T>
+constexpr std::uint32_t value_type_id<T>::value;
+
+/*
+ * write a frozen tree to path
+ * dimension and depth are stored for the reader, the tree itself does not know them
+ */
+template <typename T>
+void write_tree(const std::string & path, const hckt::frozen_tree<T> & f, const unsigned dimension, const unsigned depth)
+{
+    if(! file_format::host_is_little_endian()) {
+        throw std::runtime_error("hckt: tree files are little endian, writing from big endian hosts is not supported");
+    }
+
+    unsigned char header[file_format::header_size] { };
+
+    std::memcpy(header, file_format::magic, sizeof(file_format::magic));
+    file_format::store32(header +  8, file_format::version);
+    file_format::store32(header + 12, file_format::header_size);
+    file_format::store32(header + 16, dimension);
+    file_format::store32(header + 20, depth);
+    file_format::store32(header + 24, value_type_id<T>::value);
+    file_format::store64(header + 32, f.size());
+    file_format::store64(header + 40, file_format::checksum64(f.data(), f.size() / sizeof(std::uint64_t)));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(f.data()), f.size());
+
+    if(! out) {
+        throw std::runtime_error("hckt: could not write " + path);
+    }
+}
+
+/*
+ * freeze and write any tree
+ */
+template <typename Tree>
+void write_tree(const std::string & path, const Tree & t, const unsigned dimension, const unsigned depth, const bool dedup = false)
+{
+    write_tree(path, t.freeze(dedup), dimension, depth);
+}
+
+/*
+ * read only tree backed by a memory mapped file
+ * opening validates the header in O(1), the checksum is only checked by
+ * verify() since it has to touch every page
+ * mappings are shared, so processes opening the same file share page cache
+ */
+template <typename T>
+class mapped_tree
+{
+typedef T value_type;
+typedef frozen_node<T> node_type;
+
+protected:
+    void *        map;
+    std::size_t   map_size;
+    std::uint32_t dim;
+    std::uint32_t dep;
+    std::uint64_t payload_size;
+    std::uint64_t checksum;
+
+    const unsigned char * bytes() const
+    {
+        return static_cast<const unsigned char*>(map);
+    }
+
+    void fail(const std::string & path, const char * reason)
+    {
+        if(map != nullptr) {
+            munmap(map, map_size);
+            map = nullptr;
+        }
+
+        throw std::runtime_error("hckt: " + path + ": " + reason);
+    }
+
+public:
+    explicit mapped_tree(const std::string & path) : map          { nullptr }
+                                                   , map_size     { 0 }
+                                                   , dim          { 0 }
+                                                   , dep          { 0 }
+                                                   , payload_size { 0 }
+                                                   , checksum     { 0 }
+    {
+        if(! file_format::host_is_little_endian()) {
+            fail(path, "tree files are little endian, mapping on big endian hosts is not supported");
+        }
+
+        const int fd { ::open(path.c_str(), O_RDONLY) };
+
+        if(fd < 0) {
+            fail(path, "could not open");
+        }
+
+        struct stat st;
+
+        if(fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < file_format::header_size) {
+            ::close(fd);
+            fail(path, "file too small");
+        }
+
+        map_size = st.st_size;
+        void * m { mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0) };
+        ::close(fd);
+
+        if(m == MAP_FAILED) {
+            fail(path, "mmap failed");
+        }
+
+        map = m;
+
+        const unsigned char * h { bytes() };
+
+        if(std::memcmp(h, file_format::magic, sizeof(file_format::magic)) != 0) {
+            fail(path, "not a hckt tree file");
+        }
+
+        if(file_format::load32(h + 8) < file_format::min_version || file_format::load32(h + 8) > file_format::version) {
+            fail(path, "unsupported version");
+        }
+
+        if(file_format::load32(h + 12) != file_format::header_size) {
+            fail(path, "unexpected header size");
+        }
+
+        if(file_format::load32(h + 24) != value_type_id<T>::value) {
+            fail(path, "value type mismatch");
+        }
+
+        dim          = file_format::load32(h + 16);
+        dep          = file_format::load32(h + 20);
+        payload_size = file_format::load64(h + 32);
+        checksum     = file_format::load64(h + 40);
+
+        if(payload_size % sizeof(std::uint64_t) != 0
+        || payload_size < sizeof(node_type)
+        || payload_size > map_size - file_format::header_size) {
+            fail(path, "truncated payload");
+        }
+    }
+
+    ~mapped_tree()
+    {
+        if(map != nullptr) {
+            munmap(map, map_size);
+        }
+    }
+
+    mapped_tree(const mapped_tree &) = delete;
+    mapped_tree & operator=(const mapped_tree &) = delete;
+
+    /*
+     * compare the payload against the stored checksum, touches every page
+     */
+    bool verify() const
+    {
+        return file_format::checksum64(data(), payload_size / sizeof(std::uint64_t)) == checksum;
+    }
+
+    unsigned dimension() const
+    {
+        return dim;
+    }
+
+    unsigned depth() const
+    {
+        return dep;
+    }
+
+    const std::uint64_t * data() const
+    {
+        return reinterpret_cast<const std::uint64_t*>(bytes() + file_format::header_size);
+    }
+
+    std::size_t size() const
+    {
+        return payload_size;
+    }
+
+    const node_type * root() const
+    {
+        return reinterpret_cast<const node_type*>(data());
+    }
+
+    bool has_children() const                               { return root()->has_children(); }
+    bool is_set(const unsigned position) const              { return root()->is_set(position); }
+    bool is_leaf(const unsigned position) const             { return root()->is_leaf(position); }
+    const node_type * child(const unsigned position) const  { return root()->child(position); }
+    value_type get_value(const unsigned position) const     { return root()->get_value(position); }
+    unsigned children_amnt() const                          { return root()->children_amnt(); }
+    unsigned leaf_amnt() const                              { return root()->leaf_amnt(); }
+    unsigned value_amount() const                           { return root()->value_amount(); }
+};
+
+};
+
+#endif
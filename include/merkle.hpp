@@ -0,0 +1,572 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_MERKLE_H
+#define HCKT_MERKLE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "morton.hpp"
+#include "traversal.hpp"
+
+namespace hckt
+{
+
+/*
+ * merkle hashes, tree diff and deltas
+ *
+ * a node's hash covers its masks, its values and the hashes of its
+ * children, so two subtrees with the same hash hold the same content
+ * and a diff walks only where hashes differ
+ *
+ * a delta lists the positions to insert, change and remove, each by
+ * its path, in preorder so parents come before their children
+ * a path is a key like the ones of bulk_load, 6 bits per level with
+ * the root level in the highest used bits, so deltas reach down to
+ * morton::key_levels
+ */
+enum class delta_op : std::uint8_t
+{
+    insert, //a leaf, or an interior position whose subtree follows
+    change, //new value, the position keeps its kind
+    remove  //the position with its subtree
+};
+
+template <typename T>
+struct delta_entry
+{
+    std::uint64_t key;
+    std::uint8_t  level; //positions in key
+    delta_op      op;
+    bool          leaf;
+    T             value;
+};
+
+namespace detail
+{
+    inline std::uint64_t mix(std::uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccd;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53;
+        h ^= h >> 33;
+
+        return h;
+    }
+
+    template <typename T>
+    std::uint64_t value_hash(const T & v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "values are hashed by their bytes");
+
+        unsigned char b[sizeof(T)];
+        std::uint64_t h { 0xcbf29ce484222325 };
+
+        std::memcpy(b, &v, sizeof(T));
+
+        for(std::size_t i=0; i<sizeof(T); ++i) {
+            h = (h ^ b[i]) * 0x100000001b3;
+        }
+
+        return h;
+    }
+
+    template <typename T>
+    bool same_bytes(const T & a, const T & b)
+    {
+        return std::memcmp(&a, &b, sizeof(T)) == 0;
+    }
+
+    /*
+     * applies entries in order, the nodes of the previous entry's path
+     * are kept so entries of one subtree do not walk down from the root
+     * remove(node, pos) runs before a position is removed, touch(nodes,
+     * amnt) after every entry with the nodes it went through
+     */
+    template <typename Tree, typename T, typename Remove, typename Touch>
+    void apply_delta(Tree & root, const std::vector<delta_entry<T>> & delta, const Remove & remove, const Touch & touch)
+    {
+        Tree *        nodes[morton::key_levels];
+        unsigned      cached { 1 };
+        std::uint64_t prev   { 0 };
+        unsigned      prev_level { 0 };
+
+        nodes[0] = &root;
+
+        for(const delta_entry<T> & e : delta) {
+            assert(e.level > 0 && e.level <= morton::key_levels);
+
+            const auto position = [&e](const unsigned level) -> unsigned {
+                return (e.key >> (6 * (e.level - 1 - level))) & 63;
+            };
+
+            //nodes shared with the previous path
+            unsigned same { 0 };
+
+            while(same + 1 < e.level && same + 1 < prev_level && position(same) == ((prev >> (6 * (prev_level - 1 - same))) & 63)) {
+                ++same;
+            }
+
+            unsigned level { std::min(cached, same + 1) };
+
+            for(; level < e.level; ++level) {
+                nodes[level] = nodes[level - 1]->child(position(level - 1));
+            }
+
+            Tree &         node = *nodes[e.level - 1];
+            const unsigned pos { position(e.level - 1) };
+
+            switch(e.op) {
+            case delta_op::insert:
+                assert(! node.is_set(pos));
+
+                if(e.leaf) {
+                    node.insert_leaf(pos, e.value);
+                } else {
+                    node.insert(pos, e.value);
+                }
+                break;
+            case delta_op::change:
+                assert(node.is_set(pos) && node.is_leaf(pos) == e.leaf);
+                node.set_value(pos, e.value);
+                break;
+            case delta_op::remove:
+                assert(node.is_set(pos));
+                remove(node, pos);
+                node.remove(pos);
+                break;
+            }
+
+            touch(nodes, e.level);
+
+            //children of the node written to may have moved
+            cached     = e.level;
+            prev       = e.key;
+            prev_level = e.level;
+        }
+    }
+};
+
+/*
+ * apply a delta to a tree without hashes
+ */
+template <typename Tree, typename T>
+void apply_delta(Tree & root, const std::vector<delta_entry<T>> & delta)
+{
+    detail::apply_delta(root, delta, [](Tree &, unsigned) { }, [](Tree * const *, unsigned) { });
+}
+
+/*
+ * hashes of every node of a tree, kept up to date by writing through
+ * the index
+ * hashes are found by node address, so this needs nodes that stay
+ * where they are, like those of tree; block_tree moves its children
+ * deltas name positions by 64 bit keys, so the tree may not grow deeper
+ * than morton::key_levels, deeper writes throw std::invalid_argument
+ */
+template <typename Tree>
+class merkle_index
+{
+public:
+    typedef typename std::decay<decltype(std::declval<const Tree &>().get_value(0))>::type value_type;
+    typedef std::vector<delta_entry<value_type>>                                          delta_type;
+
+private:
+    Tree *                                         t;
+    std::unordered_map<const Tree*, std::uint64_t> hashes;
+
+    /*
+     * a node hashes to the sum of a term for its masks and one per set
+     * position, so a write changes a node's hash by the difference of
+     * the terms it touched instead of needing all 64 positions again
+     */
+    static std::uint64_t mask_term(const std::uint64_t set, const std::uint64_t leaves)
+    {
+        return detail::mix(detail::mix(set) ^ leaves);
+    }
+
+    std::uint64_t position_term(const Tree & node, const unsigned pos) const
+    {
+        const std::uint64_t below { node.is_leaf(pos) ? 0 : hashes.at(node.child(pos)) };
+
+        return detail::mix(detail::mix(detail::value_hash(node.get_value(pos)) + pos) ^ below);
+    }
+
+    std::uint64_t node_hash(const Tree & node) const
+    {
+        std::uint64_t h { mask_term(node.set_mask(), node.leaf_mask()) };
+
+        for(std::uint64_t set=node.set_mask(); set != 0; set &= set - 1) {
+            h += position_term(node, __builtin_ctzll(set));
+        }
+
+        return h;
+    }
+
+    /*
+     * what a node on a written path contributed before the write
+     */
+    struct path_state
+    {
+        Tree *        node;
+        unsigned      pos;
+        std::uint64_t hash; //of the node
+        std::uint64_t old;  //mask term plus the term of pos
+    };
+
+    path_state save(Tree & node, const unsigned pos) const
+    {
+        const auto found = hashes.find(&node);
+        const std::uint64_t h { found != hashes.end() ? found->second : mask_term(0, 0) };
+        const std::uint64_t m { mask_term(node.set_mask(), node.leaf_mask()) };
+
+        return path_state { &node, pos, h, m + (node.is_set(pos) ? position_term(node, pos) : 0) };
+    }
+
+    /*
+     * swap the old terms of the path for the current ones, deepest first
+     * so every node sees the new hash of the child below it
+     */
+    void update_path(const path_state * path, const unsigned amnt)
+    {
+        for(unsigned l=amnt; l-- > 0; ) {
+            const path_state & s = path[l];
+            const Tree &       node = *s.node;
+            const std::uint64_t now { mask_term(node.set_mask(), node.leaf_mask()) + (node.is_set(s.pos) ? position_term(node, s.pos) : 0) };
+
+            hashes[s.node] = s.hash - s.old + now;
+        }
+    }
+
+    /*
+     * drop the hashes of node and everything below it
+     */
+    void forget(const Tree & node)
+    {
+        for(const Tree & n : hckt::preorder(node)) {
+            hashes.erase(&n);
+        }
+    }
+
+    /*
+     * walk two nodes with different hashes, appending what turns a into b
+     */
+    void diff_node(const merkle_index & other, const Tree & a, const Tree & b, const std::uint64_t key, const unsigned level, delta_type & out) const
+    {
+        assert(level < morton::key_levels);
+
+        for(std::uint64_t set=a.set_mask() | b.set_mask(); set != 0; set &= set - 1) {
+            const unsigned      pos ( __builtin_ctzll(set) );
+            const std::uint64_t k   { (key << 6) | pos };
+            const std::uint8_t  l   ( level + 1 );
+
+            if(! b.is_set(pos)) {
+                out.push_back(delta_entry<value_type> { k, l, delta_op::remove, a.is_leaf(pos), a.get_value(pos) });
+                continue;
+            }
+
+            if(! a.is_set(pos) || a.is_leaf(pos) != b.is_leaf(pos)) {
+                if(a.is_set(pos)) {
+                    out.push_back(delta_entry<value_type> { k, l, delta_op::remove, a.is_leaf(pos), a.get_value(pos) });
+                }
+
+                emit(b, pos, k, l, out);
+                continue;
+            }
+
+            if(! detail::same_bytes(a.get_value(pos), b.get_value(pos))) {
+                out.push_back(delta_entry<value_type> { k, l, delta_op::change, a.is_leaf(pos), b.get_value(pos) });
+            }
+
+            if(! a.is_leaf(pos)) {
+                const Tree * ca { a.child(pos) };
+                const Tree * cb { b.child(pos) };
+
+                //the whole subtree is skipped with this compare
+                if(hashes.at(ca) != other.hashes.at(cb)) {
+                    diff_node(other, *ca, *cb, k, l, out);
+                }
+            }
+        }
+    }
+
+    /*
+     * insert entries for position of node and its subtree
+     */
+    static void emit(const Tree & node, const unsigned pos, const std::uint64_t key, const std::uint8_t level, delta_type & out)
+    {
+        const bool leaf { node.is_leaf(pos) };
+
+        out.push_back(delta_entry<value_type> { key, level, delta_op::insert, leaf, node.get_value(pos) });
+
+        if(leaf) {
+            return;
+        }
+
+        assert(level < morton::key_levels);
+
+        const Tree & c = *node.child(pos);
+
+        for(std::uint64_t set=c.set_mask(); set != 0; set &= set - 1) {
+            const unsigned p ( __builtin_ctzll(set) );
+            emit(c, p, (key << 6) | p, level + 1, out);
+        }
+    }
+
+public:
+    explicit merkle_index(Tree & tree) : t { &tree }, hashes { }
+    {
+        rebuild();
+    }
+
+    merkle_index(const merkle_index &) = delete;
+    merkle_index & operator=(const merkle_index &) = delete;
+
+    Tree & tree() const
+    {
+        return *t;
+    }
+
+    /*
+     * hash of the whole tree
+     */
+    std::uint64_t hash() const
+    {
+        return hashes.at(t);
+    }
+
+    std::uint64_t hash(const Tree & node) const
+    {
+        return hashes.at(&node);
+    }
+
+    /*
+     * rehash everything, for when the tree was written to directly
+     * throws std::invalid_argument if it grew deeper than deltas reach
+     */
+    void rebuild()
+    {
+        const auto nodes = hckt::postorder(*t);
+
+        hashes.clear();
+
+        for(auto it=nodes.begin(); it != nodes.end(); ++it) {
+            if(it.level() >= morton::key_levels) {
+                hashes.clear();
+                throw std::invalid_argument("merkle_index: tree deeper than morton::key_levels");
+            }
+
+            hashes[&*it] = node_hash(*it);
+        }
+    }
+
+    /*
+     * tree::insert_path, then the hashes of the path from the bottom up
+     */
+    template <typename Path>
+    void insert_path(Path & p, const value_type value)
+    {
+        assert(! p.done());
+
+        if(p.levels() > morton::key_levels) {
+            throw std::invalid_argument("merkle_index: path deeper than morton::key_levels");
+        }
+
+        path_state path[morton::max_depth_3d];
+        unsigned   amnt { 0 };
+        Tree *     node { t };
+
+        while(true) {
+            const unsigned pos { p.next() };
+
+            path[amnt++] = save(*node, pos);
+
+            if(p.done()) {
+                if(node->is_set(pos)) {
+                    node->set_value(pos, value);
+                } else {
+                    node->insert_leaf(pos, value);
+                }
+
+                break;
+            }
+
+            if(! node->is_set(pos)) {
+                node->insert(pos, value_type { });
+            } else if(node->is_leaf(pos)) {
+                const value_type v { node->get_value(pos) };
+                node->remove(pos);
+                node->insert(pos, v);
+            }
+
+            node = node->child(pos);
+        }
+
+        update_path(path, amnt);
+    }
+
+    /*
+     * remove the position find() would return, with its subtree
+     * false if nothing was set there
+     */
+    template <typename Path>
+    bool erase_path(Path & p)
+    {
+        assert(! p.done());
+
+        path_state path[morton::max_depth_3d];
+        unsigned   amnt { 0 };
+        Tree *     node { t };
+
+        while(true) {
+            const unsigned pos { p.next() };
+
+            if(! node->is_set(pos)) {
+                return false;
+            }
+
+            path[amnt++] = save(*node, pos);
+
+            if(p.done() || node->is_leaf(pos)) {
+                if(! node->is_leaf(pos)) {
+                    forget(*node->child(pos));
+                }
+
+                node->remove(pos);
+                break;
+            }
+
+            node = node->child(pos);
+        }
+
+        update_path(path, amnt);
+
+        return true;
+    }
+
+    void insert(const std::uint64_t x, const std::uint64_t y, const value_type value, const unsigned depth)
+    {
+        morton::path<2> p { x, y, depth };
+        insert_path(p, value);
+    }
+
+    void insert(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const value_type value, const unsigned depth)
+    {
+        morton::path<3> p { x, y, z, depth };
+        insert_path(p, value);
+    }
+
+    bool erase(const std::uint64_t x, const std::uint64_t y, const unsigned depth)
+    {
+        morton::path<2> p { x, y, depth };
+        return erase_path(p);
+    }
+
+    bool erase(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth)
+    {
+        morton::path<3> p { x, y, z, depth };
+        return erase_path(p);
+    }
+
+    /*
+     * what turns this tree into other's, in time proportional to the
+     * nodes whose hashes differ
+     */
+    delta_type diff(const merkle_index & other) const
+    {
+        delta_type out;
+
+        if(hash() != other.hash()) {
+            diff_node(other, *t, *other.t, 0, 0, out);
+        }
+
+        return out;
+    }
+
+    /*
+     * apply a delta, every node it touched is rehashed once at the end
+     */
+    void apply(const delta_type & delta)
+    {
+        std::unordered_map<Tree*, unsigned> dirty; //node to its level
+
+        detail::apply_delta(*t, delta, [this, &dirty](Tree & node, const unsigned pos) {
+            if(! node.is_leaf(pos)) {
+                for(const Tree & n : hckt::preorder(*node.child(pos))) {
+                    hashes.erase(&n);
+                    dirty.erase(const_cast<Tree*>(&n));
+                }
+            }
+        }, [this, &dirty](Tree * const * nodes, const unsigned amnt) {
+            for(unsigned l=0; l<amnt; ++l) {
+                dirty[nodes[l]] = l;
+            }
+        });
+
+        std::vector<std::pair<unsigned, Tree*>> order;
+
+        for(const auto & d : dirty) {
+            order.emplace_back(d.second, d.first);
+        }
+
+        //deepest first, children are hashed before their parents
+        std::sort(order.begin(), order.end(), [](const std::pair<unsigned, Tree*> & a, const std::pair<unsigned, Tree*> & b) {
+            return a.first > b.first;
+        });
+
+        for(const auto & o : order) {
+            rehash_new_children(*o.second);
+            hashes[o.second] = node_hash(*o.second);
+        }
+    }
+
+private:
+    /*
+     * children inserted by a delta and never walked through have no hash
+     * yet, they are empty nodes or filled by later entries which made
+     * them dirty, so only the empty ones are left
+     */
+    void rehash_new_children(const Tree & node)
+    {
+        for(unsigned i=0, c_amnt=node.children_amnt(); i<c_amnt; ++i) {
+            const Tree * c { node.child_at(i) };
+
+            if(hashes.count(c) == 0) {
+                hashes[c] = node_hash(*c);
+            }
+        }
+    }
+};
+
+};
+
+#endif
@@ -0,0 +1,241 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_MORTON_H
+#define HCKT_MORTON_H
+
+#include <cassert>
+#include <cstdint>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace hckt
+{
+
+/*
+ * morton codes matching the node layout of util.hpp
+ *
+ * 2d: a node covers 8x8 cells, x bit k of a coordinate lands on key bit
+ *     2k+1 and y bit k on key bit 2k, so get_position_2d(d1, d2, d3) is
+ *     the key of the node local coordinate (get_x_2d, get_y_2d)
+ * 3d: a node covers 4x4x4 cells, x lands on 3k+2, y on 3k+1, z on 3k
+ *
+ * either way every tree level consumes 6 key bits, and the key of a
+ * whole path from the root is the interleave of the full coordinates
+ */
+namespace morton
+{
+    constexpr std::uint64_t mask_2d_x { 0xAAAAAAAAAAAAAAAA };
+    constexpr std::uint64_t mask_2d_y { 0x5555555555555555 };
+    constexpr std::uint64_t mask_3d_x { 0x4924924924924924 };
+    constexpr std::uint64_t mask_3d_y { 0x2492492492492492 };
+    constexpr std::uint64_t mask_3d_z { 0x9249249249249249 };
+
+    //levels resolved by one 64 bit key
+    constexpr unsigned key_levels { 10 };
+
+    //deepest tree addressable with 64 bit coordinates
+    constexpr unsigned max_depth_2d { 21 };
+    constexpr unsigned max_depth_3d { 32 };
+
+    inline std::uint64_t spread_2d(std::uint64_t x)
+    {
+        x &= 0x00000000FFFFFFFF;
+        x  = (x | (x << 16)) & 0x0000FFFF0000FFFF;
+        x  = (x | (x <<  8)) & 0x00FF00FF00FF00FF;
+        x  = (x | (x <<  4)) & 0x0F0F0F0F0F0F0F0F;
+        x  = (x | (x <<  2)) & 0x3333333333333333;
+        x  = (x | (x <<  1)) & 0x5555555555555555;
+        return x;
+    }
+
+    inline std::uint64_t compact_2d(std::uint64_t x)
+    {
+        x &= 0x5555555555555555;
+        x  = (x | (x >>  1)) & 0x3333333333333333;
+        x  = (x | (x >>  2)) & 0x0F0F0F0F0F0F0F0F;
+        x  = (x | (x >>  4)) & 0x00FF00FF00FF00FF;
+        x  = (x | (x >>  8)) & 0x0000FFFF0000FFFF;
+        x  = (x | (x >> 16)) & 0x00000000FFFFFFFF;
+        return x;
+    }
+
+    inline std::uint64_t spread_3d(std::uint64_t x)
+    {
+        x &= 0x00000000001FFFFF;
+        x  = (x | (x << 32)) & 0x001F00000000FFFF;
+        x  = (x | (x << 16)) & 0x001F0000FF0000FF;
+        x  = (x | (x <<  8)) & 0x100F00F00F00F00F;
+        x  = (x | (x <<  4)) & 0x10C30C30C30C30C3;
+        x  = (x | (x <<  2)) & 0x1249249249249249;
+        return x;
+    }
+
+    inline std::uint64_t compact_3d(std::uint64_t x)
+    {
+        x &= 0x1249249249249249;
+        x  = (x ^ (x >>  2)) & 0x10C30C30C30C30C3;
+        x  = (x ^ (x >>  4)) & 0x100F00F00F00F00F;
+        x  = (x ^ (x >>  8)) & 0x001F0000FF0000FF;
+        x  = (x ^ (x >> 16)) & 0x001F00000000FFFF;
+        x  = (x ^ (x >> 32)) & 0x00000000001FFFFF;
+        return x;
+    }
+
+    /*
+     * x and y use at most 32 bits
+     */
+    inline std::uint64_t encode_2d(const std::uint64_t x, const std::uint64_t y)
+    {
+#ifdef __BMI2__
+        return _pdep_u64(x, mask_2d_x) | _pdep_u64(y, mask_2d_y);
+#else
+        return (spread_2d(x) << 1) | spread_2d(y);
+#endif
+    }
+
+    inline void decode_2d(const std::uint64_t key, std::uint64_t & x, std::uint64_t & y)
+    {
+#ifdef __BMI2__
+        x = _pext_u64(key, mask_2d_x);
+        y = _pext_u64(key, mask_2d_y);
+#else
+        x = compact_2d(key >> 1);
+        y = compact_2d(key);
+#endif
+    }
+
+    /*
+     * x and y use at most 21 bits, z at most 22
+     */
+    inline std::uint64_t encode_3d(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z)
+    {
+#ifdef __BMI2__
+        return _pdep_u64(x, mask_3d_x) | _pdep_u64(y, mask_3d_y) | _pdep_u64(z, mask_3d_z);
+#else
+        return (spread_3d(x) << 2) | (spread_3d(y) << 1) | spread_3d(z);
+#endif
+    }
+
+    inline void decode_3d(const std::uint64_t key, std::uint64_t & x, std::uint64_t & y, std::uint64_t & z)
+    {
+#ifdef __BMI2__
+        x = _pext_u64(key, mask_3d_x);
+        y = _pext_u64(key, mask_3d_y);
+        z = _pext_u64(key, mask_3d_z);
+#else
+        x = compact_3d(key >> 2);
+        y = compact_3d(key >> 1);
+        z = compact_3d(key);
+#endif
+    }
+
+    /*
+     * yields the 6 bit position of every level of a coordinate, root first
+     * positions are produced key_levels at a time, one encode per batch
+     */
+    template <unsigned Dim>
+    class path
+    {
+        static_assert(Dim == 2 || Dim == 3, "nodes map either 2d or 3d coordinates");
+
+        static constexpr unsigned axis_bits { 6 / Dim }; //per axis and level
+
+        std::uint64_t coords[Dim];
+        unsigned      depth;
+        unsigned      level;
+        unsigned      left;  //positions remaining in key
+        std::uint64_t key;
+
+        void refill()
+        {
+            const unsigned amnt  { depth - level < key_levels ? depth - level : key_levels };
+            const unsigned shift { axis_bits * (depth - level - amnt) };
+            const std::uint64_t mask { (std::uint64_t { 1 } << (axis_bits * amnt)) - 1 };
+
+            if(Dim == 2) {
+                key = encode_2d((coords[0] >> shift) & mask, (coords[1] >> shift) & mask);
+            } else {
+                key = encode_3d((coords[0] >> shift) & mask, (coords[1] >> shift) & mask, (coords[Dim - 1] >> shift) & mask);
+            }
+
+            left = amnt;
+        }
+
+    public:
+        path(const std::uint64_t x, const std::uint64_t y, const unsigned depth)
+            : coords { x, y }, depth { depth }, level { 0 }, left { 0 }, key { 0 }
+        {
+            static_assert(Dim == 2, "2d path takes x and y");
+            assert(depth <= max_depth_2d);
+        }
+
+        path(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth)
+            : coords { x, y, z }, depth { depth }, level { 0 }, left { 0 }, key { 0 }
+        {
+            static_assert(Dim == 3, "3d path takes x, y and z");
+            assert(depth <= max_depth_3d);
+        }
+
+        bool done() const
+        {
+            return level == depth;
+        }
+
+        /*
+         * positions yielded in total
+         */
+        unsigned levels() const
+        {
+            return depth;
+        }
+
+        /*
+         * true if the next position is the last one
+         */
+        bool last() const
+        {
+            return level + 1 == depth;
+        }
+
+        unsigned next()
+        {
+            assert(! done());
+
+            if(left == 0) {
+                refill();
+            }
+
+            --left;
+            ++level;
+
+            return (key >> (6 * left)) & 63;
+        }
+    };
+};
+
+};
+
+#endif
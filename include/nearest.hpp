@@ -0,0 +1,317 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_NEAREST_H
+#define HCKT_NEAREST_H
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <type_traits>
+#include <vector>
+#include "range.hpp"
+
+namespace hckt
+{
+
+/*
+ * nearest neighbour and radius search
+ *
+ * points are continuous coordinates in cells at the query depth, cell
+ * (x, y) spans [x, x + 1) x [y, y + 1), so the centre of a cell is
+ * x + 0.5, y + 0.5; distances are euclidean from the point to the
+ * closest point of a cell, 0 inside it
+ *
+ * like range queries, a leaf above the query depth is one result
+ * covering size cells along every axis
+ */
+template <typename Hit>
+struct neighbor
+{
+    Hit    hit;
+    double distance;
+};
+
+namespace detail
+{
+    template <unsigned Dim>
+    double box_distance2(const double * point, const std::uint64_t * cell, const std::uint64_t size)
+    {
+        double sum { 0 };
+
+        for(unsigned d=0; d<Dim; ++d) {
+            const double lo    ( static_cast<double>(cell[d]) );
+            const double hi    ( lo + static_cast<double>(size) );
+            const double delta { point[d] < lo ? lo - point[d] : point[d] > hi ? point[d] - hi : 0.0 };
+
+            sum += delta * delta;
+        }
+
+        return sum;
+    }
+
+    template <typename T>
+    rect_hit<T> make_hit(std::integral_constant<unsigned, 2>, const std::uint64_t * cell, const std::uint64_t size, const T & value)
+    {
+        return rect_hit<T> { cell[0], cell[1], size, value };
+    }
+
+    template <typename T>
+    box_hit<T> make_hit(std::integral_constant<unsigned, 3>, const std::uint64_t * cell, const std::uint64_t size, const T & value)
+    {
+        return box_hit<T> { cell[0], cell[1], cell[2], size, value };
+    }
+
+    /*
+     * cells within radius of point as an inclusive box, false if none
+     */
+    template <unsigned Dim>
+    bool bounding_box(const double * point, const double radius, const unsigned depth, std::uint64_t * lo, std::uint64_t * hi)
+    {
+        const unsigned      bits { (6 / Dim) * depth };
+        const std::uint64_t last { bits >= 64 ? ~std::uint64_t { 0 } : (std::uint64_t { 1 } << bits) - 1 };
+        const double        top  ( static_cast<double>(last) );
+
+        for(unsigned d=0; d<Dim; ++d) {
+            const double a { std::floor(point[d] - radius) };
+            const double b { std::floor(point[d] + radius) };
+
+            if(b < 0 || a > top) {
+                return false;
+            }
+
+            lo[d] = a <= 0 ? 0 : static_cast<std::uint64_t>(a);
+            hi[d] = b >= top ? last : static_cast<std::uint64_t>(b);
+        }
+
+        return true;
+    }
+
+    /*
+     * range_walk restricted to the positions within radius, the box
+     * mask discards most positions before any distance is computed
+     */
+    template <unsigned Dim, typename Node, typename F>
+    void sphere_walk(const Node & node, const std::uint64_t * origin, const unsigned shift, const double * point, const double radius2, const std::uint64_t * lo, const std::uint64_t * hi, F & f)
+    {
+        constexpr unsigned axis_bits { 6 / Dim };
+
+        unsigned l[Dim];
+        unsigned h[Dim];
+
+        if(! clip<Dim>(origin, shift, lo, hi, l, h)) {
+            return;
+        }
+
+        const std::uint64_t leaves { node.leaf_mask() };
+        std::uint64_t       hits   { node.set_mask() & mask(std::integral_constant<unsigned, Dim> { }, l, h) };
+
+        while(hits != 0) {
+            const unsigned      pos  ( __builtin_ctzll(hits) );
+            const std::uint64_t size { std::uint64_t { 1 } << shift };
+            std::uint64_t       cell[Dim];
+
+            hits &= hits - 1;
+            position_cell<Dim>(pos, origin, shift, cell);
+
+            if(box_distance2<Dim>(point, cell, size) > radius2) {
+                continue;
+            }
+
+            if(shift == 0 || ((leaves >> pos) & 1)) {
+                emit(std::integral_constant<unsigned, Dim> { }, f, cell, size, node.get_value(pos));
+            } else {
+                sphere_walk<Dim>(*node.child(pos), cell, shift - axis_bits, point, radius2, lo, hi, f);
+            }
+        }
+    }
+
+    template <unsigned Dim, typename Node>
+    struct knn_entry
+    {
+        double        distance2;
+        const Node *  node;     //node holding pos
+        std::uint64_t cell[Dim];
+        unsigned      shift;
+        unsigned      pos;
+        bool          is_value; //false if pos leads to a child still to expand
+
+        bool operator<(const knn_entry & other) const
+        {
+            //priority_queue pops the largest, so farther compares smaller
+            //on ties values come out before nodes
+            return distance2 > other.distance2 || (distance2 == other.distance2 && ! is_value && other.is_value);
+        }
+    };
+
+    template <unsigned Dim, typename Node>
+    void knn_expand(std::priority_queue<knn_entry<Dim, Node>> & queue, const Node & node, const std::uint64_t * origin, const unsigned shift, const double * point, const double max2)
+    {
+        const std::uint64_t leaves { node.leaf_mask() };
+        std::uint64_t       bits   { node.set_mask() };
+
+        while(bits != 0) {
+            knn_entry<Dim, Node> e;
+
+            e.pos   = __builtin_ctzll(bits);
+            e.node  = &node;
+            e.shift = shift;
+            bits &= bits - 1;
+
+            position_cell<Dim>(e.pos, origin, shift, e.cell);
+            e.distance2 = box_distance2<Dim>(point, e.cell, std::uint64_t { 1 } << shift);
+
+            if(e.distance2 > max2) {
+                continue;
+            }
+
+            e.is_value = shift == 0 || ((leaves >> e.pos) & 1);
+
+            //interior positions may lead to an empty child, their bound would
+            //be popped for nothing
+            if(! e.is_value && node.child(e.pos)->set_mask() == 0) {
+                continue;
+            }
+
+            queue.push(e);
+        }
+    }
+
+    /*
+     * best first: positions of expanded nodes are queued by the distance
+     * to their cell, which bounds everything below them, so values come
+     * out of the queue in order of distance and the search stops after k
+     */
+    template <unsigned Dim, typename Node, typename OutputIterator>
+    OutputIterator knn(const Node & root, const double * point, std::size_t k, const unsigned depth, const double max_distance, OutputIterator out)
+    {
+        constexpr unsigned axis_bits { 6 / Dim };
+        const std::uint64_t origin[Dim] { };
+
+        std::priority_queue<knn_entry<Dim, Node>> queue;
+        const double max2 { max_distance * max_distance };
+
+        if(k == 0) {
+            return out;
+        }
+
+        knn_expand<Dim>(queue, root, origin, axis_bits * (depth - 1), point, max2);
+
+        while(! queue.empty()) {
+            const knn_entry<Dim, Node> e ( queue.top() );
+            queue.pop();
+
+            if(! e.is_value) {
+                knn_expand<Dim>(queue, *e.node->child(e.pos), e.cell, e.shift - axis_bits, point, max2);
+                continue;
+            }
+
+            *out++ = neighbor<decltype(make_hit(std::integral_constant<unsigned, Dim> { }, e.cell, 0, e.node->get_value(e.pos)))> {
+                make_hit(std::integral_constant<unsigned, Dim> { }, e.cell, std::uint64_t { 1 } << e.shift, e.node->get_value(e.pos)),
+                std::sqrt(e.distance2)
+            };
+
+            if(--k == 0) {
+                break;
+            }
+        }
+
+        return out;
+    }
+};
+
+/*
+ * the k set cells nearest to (x, y) at depth, closest first, written to
+ * out as neighbor<rect_hit<T>>; cells farther than max_distance are skipped
+ * works on tree, block_tree and frozen_node
+ */
+template <typename Node, typename OutputIterator>
+OutputIterator nearest_2d(const Node & root, const double x, const double y, const std::size_t k, const unsigned depth, OutputIterator out, const double max_distance = std::numeric_limits<double>::infinity())
+{
+    assert(depth > 0);
+    assert(depth <= morton::max_depth_2d);
+
+    const double point[2] { x, y };
+    return detail::knn<2>(root, point, k, depth, max_distance, out);
+}
+
+/*
+ * as nearest_2d, writing neighbor<box_hit<T>>
+ */
+template <typename Node, typename OutputIterator>
+OutputIterator nearest_3d(const Node & root, const double x, const double y, const double z, const std::size_t k, const unsigned depth, OutputIterator out, const double max_distance = std::numeric_limits<double>::infinity())
+{
+    assert(depth > 0);
+    assert(depth <= morton::max_depth_3d);
+
+    const double point[3] { x, y, z };
+    return detail::knn<3>(root, point, k, depth, max_distance, out);
+}
+
+/*
+ * every set cell within radius of (x, y), unordered, calls
+ * f(x, y, size, value) like for_each_in_rect
+ */
+template <typename Node, typename F>
+void for_each_in_circle(const Node & root, const double x, const double y, const double radius, const unsigned depth, F f)
+{
+    assert(depth > 0);
+    assert(depth <= morton::max_depth_2d);
+    assert(radius >= 0);
+
+    const double        point[2]  { x, y };
+    const std::uint64_t origin[2] { 0, 0 };
+    std::uint64_t lo[2];
+    std::uint64_t hi[2];
+
+    if(detail::bounding_box<2>(point, radius, depth, lo, hi)) {
+        detail::sphere_walk<2>(root, origin, 3 * (depth - 1), point, radius * radius, lo, hi, f);
+    }
+}
+
+/*
+ * every set cell within radius of (x, y, z), calls f(x, y, z, size, value)
+ */
+template <typename Node, typename F>
+void for_each_in_sphere(const Node & root, const double x, const double y, const double z, const double radius, const unsigned depth, F f)
+{
+    assert(depth > 0);
+    assert(depth <= morton::max_depth_3d);
+    assert(radius >= 0);
+
+    const double        point[3]  { x, y, z };
+    const std::uint64_t origin[3] { 0, 0, 0 };
+    std::uint64_t lo[3];
+    std::uint64_t hi[3];
+
+    if(detail::bounding_box<3>(point, radius, depth, lo, hi)) {
+        detail::sphere_walk<3>(root, origin, 2 * (depth - 1), point, radius * radius, lo, hi, f);
+    }
+}
+
+};
+
+#endif
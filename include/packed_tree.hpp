@@ -0,0 +1,548 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_PACKED_TREE_H
+#define HCKT_PACKED_TREE_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include "allocator.hpp"
+#include "frozen_tree.hpp"
+#include "lmemvector.hpp"
+#include "traversal.hpp"
+#include "util.hpp"
+
+namespace hckt
+{
+
+/*
+ * tree with the same interface as hckt::block_tree, storing each node as
+ * one block of an arena (see basic_arena_allocator):
+ *
+ *   chiset | leaf | children (u32)[children_amnt] | values (Bits each)[value_amount]
+ *
+ * children are 32 bit arena indices instead of pointers and values are
+ * bit packed at Bits bits, so a tree of 4 bit values spends half a byte
+ * per value instead of the width of T
+ * Bits defaults to the full width of T, values wider than Bits throw
+ * std::out_of_range
+ * up to 57 bits a value is read with one unaligned 8 byte load, wider
+ * ones need one more byte, the arena keeps the bytes after a block
+ * readable for it
+ *
+ * the tree object itself is only the index of its block, children are
+ * stored inline in the parent block as packed_tree objects, so
+ * child(position) points into the parent block
+ * modifying a node invalidates pointers to its children (not the
+ * children themselves)
+ * index 0 is the all zero block of the arena, which is an empty node
+ */
+template <typename T, unsigned Bits = sizeof(T) * 8, typename Alloc = hckt::arena_allocator, typename Growth = hckt::exact_growth>
+class packed_tree
+{
+typedef T value_type;
+typedef Alloc allocator_type;
+
+static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value, "packed values are unsigned integers");
+static_assert(Bits > 0 && Bits <= sizeof(T) * 8, "Bits has to fit in T");
+static_assert(Bits <= 64, "a value is read from at most 9 bytes");
+
+protected:
+    struct header
+    {
+        std::uint64_t chiset; //is child set to this position
+        std::uint64_t leaf;   //is leaf, zero for an empty block
+    };
+
+    std::uint32_t block;
+
+    static constexpr std::uint64_t value_mask { ~std::uint64_t { 0 } >> (64 - Bits) };
+
+    header * head() const
+    {
+        return static_cast<header*>(Alloc::at(block));
+    }
+
+    static std::size_t block_size(const unsigned c_amnt, const unsigned v_amnt)
+    {
+        return sizeof(header) + (c_amnt * sizeof(packed_tree)) + (v_amnt * Bits + 7) / 8;
+    }
+
+    static std::size_t block_capacity(const unsigned c_amnt, const unsigned v_amnt)
+    {
+        return (c_amnt + v_amnt) == 0 ? 0 : Growth::template capacity<char>(block_size(c_amnt, v_amnt));
+    }
+
+    packed_tree * children_buf() const
+    {
+        return reinterpret_cast<packed_tree*>(head() + 1);
+    }
+
+    unsigned char * values_buf(const unsigned c_amnt) const
+    {
+        return reinterpret_cast<unsigned char*>(head() + 1) + c_amnt * sizeof(packed_tree);
+    }
+
+    static value_type unpack(const unsigned char * buf, const unsigned vpos)
+    {
+        const std::size_t bit   { std::size_t { vpos } * Bits };
+        const unsigned    shift ( bit % 8 );
+        std::uint64_t     w;
+
+        std::memcpy(&w, buf + bit / 8, sizeof(w));
+        w >>= shift;
+
+        //the top bits of a value wider than 57 bits spill into a ninth byte
+        if(Bits > 57 && shift + Bits > 64) {
+            w |= std::uint64_t { buf[bit / 8 + 8] } << (64 - shift);
+        }
+
+        return static_cast<value_type>(w & value_mask);
+    }
+
+    /*
+     * only the bytes holding the value are written back
+     */
+    static void pack(unsigned char * buf, const unsigned vpos, const value_type value)
+    {
+        assert(static_cast<std::uint64_t>(value) <= value_mask);
+
+        const std::size_t bit   { std::size_t { vpos } * Bits };
+        const unsigned    shift ( bit % 8 );
+        const std::size_t bytes { (shift + Bits + 7) / 8 };
+        std::uint64_t     w;
+
+        std::memcpy(&w, buf + bit / 8, sizeof(w));
+        w = (w & ~(value_mask << shift)) | (static_cast<std::uint64_t>(value) << shift);
+
+        if(Bits > 57 && bytes > sizeof(w)) {
+            const unsigned char keep ( buf[bit / 8 + 8] & ~(value_mask >> (64 - shift)) );
+
+            buf[bit / 8 + 8] = keep | static_cast<unsigned char>(static_cast<std::uint64_t>(value) >> (64 - shift));
+            std::memcpy(buf + bit / 8, &w, sizeof(w));
+            return;
+        }
+
+        std::memcpy(buf + bit / 8, &w, bytes);
+    }
+
+    static void check_width(const value_type value)
+    {
+        if(static_cast<std::uint64_t>(value) > value_mask) {
+            throw std::out_of_range("packed_tree: value wider than Bits");
+        }
+    }
+
+    /*
+     * move the block to one fitting c_amnt children and v_amnt values
+     * if its size class changes, layout is left to the caller
+     */
+    void resize_block(const unsigned old_c, const unsigned old_v, const unsigned new_c, const unsigned new_v)
+    {
+        const std::size_t old_cap { block_capacity(old_c, old_v) };
+        const std::size_t new_cap { block_capacity(new_c, new_v) };
+
+        if(old_cap == new_cap) {
+            return;
+        }
+
+        std::uint32_t nb { 0 };
+
+        if(new_cap != 0) {
+            void * p { Alloc::allocate(new_cap) };
+            const std::size_t keep { old_cap < new_cap ? old_cap : new_cap };
+            std::memcpy(p, head(), keep < sizeof(header) ? sizeof(header) : keep);
+            nb = Alloc::index(p);
+        }
+
+        if(old_cap != 0) {
+            Alloc::deallocate(head(), old_cap);
+        }
+
+        block = nb;
+    }
+
+public:
+
+    packed_tree() : block { 0 }
+    {
+    }
+
+    ~packed_tree()
+    {
+        collapse();
+    }
+
+    packed_tree(const packed_tree &) = delete;
+    packed_tree & operator=(const packed_tree &) = delete;
+
+    std::uint64_t chidist() const
+    {
+        return head()->chiset & ~head()->leaf;
+    }
+
+    std::uint64_t set_mask() const
+    {
+        return head()->chiset;
+    }
+
+    std::uint64_t leaf_mask() const
+    {
+        return head()->leaf;
+    }
+
+    unsigned children_amnt() const
+    {
+        return hckt::popcount(chidist());
+    }
+
+    unsigned leaf_amnt() const
+    {
+        return hckt::popcount(head()->leaf);
+    }
+
+    unsigned value_amount() const
+    {
+        return hckt::popcount(head()->chiset);
+    }
+
+    unsigned get_children_position(const unsigned position) const
+    {
+        return hckt::rank(chidist(), position);
+    }
+
+    unsigned get_value_position(const unsigned position) const
+    {
+        return hckt::rank(head()->chiset, position);
+    }
+
+    /*
+     * check if we have any children
+     */
+    bool has_children() const
+    {
+        return head()->chiset != 0;
+    }
+
+    bool is_set(const unsigned position) const
+    {
+        assert(position < 64);
+        return (head()->chiset >> position) & 1;
+    }
+
+    bool is_leaf(const unsigned position) const
+    {
+        assert(position < 64);
+        return (head()->leaf >> position) & 1;
+    }
+
+    /*
+     * destroy children
+     */
+    void collapse()
+    {
+        if(block == 0) {
+            return;
+        }
+
+        //children live in their parent's block, so blocks are freed bottom up
+        for(postorder_iterator<packed_tree> it { *this }, end { }; it != end; ) {
+            packed_tree & node = *it;
+            ++it;
+
+            const std::size_t cap { block_capacity(node.children_amnt(), node.value_amount()) };
+
+            if(cap != 0) {
+                Alloc::deallocate(node.head(), cap);
+            }
+
+            node.block = 0;
+        }
+    }
+
+    /*
+     * insert a tree into position of tree
+     * position should be result of get_position
+     */
+    void insert(const unsigned position, const value_type value)
+    {
+        assert(position < 64);
+        assert(! is_set(position));
+        check_width(value);
+
+        const unsigned cpos   { get_children_position(position) };
+        const unsigned c_amnt { children_amnt() };
+        const unsigned vpos   { get_value_position(position) };
+        const unsigned v_amnt { value_amount() };
+
+        value_type v[64];
+
+        for(unsigned i=0; i<v_amnt; ++i) {
+            v[i] = unpack(values_buf(c_amnt), i);
+        }
+
+        resize_block(c_amnt, v_amnt, c_amnt + 1, v_amnt + 1);
+
+        packed_tree * c { children_buf() };
+        std::memmove(static_cast<void*>(c + cpos + 1), c + cpos, sizeof(packed_tree) * (c_amnt - cpos));
+        new (c + cpos) packed_tree();
+
+        unsigned char * nv { values_buf(c_amnt + 1) };
+
+        for(unsigned i=0; i<vpos; ++i) {
+            pack(nv, i, v[i]);
+        }
+
+        pack(nv, vpos, value);
+
+        for(unsigned i=vpos; i<v_amnt; ++i) {
+            pack(nv, i + 1, v[i]);
+        }
+
+        head()->chiset |= (std::uint64_t { 1 } << position);
+    }
+
+    /*
+     * insert a leaf into position of tree
+     * position should be result of get_position
+     */
+    void insert_leaf(const unsigned position, const value_type value)
+    {
+        assert(position < 64);
+        assert(! is_set(position));
+        check_width(value);
+
+        const unsigned c_amnt { children_amnt() };
+        const unsigned vpos   { get_value_position(position) };
+        const unsigned v_amnt { value_amount() };
+
+        resize_block(c_amnt, v_amnt, c_amnt, v_amnt + 1);
+
+        //shift from the back, every value lands above where it was read
+        unsigned char * v { values_buf(c_amnt) };
+
+        for(unsigned i=v_amnt; i>vpos; --i) {
+            pack(v, i, unpack(v, i - 1));
+        }
+
+        pack(v, vpos, value);
+
+        head()->chiset |= (std::uint64_t { 1 } << position);
+        head()->leaf   |= (std::uint64_t { 1 } << position);
+    }
+
+    /*
+     * removes an item (leaf or subtree) from tree
+     * position should be result of get_position
+     */
+    void remove(const unsigned position)
+    {
+        assert(position < 64);
+        assert(is_set(position));
+
+        const unsigned c_amnt { children_amnt() };
+        const unsigned vpos   { get_value_position(position) };
+        const unsigned v_amnt { value_amount() };
+        const bool     leaf   { is_leaf(position) };
+        const unsigned new_c  { leaf ? c_amnt : c_amnt - 1 };
+
+        value_type v[64];
+
+        for(unsigned i=0; i<v_amnt; ++i) {
+            v[i] = unpack(values_buf(c_amnt), i);
+        }
+
+        if(! leaf) {
+            const unsigned cpos { get_children_position(position) };
+            packed_tree * c { children_buf() };
+
+            c[cpos].collapse();
+            std::memmove(static_cast<void*>(c + cpos), c + cpos + 1, sizeof(packed_tree) * (c_amnt - cpos - 1));
+        }
+
+        unsigned char * nv { values_buf(new_c) };
+
+        for(unsigned i=0; i<vpos; ++i) {
+            pack(nv, i, v[i]);
+        }
+
+        for(unsigned i=vpos + 1; i<v_amnt; ++i) {
+            pack(nv, i - 1, v[i]);
+        }
+
+        head()->chiset &= ~(std::uint64_t { 1 } << position);
+        head()->leaf   &= ~(std::uint64_t { 1 } << position);
+
+        resize_block(c_amnt, v_amnt, new_c, v_amnt - 1);
+    }
+
+    /*
+     * get child node
+     * position should be result of get_position
+     */
+    packed_tree * child(const unsigned position) const
+    {
+        assert(position < 64);
+        assert(is_set(position));
+        assert(! is_leaf(position));
+
+        return children_buf() + get_children_position(position);
+    }
+
+    /*
+     * get child by its index among the children, they are in position order
+     */
+    packed_tree * child_at(const unsigned cpos) const
+    {
+        assert(cpos < children_amnt());
+
+        return children_buf() + cpos;
+    }
+
+    /*
+     * address child(position) reads its block index from, for prefetching
+     */
+    const void * child_address(const unsigned position) const
+    {
+        return children_buf() + get_children_position(position);
+    }
+
+    /*
+     * sets node to specific value
+     * position should be result of get_position
+     */
+    void set_value(const unsigned position, const value_type value)
+    {
+        assert(position < 64);
+        assert(is_set(position));
+        check_width(value);
+
+        pack(values_buf(children_amnt()), get_value_position(position), value);
+    }
+
+    /*
+     * gets value from specific position
+     * position should be result of get_position
+     */
+    value_type get_value(const unsigned position) const
+    {
+        assert(position < 64);
+
+        return unpack(values_buf(children_amnt()), get_value_position(position));
+    }
+
+
+    /*
+     * build an immutable flat copy of this tree, see frozen_tree.hpp
+     * values are stored at the full width of T there
+     * dedup stores identical subtrees once
+     */
+    hckt::frozen_tree<value_type> freeze(const bool dedup = false) const
+    {
+        return hckt::frozen_tree<value_type>(*this, dedup);
+    }
+
+
+    /************************************************
+     *
+     * BENCHMARKING CODE
+     *
+     ***********************************************/
+
+    std::size_t calculate_memory_size() const
+    {
+        //child indices are counted in the block of their parent
+        std::size_t size { sizeof(packed_tree) };
+
+        for(const packed_tree & node : hckt::preorder(*this)) {
+            size += block_capacity(node.children_amnt(), node.value_amount());
+        }
+
+        return size;
+    }
+
+    std::size_t calculate_children_amnt() const
+    {
+        std::size_t amount { 0 };
+
+        for(const packed_tree & node : hckt::preorder(*this)) {
+            amount += node.children_amnt();
+        }
+
+        return amount;
+    }
+
+    std::size_t calculate_leaf_amount() const
+    {
+        std::size_t amount { 0 };
+
+        for(const packed_tree & node : hckt::preorder(*this)) {
+            amount += node.leaf_amnt();
+        }
+
+        return amount;
+    }
+
+    void mem_usage_info() const
+    {
+        const std::size_t memsize { calculate_memory_size() };
+        const std::size_t c_amnt  { calculate_children_amnt() };
+        const std::size_t l_amnt  { calculate_leaf_amount() };
+        const std::size_t v_amnt  { c_amnt + l_amnt };
+        const double      v_size  { Bits / 8.0 };
+
+        std::cout << "total:     " << hckt::render_size(memsize) << std::endl;
+
+        std::cout << "tree-size: " << hckt::render_size(sizeof(packed_tree)) << std::endl;
+        std::cout << "val-size:  " << v_size << " B (" << Bits << " bits)" << std::endl;
+
+        std::cout << "values:    " << hckt::render_number(v_amnt) << std::endl;
+        std::cout << "children:  " << hckt::render_number(c_amnt) << std::endl;
+        std::cout << "leaves:    " << hckt::render_number(l_amnt) << std::endl;
+
+        std::cout << "per-val:   " << (static_cast<double>(memsize) / v_amnt) << " B" << std::endl;
+        std::cout << "overhead:  " << ((static_cast<double>(memsize) - v_amnt * v_size) / v_amnt) << " B" << std::endl;
+
+        const hckt::alloc_stats astats = Alloc::stats();
+
+        if(astats.chunks != 0) {
+            std::cout << "arena:     " << hckt::render_size(astats.reserved) << std::endl;
+            std::cout << "in-use:    " << hckt::render_size(astats.in_use) << std::endl;
+            std::cout << "frag:      " << (astats.fragmentation() * 100.0) << " %" << std::endl;
+        }
+    }
+
+};
+
+template <typename T, unsigned Bits, typename Alloc, typename Growth>
+constexpr std::uint64_t packed_tree<T, Bits, Alloc, Growth>::value_mask;
+
+};
+
+#endif
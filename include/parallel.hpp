@@ -0,0 +1,614 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef HCKT_PARALLEL_H
+#define HCKT_PARALLEL_H
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "allocator.hpp"
+#include "traversal.hpp"
+
+namespace hckt
+{
+
+/*
+ * parallel walks over the child subtrees of a node
+ *
+ * a node whose children are estimated to hold at least grain nodes each
+ * hands every child to its own task, smaller subtrees are walked serially
+ * by the task that reaches them, so splitting stops where task overhead
+ * would outweigh the work
+ * with a single thread nothing is split at all, there is nobody to hand
+ * the tasks to
+ *
+ * an executor has to offer
+ *   void submit(std::function<void()> task);
+ *   bool try_run_one(); //run one queued task, false if there was none
+ *   unsigned threads() const; //threads running tasks, 1 walks serially
+ * work_stealing_pool is the built in one, serial_executor runs every task
+ * on the spot and turns each algorithm into its serial baseline
+ *
+ * read only walks work on tree, block_tree and frozen_node; clone and
+ * collapse allocate or free from several threads at once, so they need a
+ * thread safe allocator policy, like the default per thread pool_allocator
+ * whose threads never wait for each other
+ */
+
+/*
+ * fixed set of threads, each with its own deque of tasks
+ * a thread pushes and pops at the back of its own deque and, once that is
+ * empty, steals from the front of the others, so it keeps working on the
+ * subtree it split last while idle threads take the oldest (biggest) ones
+ *
+ * threads outside the pool share one extra deque and help out while they
+ * wait on a task_group
+ */
+class work_stealing_pool
+{
+public:
+    typedef std::function<void()> task;
+
+private:
+    struct task_queue
+    {
+        std::mutex       lock;
+        std::deque<task> tasks;
+
+        task_queue() : lock { }, tasks { }
+        {
+        }
+    };
+
+    struct thread_slot
+    {
+        const work_stealing_pool * pool;
+        unsigned                   index;
+    };
+
+    std::vector<std::unique_ptr<task_queue>> queues; //last one is for outside threads
+    std::vector<std::thread>                 workers;
+    std::atomic<std::size_t>                 queued;
+    std::atomic<bool>                        stop;
+    std::mutex                               sleep_lock;
+    std::condition_variable                  wake;
+
+    static thread_slot & local()
+    {
+        static thread_local thread_slot slot { nullptr, 0 };
+        return slot;
+    }
+
+    unsigned own_queue() const
+    {
+        const thread_slot & slot = local();
+
+        return slot.pool == this ? slot.index : queues.size() - 1;
+    }
+
+    bool pop(const unsigned q, task & t, const bool back)
+    {
+        task_queue & tq = *queues[q];
+        std::lock_guard<std::mutex> guard { tq.lock };
+
+        if(tq.tasks.empty()) {
+            return false;
+        }
+
+        if(back) {
+            t = std::move(tq.tasks.back());
+            tq.tasks.pop_back();
+        } else {
+            t = std::move(tq.tasks.front());
+            tq.tasks.pop_front();
+        }
+
+        --queued;
+        return true;
+    }
+
+    void work(const unsigned index)
+    {
+        local() = thread_slot { this, index };
+
+        while(! stop) {
+            if(try_run_one()) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> guard { sleep_lock };
+            wake.wait(guard, [this]() { return stop || queued != 0; });
+        }
+    }
+
+public:
+    /*
+     * threads counts the calling thread, which helps while waiting,
+     * so threads - 1 workers are started
+     */
+    explicit work_stealing_pool(const unsigned threads = std::thread::hardware_concurrency())
+        : queues     { }
+        , workers    { }
+        , queued     { 0 }
+        , stop       { false }
+        , sleep_lock { }
+        , wake       { }
+    {
+        const unsigned amnt { threads > 1 ? threads - 1 : 0 };
+
+        for(unsigned i=0; i<=amnt; ++i) {
+            queues.emplace_back(new task_queue());
+        }
+
+        for(unsigned i=0; i<amnt; ++i) {
+            workers.emplace_back([this, i]() { work(i); });
+        }
+    }
+
+    ~work_stealing_pool()
+    {
+        {
+            std::lock_guard<std::mutex> guard { sleep_lock };
+            stop = true;
+        }
+
+        wake.notify_all();
+
+        for(std::thread & w : workers) {
+            w.join();
+        }
+    }
+
+    work_stealing_pool(const work_stealing_pool &) = delete;
+    work_stealing_pool & operator=(const work_stealing_pool &) = delete;
+
+    /*
+     * pool sized to the machine, started on first use
+     */
+    static work_stealing_pool & shared()
+    {
+        static work_stealing_pool p;
+        return p;
+    }
+
+    unsigned threads() const
+    {
+        return workers.size() + 1;
+    }
+
+    void submit(task t)
+    {
+        task_queue & tq = *queues[own_queue()];
+
+        {
+            std::lock_guard<std::mutex> guard { tq.lock };
+            tq.tasks.push_back(std::move(t));
+            ++queued;
+        }
+
+        if(! workers.empty()) {
+            std::lock_guard<std::mutex> guard { sleep_lock };
+            wake.notify_one();
+        }
+    }
+
+    bool try_run_one()
+    {
+        const unsigned own  { own_queue() };
+        const unsigned amnt ( queues.size() );
+        task t;
+
+        if(queued == 0) {
+            return false;
+        }
+
+        if(! pop(own, t, true)) {
+            unsigned i { 1 };
+
+            for(; i<amnt; ++i) {
+                if(pop((own + i) % amnt, t, false)) {
+                    break;
+                }
+            }
+
+            if(i == amnt) {
+                return false;
+            }
+        }
+
+        t();
+        return true;
+    }
+};
+
+/*
+ * runs every task as soon as it is submitted
+ */
+struct serial_executor
+{
+    void submit(const std::function<void()> & t)
+    {
+        t();
+    }
+
+    bool try_run_one()
+    {
+        return false;
+    }
+
+    unsigned threads() const
+    {
+        return 1;
+    }
+};
+
+/*
+ * fork/join on top of an executor
+ * wait() runs queued tasks instead of blocking, so nested groups on pool
+ * threads never deadlock
+ * tasks must not throw
+ */
+template <typename Executor>
+class task_group
+{
+    Executor &               executor;
+    std::atomic<std::size_t> outstanding;
+
+public:
+    explicit task_group(Executor & executor) : executor { executor }, outstanding { 0 }
+    {
+    }
+
+    ~task_group()
+    {
+        wait();
+    }
+
+    task_group(const task_group &) = delete;
+    task_group & operator=(const task_group &) = delete;
+
+    template <typename F>
+    void spawn(const F & f)
+    {
+        ++outstanding;
+
+        executor.submit([this, f]() {
+            f();
+            outstanding.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    void wait()
+    {
+        while(outstanding.load(std::memory_order_acquire) != 0) {
+            if(! executor.try_run_one()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+namespace detail
+{
+    /*
+     * estimate of the nodes below node, following the first child down
+     * and assuming its siblings look alike, stops counting at limit
+     */
+    template <typename Node>
+    std::size_t estimate_nodes(const Node & node, const std::size_t limit)
+    {
+        std::size_t  amnt  { 1 };
+        std::size_t  width { 1 };
+        const Node * n     { &node };
+
+        while(amnt < limit && n->children_amnt() != 0) {
+            width *= n->children_amnt();
+            amnt  += width;
+            n      = n->child_at(0);
+        }
+
+        return amnt;
+    }
+
+    /*
+     * nodes are only split this many levels below the root, 64^16 tasks
+     * is plenty and it bounds the recursion of the split itself, which an
+     * inline executor runs on the caller's stack
+     */
+    constexpr unsigned split_levels { 16 };
+
+    //grain that never splits
+    constexpr std::size_t serial_grain { std::numeric_limits<std::size_t>::max() };
+
+    template <typename Executor>
+    std::size_t grain_for(const Executor & executor, const std::size_t grain)
+    {
+        return executor.threads() > 1 ? grain : serial_grain;
+    }
+
+    /*
+     * every task split off should get about grain nodes to walk
+     */
+    template <typename Node>
+    bool worth_splitting(const Node & node, const std::size_t grain, const unsigned level)
+    {
+        const std::size_t c_amnt { node.children_amnt() };
+
+        return level < split_levels && c_amnt > 1 && grain <= serial_grain / 64 && estimate_nodes(node, grain * c_amnt) >= grain * c_amnt;
+    }
+
+    template <typename R>
+    struct slot
+    {
+        R value; //keeps std::vector<bool> packing out of concurrent writes
+    };
+
+    template <typename Executor, typename Node, typename R, typename Map, typename Reduce>
+    R reduce_nodes(Executor & executor, Node & node, const R & identity, const Map & map, const Reduce & reduce, const std::size_t grain, const unsigned level)
+    {
+        if(! worth_splitting(node, grain, level)) {
+            R acc ( identity );
+
+            for(Node & n : hckt::preorder(node)) {
+                acc = reduce(acc, map(n));
+            }
+
+            return acc;
+        }
+
+        const unsigned     c_amnt { node.children_amnt() };
+        std::vector<slot<R>> parts (c_amnt, slot<R> { identity });
+
+        {
+            task_group<Executor> group { executor };
+
+            for(unsigned i=0; i<c_amnt; ++i) {
+                Node * c { node.child_at(i) };
+                R *    out { &parts[i].value };
+
+                group.spawn([&executor, c, out, &identity, &map, &reduce, grain, level]() {
+                    *out = reduce_nodes(executor, *c, identity, map, reduce, grain, level + 1);
+                });
+            }
+        }
+
+        R acc ( map(node) );
+
+        for(const slot<R> & part : parts) {
+            acc = reduce(acc, part.value);
+        }
+
+        return acc;
+    }
+
+    template <typename Executor, typename Node, typename F>
+    void for_each_node(Executor & executor, Node & node, const unsigned level, const F & f, const std::size_t grain)
+    {
+        if(! worth_splitting(node, grain, level)) {
+            for(auto it=hckt::preorder(node).begin(), end=hckt::preorder(node).end(); it != end; ++it) {
+                f(*it, level + it.level());
+            }
+
+            return;
+        }
+
+        task_group<Executor> group { executor };
+
+        for(unsigned i=0, c_amnt=node.children_amnt(); i<c_amnt; ++i) {
+            Node * c { node.child_at(i) };
+
+            group.spawn([&executor, c, level, &f, grain]() {
+                for_each_node(executor, *c, level + 1, f, grain);
+            });
+        }
+
+        f(node, level);
+    }
+
+    /*
+     * fill the empty dst with the masks and values of src and one new,
+     * empty node per child, returned through children
+     */
+    template <typename Tree>
+    void copy_node(const Tree & src, Tree & dst, Tree ** children)
+    {
+        typedef typename std::remove_reference<decltype(src.get_value(0))>::type value_type;
+
+        const std::uint64_t chiset { src.set_mask() };
+        const unsigned      c_amnt { src.children_amnt() };
+        value_type          values[64];
+        unsigned            vpos { 0 };
+
+        for(std::uint64_t set=chiset; set != 0; set &= set - 1) {
+            values[vpos++] = src.get_value(__builtin_ctzll(set));
+        }
+
+        for(unsigned i=0; i<c_amnt; ++i) {
+            children[i] = Tree::new_node();
+        }
+
+        dst.assign(chiset, ~src.leaf_mask(), values, children);
+    }
+
+    /*
+     * copy without recursion, pairs of nodes still to copy are kept on
+     * an explicit stack so depth is only limited by memory
+     */
+    template <typename Tree>
+    void clone_serial(const Tree & src, Tree & dst)
+    {
+        struct pending
+        {
+            const Tree * from;
+            Tree *       to;
+        };
+
+        std::vector<pending> work { pending { &src, &dst } };
+        Tree *               children[64];
+
+        while(! work.empty()) {
+            const pending p { work.back() };
+            work.pop_back();
+
+            copy_node(*p.from, *p.to, children);
+
+            for(unsigned i=0, c_amnt=p.from->children_amnt(); i<c_amnt; ++i) {
+                work.push_back(pending { p.from->child_at(i), children[i] });
+            }
+        }
+    }
+
+    template <typename Executor, typename Tree>
+    void clone_into(Executor & executor, const Tree & src, Tree & dst, const std::size_t grain, const unsigned level)
+    {
+        if(! worth_splitting(src, grain, level)) {
+            clone_serial(src, dst);
+            return;
+        }
+
+        Tree * children[64];
+
+        copy_node(src, dst, children);
+
+        task_group<Executor> group { executor };
+
+        for(unsigned i=0, c_amnt=src.children_amnt(); i<c_amnt; ++i) {
+            const Tree * from { src.child_at(i) };
+            Tree *       to   { children[i] };
+
+            group.spawn([&executor, from, to, grain, level]() {
+                clone_into(executor, *from, *to, grain, level + 1);
+            });
+        }
+    }
+
+    template <typename Executor, typename Tree>
+    void collapse(Executor & executor, Tree & t, const std::size_t grain, const unsigned level)
+    {
+        if(worth_splitting(t, grain, level)) {
+            task_group<Executor> group { executor };
+
+            for(unsigned i=0, c_amnt=t.children_amnt(); i<c_amnt; ++i) {
+                Tree * c { t.child_at(i) };
+
+                group.spawn([&executor, c, grain, level]() {
+                    collapse(executor, *c, grain, level + 1);
+                });
+            }
+        }
+
+        //children left are empty or below grain
+        t.collapse();
+    }
+};
+
+/*
+ * nodes whose children are estimated smaller than this many nodes each
+ * are not split
+ */
+constexpr std::size_t parallel_grain { 4096 };
+
+/*
+ * reduce(acc, map(node)) over every node below and including root
+ * map is called concurrently on different nodes, reduce has to be
+ * associative, partial results are combined in preorder
+ */
+template <typename Executor, typename Node, typename R, typename Map, typename Reduce>
+R parallel_reduce_nodes(Executor & executor, Node & root, const R & identity, const Map & map, const Reduce & reduce, const std::size_t grain = parallel_grain)
+{
+    return detail::reduce_nodes(executor, root, identity, map, reduce, detail::grain_for(executor, grain), 0);
+}
+
+/*
+ * reduce(acc, map(value)) over every leaf value
+ */
+template <typename Executor, typename Node, typename R, typename Map, typename Reduce>
+R parallel_map_reduce(Executor & executor, Node & root, const R & identity, const Map & map, const Reduce & reduce, const std::size_t grain = parallel_grain)
+{
+    return detail::reduce_nodes(executor, root, identity, [&identity, &map, &reduce](Node & n) {
+        R acc ( identity );
+
+        for(std::uint64_t leaves=n.leaf_mask(); leaves != 0; leaves &= leaves - 1) {
+            acc = reduce(acc, map(n.get_value(__builtin_ctzll(leaves))));
+        }
+
+        return acc;
+    }, reduce, detail::grain_for(executor, grain), 0);
+}
+
+/*
+ * f(position_ref) for every leaf position, concurrently and in no
+ * particular order
+ */
+template <typename Executor, typename Node, typename F>
+void parallel_for_each_leaf(Executor & executor, Node & root, const F & f, const std::size_t grain = parallel_grain)
+{
+    detail::for_each_node(executor, root, 0, [&f](Node & n, const unsigned level) {
+        for(std::uint64_t leaves=n.leaf_mask(); leaves != 0; leaves &= leaves - 1) {
+            f(position_ref<Node> { &n, static_cast<unsigned>(__builtin_ctzll(leaves)), level });
+        }
+    }, detail::grain_for(executor, grain));
+}
+
+/*
+ * deep copy of src into the empty tree dst
+ */
+template <typename Executor, template <typename, typename, typename> class Tree, typename T, typename Alloc, typename Growth>
+void parallel_clone(Executor & executor, const Tree<T, Alloc, Growth> & src, Tree<T, Alloc, Growth> & dst, const std::size_t grain = parallel_grain)
+{
+    static_assert(is_thread_safe_allocator<Alloc>::value, "parallel_clone allocates from several threads, use pool_allocator, heap_allocator or locked_allocator");
+
+    assert(! dst.has_children());
+
+    if(src.has_children()) {
+        detail::clone_into(executor, src, dst, detail::grain_for(executor, grain), 0);
+    }
+}
+
+/*
+ * t.collapse() with the subtrees freed in parallel
+ */
+template <typename Executor, template <typename, typename, typename> class Tree, typename T, typename Alloc, typename Growth>
+void parallel_collapse(Executor & executor, Tree<T, Alloc, Growth> & t, const std::size_t grain = parallel_grain)
+{
+    static_assert(is_thread_safe_allocator<Alloc>::value, "parallel_collapse frees from several threads, use pool_allocator, heap_allocator or locked_allocator");
+
+    detail::collapse(executor, t, detail::grain_for(executor, grain), 0);
+}
+
+};
+
+#endif
@@ -0,0 +1,897 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef HCKT_PERSISTENT_TREE_H
+#define HCKT_PERSISTENT_TREE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "allocator.hpp"
+#include "cow_node.hpp"
+#include "morton.hpp"
+#include "traversal.hpp"
+#include "util.hpp"
+
+namespace hckt
+{
+
+/*
+ * reference counted cow_nodes
+ *
+ * every node block is preceded by its count, which holds the number of
+ * parents pointing at the node plus the number of roots (trees and
+ * snapshots) it is; the shared empty node is not counted
+ *
+ * counts are atomic so snapshots can be dropped on any thread, the
+ * allocator then has to be thread safe as well
+ */
+template <typename T, typename Alloc>
+struct shared_nodes
+{
+    typedef cow_node<T>  node_type;
+    typedef cow_draft<T> draft;
+
+    static constexpr std::size_t header { sizeof(std::uint64_t) };
+
+    static_assert(sizeof(std::atomic<std::uint64_t>) <= header, "count has to fit in front of the node");
+
+    static std::atomic<std::uint64_t> & refs(const node_type * n)
+    {
+        return *reinterpret_cast<std::atomic<std::uint64_t>*>(reinterpret_cast<char*>(const_cast<node_type*>(n)) - header);
+    }
+
+    static std::size_t bytes(const node_type * n)
+    {
+        return header + node_type::bytes(n->children_amnt(), n->value_amount());
+    }
+
+    /*
+     * new node with a count of one
+     */
+    static const node_type * make(const draft & d)
+    {
+        if(d.chiset == 0) {
+            return node_type::empty();
+        }
+
+        char * mem { static_cast<char*>(Alloc::allocate(header + d.bytes())) };
+        new (mem) std::atomic<std::uint64_t> { 1 };
+
+        return d.write(mem + header);
+    }
+
+    /*
+     * free the block, references it holds are left alone
+     */
+    static void destroy(const node_type * n)
+    {
+        assert(n != node_type::empty());
+
+        const std::size_t size { bytes(n) };
+        std::atomic<std::uint64_t> & r = refs(n);
+
+        r.~atomic();
+        Alloc::deallocate(&r, size);
+    }
+
+    /*
+     * nodes are equal if their records are, children compare by identity
+     */
+    struct hash
+    {
+        std::size_t operator()(const node_type * n) const
+        {
+            const unsigned char * b    { reinterpret_cast<const unsigned char*>(n) };
+            const std::size_t     size { node_type::bytes(n->children_amnt(), n->value_amount()) };
+            std::uint64_t         h    { 0xcbf29ce484222325 };
+
+            for(std::size_t i=0; i<size; ++i) {
+                h = (h ^ b[i]) * 0x100000001b3;
+            }
+
+            return h;
+        }
+    };
+
+    struct equal
+    {
+        bool operator()(const node_type * a, const node_type * b) const
+        {
+            return a->chiset == b->chiset
+                && a->inv_leaf == b->inv_leaf
+                && std::memcmp(a, b, node_type::bytes(a->children_amnt(), a->value_amount())) == 0;
+        }
+    };
+
+    /*
+     * holds one reference to every node in it
+     */
+    typedef std::unordered_set<const node_type*, hash, equal> intern_table;
+
+    /*
+     * n with its fresh reference, or the equal node already in the table
+     * with a new reference instead
+     */
+    static const node_type * intern(intern_table & table, const node_type * n)
+    {
+        if(n == node_type::empty()) {
+            return n;
+        }
+
+        const auto found = table.insert(n);
+
+        if(! found.second) {
+            acquire(*found.first);
+            release(n);
+            return *found.first;
+        }
+
+        acquire(n);
+        return n;
+    }
+
+    /*
+     * give up the references of the table, nodes still in use elsewhere
+     * stay, a node's own table reference keeps it alive until it is
+     * released here, so the cascade never reaches one still listed
+     */
+    static void drop_table(intern_table & table)
+    {
+        const std::vector<const node_type*> held (table.begin(), table.end());
+
+        table.clear();
+
+        for(const node_type * n : held) {
+            release(n);
+        }
+    }
+
+    static bool unique(const node_type * n)
+    {
+        return n == node_type::empty() || refs(n).load(std::memory_order_acquire) == 1;
+    }
+
+    static void prefetch(const node_type * n)
+    {
+        if(n != node_type::empty()) {
+            __builtin_prefetch(&refs(n), 1);
+        }
+    }
+
+    static void acquire(const node_type * n)
+    {
+        if(n != node_type::empty()) {
+            refs(n).fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /*
+     * drop one reference, freeing every node that is left without one
+     */
+    static void release(const node_type * n)
+    {
+        std::vector<const node_type*> pending;
+
+        for(;;) {
+            if(n != node_type::empty() && refs(n).fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                for(unsigned i=0, c_amnt=n->children_amnt(); i<c_amnt; ++i) {
+                    pending.push_back(n->child_at(i));
+                }
+
+                destroy(n);
+            }
+
+            if(pending.empty()) {
+                return;
+            }
+
+            n = pending.back();
+            pending.pop_back();
+        }
+    }
+};
+
+/*
+ * immutable version of a persistent_tree, holds one reference to its root
+ * copying a snapshot is O(1) as well
+ */
+template <typename T, typename Alloc = hckt::heap_allocator>
+class persistent_snapshot
+{
+typedef T value_type;
+typedef shared_nodes<T, Alloc> nodes;
+
+public:
+    typedef cow_node<T> node_type;
+
+private:
+    const node_type * r;
+
+public:
+    explicit persistent_snapshot(const node_type * root) : r { root }
+    {
+        nodes::acquire(r);
+    }
+
+    persistent_snapshot(const persistent_snapshot & other) : r { other.r }
+    {
+        nodes::acquire(r);
+    }
+
+    persistent_snapshot & operator=(const persistent_snapshot & other)
+    {
+        nodes::acquire(other.r);
+        nodes::release(r);
+        r = other.r;
+
+        return *this;
+    }
+
+    ~persistent_snapshot()
+    {
+        nodes::release(r);
+    }
+
+    const node_type & root() const
+    {
+        return *r;
+    }
+
+    const value_type * find(const std::uint64_t x, const std::uint64_t y, const unsigned depth) const
+    {
+        return r->find(x, y, depth);
+    }
+
+    const value_type * find(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth) const
+    {
+        return r->find(x, y, z, depth);
+    }
+};
+
+/*
+ * map with O(1) snapshots
+ *
+ * nodes are immutable and shared between the tree and its snapshots, a
+ * write copies the nodes on its path and nothing else; nodes only the
+ * tree itself can reach are replaced right away, so after the first
+ * write below a shared node further writes there copy nothing that is
+ * still shared, and memory grows with the changes made since the
+ * snapshots rather than with the size of the tree
+ *
+ * one thread writes, snapshots can be read from any thread
+ */
+template <typename T, typename Alloc = hckt::heap_allocator>
+class persistent_tree
+{
+typedef T value_type;
+typedef shared_nodes<T, Alloc> nodes;
+typedef cow_draft<T>           draft;
+
+public:
+    typedef cow_node<T>                    node_type;
+    typedef persistent_snapshot<T, Alloc> snapshot_type;
+
+private:
+    typedef typename nodes::intern_table intern_table;
+
+    const node_type *             r;
+    std::unique_ptr<intern_table> interned; //online dedup when set
+
+    const node_type * make(const draft & d)
+    {
+        const node_type * n { nodes::make(d) };
+
+        return interned ? nodes::intern(*interned, n) : n;
+    }
+
+    /*
+     * the table finds equal nodes, only n itself counts
+     */
+    bool is_interned(const node_type * n) const
+    {
+        if(n == node_type::empty()) {
+            return false;
+        }
+
+        const auto it = interned->find(n);
+
+        return it != interned->end() && *it == n;
+    }
+
+    /*
+     * release for the writer, a node only the intern table is left
+     * holding is freed along with everything that ends up the same way
+     */
+    void drop(const node_type * n)
+    {
+        if(! interned || ! is_interned(n)) {
+            nodes::release(n);
+            return;
+        }
+
+        if(nodes::refs(n).fetch_sub(1, std::memory_order_acq_rel) == 2) {
+            purge(std::vector<const node_type*> { n });
+        }
+    }
+
+    /*
+     * free interned nodes only the table holds and the children that
+     * are left the same way
+     */
+    void purge(std::vector<const node_type*> dead)
+    {
+        while(! dead.empty()) {
+            const node_type * d { dead.back() };
+            dead.pop_back();
+
+            interned->erase(d);
+
+            std::vector<const node_type*> children;
+
+            for(unsigned i=0, c_amnt=d->children_amnt(); i<c_amnt; ++i) {
+                children.push_back(d->child_at(i));
+            }
+
+            nodes::destroy(d);
+
+            for(const node_type * c : children) {
+                if(is_interned(c)) {
+                    if(nodes::refs(c).fetch_sub(1, std::memory_order_acq_rel) == 2) {
+                        dead.push_back(c);
+                    }
+                } else {
+                    nodes::release(c);
+                }
+            }
+        }
+    }
+
+    /*
+     * rebuild the nodes old[0..amnt) bottom up
+     * change(d, level) edits the draft of each level, the path child of
+     * every level above the last is replaced by the node built below it
+     *
+     * the tree's reference to a path node goes away if its parent is
+     * freed, and the node itself is freed if that was its last one; the
+     * children a freed node shared with its copy are handed over, those
+     * of a node that stays get one more reference
+     */
+    template <typename Change>
+    void rebuild(const node_type * const * old, const unsigned * positions, const unsigned amnt, const Change & change)
+    {
+        bool exclusive[morton::max_depth_3d];
+        bool parent_exclusive { true };
+
+        for(unsigned l=0; l<amnt; ++l) {
+            exclusive[l]     = parent_exclusive && nodes::unique(old[l]);
+            parent_exclusive = exclusive[l];
+        }
+
+        const node_type * built { nullptr };
+
+        for(unsigned l=amnt; l-- > 0; ) {
+            draft d { *old[l] };
+            const bool last { l + 1 == amnt };
+
+            change(d, l);
+
+            if(! last) {
+                d.set_child(positions[l], built);
+            }
+
+            //children both versions point at, their counts sit in as many
+            //cache lines, so all of them are requested up front
+            std::uint64_t shared { d.chidist() & old[l]->chidist() };
+
+            if(! last) {
+                shared &= ~(std::uint64_t { 1 } << positions[l]);
+            }
+
+            if(! exclusive[l]) {
+                for(std::uint64_t s=shared; s != 0; s &= s - 1) {
+                    nodes::prefetch(d.children[__builtin_ctzll(s)]);
+                }
+
+                for(; shared != 0; shared &= shared - 1) {
+                    nodes::acquire(d.children[__builtin_ctzll(shared)]);
+                }
+            }
+
+            //children only the old version points at
+            for(std::uint64_t gone=old[l]->chidist() & ~d.chidist(); gone != 0; gone &= gone - 1) {
+                if(exclusive[l]) {
+                    drop(old[l]->child(__builtin_ctzll(gone)));
+                }
+            }
+
+            const bool dropped { l == 0 || exclusive[l - 1] };
+
+            if(old[l] != node_type::empty() && dropped) {
+                if(exclusive[l]) {
+                    nodes::destroy(old[l]);
+                } else {
+                    drop(old[l]);
+                }
+            }
+
+            built = make(d);
+        }
+
+        r = built;
+    }
+
+    /*
+     * build from any tree through its read only interface, bottom up in
+     * postorder so every child exists before its parent
+     */
+    template <typename Node>
+    static const node_type * convert(const Node & root)
+    {
+        std::vector<std::vector<const node_type*>> built;
+
+        for(auto it=hckt::postorder(root).begin(), end=hckt::postorder(root).end(); it != end; ++it) {
+            const Node &   n     = *it;
+            const unsigned level { it.level() };
+
+            if(built.size() < level + 2) {
+                built.resize(level + 2);
+            }
+
+            draft d { *node_type::empty() };
+            std::vector<const node_type*> & children = built[level + 1];
+            unsigned cpos { 0 };
+
+            for(std::uint64_t set=n.set_mask(); set != 0; set &= set - 1) {
+                const unsigned pos ( __builtin_ctzll(set) );
+
+                if(n.is_leaf(pos)) {
+                    d.set_leaf(pos, n.get_value(pos));
+                } else {
+                    d.set_child(pos, children[cpos++]);
+                    d.values[pos] = n.get_value(pos);
+                }
+            }
+
+            children.clear();
+            built[level].push_back(nodes::make(d));
+        }
+
+        return built[0].back();
+    }
+
+public:
+    persistent_tree() : r { node_type::empty() }, interned { }
+    {
+    }
+
+    /*
+     * copy of a tree, block_tree, frozen_node, ...
+     */
+    template <typename Node>
+    explicit persistent_tree(const Node & root) : r { convert(root) }, interned { }
+    {
+    }
+
+    /*
+     * O(1), the copies share every node until one of them writes
+     * the copy starts without online dedup
+     */
+    persistent_tree(const persistent_tree & other) : r { other.r }, interned { }
+    {
+        nodes::acquire(r);
+    }
+
+    persistent_tree & operator=(const persistent_tree & other)
+    {
+        nodes::acquire(other.r);
+        drop(r);
+        r = other.r;
+
+        return *this;
+    }
+
+    ~persistent_tree()
+    {
+        drop(r);
+        set_dedup(false);
+    }
+
+    const node_type & root() const
+    {
+        return *r;
+    }
+
+    /*
+     * O(1) immutable view of the current state
+     */
+    snapshot_type snapshot() const
+    {
+        return snapshot_type { r };
+    }
+
+    /*
+     * go back to the state of a snapshot, O(1)
+     */
+    void restore(const snapshot_type & s)
+    {
+        const node_type * old { r };
+
+        r = &s.root();
+        nodes::acquire(r);
+        drop(old);
+    }
+
+    /*
+     * merge identical subtrees of the current version into shared nodes
+     * (hash consing), bottom up: a node is looked up by its masks, its
+     * values and its already merged children
+     * snapshots keep the nodes they had
+     */
+    void deduplicate()
+    {
+        intern_table local;
+        intern_table & table = interned ? *interned : local;
+
+        struct frame
+        {
+            const node_type * node;
+            unsigned          next;
+        };
+
+        std::unordered_map<const node_type*, const node_type*> merged; //old node to its merged version, owned by table
+        std::vector<frame> stack { frame { r, 0 } };
+
+        merged[node_type::empty()] = node_type::empty();
+
+        while(! stack.empty()) {
+            frame & f = stack.back();
+
+            if(f.next < f.node->children_amnt()) {
+                const node_type * c { f.node->child_at(f.next++) };
+
+                if(merged.count(c) == 0) {
+                    stack.push_back(frame { c, 0 });
+                }
+
+                continue;
+            }
+
+            draft d { *f.node };
+
+            for(std::uint64_t set=d.chidist(); set != 0; set &= set - 1) {
+                const unsigned pos ( __builtin_ctzll(set) );
+
+                d.children[pos] = merged[d.children[pos]];
+                nodes::acquire(d.children[pos]);
+            }
+
+            const node_type * n { nodes::intern(table, nodes::make(d)) };
+
+            //the table keeps the node, the reference from intern is not needed
+            if(n != node_type::empty()) {
+                nodes::refs(n).fetch_sub(1, std::memory_order_relaxed);
+            }
+
+            merged[f.node] = n;
+            stack.pop_back();
+        }
+
+        const node_type * old { r };
+
+        r = merged[old];
+        nodes::acquire(r);
+        drop(old);
+
+        if(! interned) {
+            nodes::drop_table(local);
+        }
+    }
+
+    /*
+     * online dedup: every node written is merged with an equal existing
+     * one, switching it on deduplicates the current version
+     * the table keeps one reference to each node it knows, nodes only it
+     * holds are freed as writes let go of them, those dropped by
+     * snapshots wait for collect()
+     */
+    void set_dedup(const bool online)
+    {
+        if(online && ! interned) {
+            interned.reset(new intern_table());
+            deduplicate();
+        }
+
+        if(! online && interned) {
+            nodes::drop_table(*interned);
+            interned.reset();
+        }
+    }
+
+    bool dedup() const
+    {
+        return static_cast<bool>(interned);
+    }
+
+    /*
+     * free the nodes only the online dedup table still holds
+     */
+    void collect()
+    {
+        if(! interned) {
+            return;
+        }
+
+        std::vector<const node_type*> dead;
+
+        for(const node_type * n : *interned) {
+            if(nodes::refs(n).load(std::memory_order_acquire) == 1) {
+                dead.push_back(n);
+            }
+        }
+
+        purge(std::move(dead));
+    }
+
+    const value_type * find(const std::uint64_t x, const std::uint64_t y, const unsigned depth) const
+    {
+        return r->find(x, y, depth);
+    }
+
+    const value_type * find(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth) const
+    {
+        return r->find(x, y, z, depth);
+    }
+
+    /*
+     * set the value of a cell like tree::insert, creating nodes along
+     * the way
+     */
+    void insert(const std::uint64_t x, const std::uint64_t y, const value_type value, const unsigned depth)
+    {
+        hckt::morton::path<2> p { x, y, depth };
+        insert_path(p, value);
+    }
+
+    void insert(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const value_type value, const unsigned depth)
+    {
+        hckt::morton::path<3> p { x, y, z, depth };
+        insert_path(p, value);
+    }
+
+    /*
+     * remove the position find() would return, with its subtree
+     * false if nothing is set there
+     */
+    bool erase(const std::uint64_t x, const std::uint64_t y, const unsigned depth)
+    {
+        hckt::morton::path<2> p { x, y, depth };
+        return erase_path(p);
+    }
+
+    bool erase(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth)
+    {
+        hckt::morton::path<3> p { x, y, z, depth };
+        return erase_path(p);
+    }
+
+    template <typename Path>
+    void insert_path(Path & p, const value_type value)
+    {
+        assert(! p.done());
+
+        const node_type * old[morton::max_depth_3d];
+        unsigned          positions[morton::max_depth_3d];
+        unsigned          amnt { 0 };
+        const node_type * node { r };
+
+        while(true) {
+            const unsigned pos { p.next() };
+
+            old[amnt]       = node;
+            positions[amnt] = pos;
+            ++amnt;
+
+            if(p.done()) {
+                break;
+            }
+
+            node = node->is_set(pos) && ! node->is_leaf(pos) ? node->child(pos) : node_type::empty();
+        }
+
+        const unsigned last { amnt - 1 };
+
+        rebuild(old, positions, amnt, [last, &positions, value](draft & d, const unsigned level) {
+            const unsigned pos { positions[level] };
+
+            if(level != last) {
+                return;
+            }
+
+            if(d.is_set(pos) && ! d.is_leaf(pos)) {
+                d.values[pos] = value;
+            } else {
+                d.set_leaf(pos, value);
+            }
+        });
+    }
+
+    template <typename Path>
+    bool erase_path(Path & p)
+    {
+        assert(! p.done());
+
+        const node_type * old[morton::max_depth_3d];
+        unsigned          positions[morton::max_depth_3d];
+        unsigned          amnt { 0 };
+        const node_type * node { r };
+
+        while(true) {
+            const unsigned pos { p.next() };
+
+            if(! node->is_set(pos)) {
+                return false;
+            }
+
+            old[amnt]       = node;
+            positions[amnt] = pos;
+            ++amnt;
+
+            if(p.done() || node->is_leaf(pos)) {
+                break;
+            }
+
+            node = node->child(pos);
+        }
+
+        const unsigned last { amnt - 1 };
+
+        rebuild(old, positions, amnt, [last, &positions](draft & d, const unsigned level) {
+            if(level == last) {
+                d.unset(positions[level]);
+            }
+        });
+
+        return true;
+    }
+
+    /*
+     * nodes of the current version as a tree, shared ones counted for
+     * every parent, empty children left out
+     */
+    std::size_t calculate_logical_nodes() const
+    {
+        std::unordered_map<const node_type*, std::size_t> below; //subtree size of a visited node
+        std::vector<std::pair<const node_type*, unsigned>> stack { std::make_pair(r, 0u) };
+
+        below[node_type::empty()] = 0;
+
+        while(! stack.empty()) {
+            std::pair<const node_type*, unsigned> & f = stack.back();
+
+            if(f.second < f.first->children_amnt()) {
+                const node_type * c { f.first->child_at(f.second++) };
+
+                if(below.count(c) == 0) {
+                    stack.push_back(std::make_pair(c, 0u));
+                }
+
+                continue;
+            }
+
+            std::size_t amnt { 1 };
+
+            for(unsigned i=0, c_amnt=f.first->children_amnt(); i<c_amnt; ++i) {
+                amnt += below[f.first->child_at(i)];
+            }
+
+            below[f.first] = amnt;
+            stack.pop_back();
+        }
+
+        return r == node_type::empty() ? 1 : below[r];
+    }
+
+    /*
+     * distinct nodes of the current version, the empty node only counts
+     * when it is the root
+     */
+    std::size_t calculate_stored_nodes() const
+    {
+        std::unordered_set<const node_type*> seen { r };
+        std::vector<const node_type*> stack { r };
+
+        while(! stack.empty()) {
+            const node_type * n { stack.back() };
+            stack.pop_back();
+
+            for(unsigned i=0, c_amnt=n->children_amnt(); i<c_amnt; ++i) {
+                if(seen.insert(n->child_at(i)).second) {
+                    stack.push_back(n->child_at(i));
+                }
+            }
+        }
+
+        return seen.size() - (r != node_type::empty() && seen.count(node_type::empty()) != 0);
+    }
+
+    /*
+     * bytes of the distinct nodes of the current version
+     */
+    std::size_t calculate_memory_size() const
+    {
+        std::unordered_set<const node_type*> seen { r };
+        std::vector<const node_type*> stack { r };
+        std::size_t size { 0 };
+
+        while(! stack.empty()) {
+            const node_type * n { stack.back() };
+            stack.pop_back();
+
+            if(n != node_type::empty()) {
+                size += nodes::bytes(n);
+            }
+
+            for(unsigned i=0, c_amnt=n->children_amnt(); i<c_amnt; ++i) {
+                if(seen.insert(n->child_at(i)).second) {
+                    stack.push_back(n->child_at(i));
+                }
+            }
+        }
+
+        return size;
+    }
+
+    void mem_usage_info() const
+    {
+        const std::size_t stored  { calculate_stored_nodes() };
+        const std::size_t logical { calculate_logical_nodes() };
+
+        std::cout << "total:     " << hckt::render_size(calculate_memory_size()) << std::endl;
+        std::cout << "nodes:     " << hckt::render_number(stored) << " stored for " << hckt::render_number(logical) << std::endl;
+        std::cout << "dedup:     " << (static_cast<double>(logical) / stored) << " x" << std::endl;
+
+        if(interned) {
+            std::cout << "interned:  " << hckt::render_number(interned->size()) << std::endl;
+        }
+    }
+};
+
+template <typename T, typename Alloc>
+constexpr std::size_t shared_nodes<T, Alloc>::header;
+
+};
+
+#endif
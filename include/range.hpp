@@ -0,0 +1,312 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_RANGE_H
+#define HCKT_RANGE_H
+
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include "morton.hpp"
+
+namespace hckt
+{
+
+/*
+ * node masks of axis aligned regions
+ *
+ * in 2d a node is 8x8 cells, in 3d 4x4x4, so the positions inside a
+ * box of node local cells are the AND of one interval mask per axis
+ * every interval of every axis is tabled once, a box is Dim lookups
+ */
+namespace region
+{
+    struct tables
+    {
+        std::uint64_t axis_2d[2][8][8]; //[axis][first][last]
+        std::uint64_t axis_3d[3][4][4];
+
+        tables() : axis_2d { }, axis_3d { }
+        {
+            for(unsigned pos=0; pos<64; ++pos) {
+                const std::uint64_t bit { std::uint64_t { 1 } << pos };
+                std::uint64_t c2[2];
+                std::uint64_t c3[3];
+
+                morton::decode_2d(pos, c2[0], c2[1]);
+                morton::decode_3d(pos, c3[0], c3[1], c3[2]);
+
+                for(unsigned axis=0; axis<2; ++axis) {
+                    for(unsigned first=0; first<=c2[axis]; ++first) {
+                        for(unsigned last=c2[axis]; last<8; ++last) {
+                            axis_2d[axis][first][last] |= bit;
+                        }
+                    }
+                }
+
+                for(unsigned axis=0; axis<3; ++axis) {
+                    for(unsigned first=0; first<=c3[axis]; ++first) {
+                        for(unsigned last=c3[axis]; last<4; ++last) {
+                            axis_3d[axis][first][last] |= bit;
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    inline const tables & get_tables()
+    {
+        static const tables t;
+        return t;
+    }
+
+    /*
+     * positions with lo[i] <= coordinate i <= hi[i], node local and inclusive
+     */
+    inline std::uint64_t mask_2d(const unsigned * lo, const unsigned * hi)
+    {
+        const tables & t = get_tables();
+
+        assert(lo[0] <= hi[0] && hi[0] < 8);
+        assert(lo[1] <= hi[1] && hi[1] < 8);
+
+        return t.axis_2d[0][lo[0]][hi[0]] & t.axis_2d[1][lo[1]][hi[1]];
+    }
+
+    inline std::uint64_t mask_3d(const unsigned * lo, const unsigned * hi)
+    {
+        const tables & t = get_tables();
+
+        assert(lo[0] <= hi[0] && hi[0] < 4);
+        assert(lo[1] <= hi[1] && hi[1] < 4);
+        assert(lo[2] <= hi[2] && hi[2] < 4);
+
+        return t.axis_3d[0][lo[0]][hi[0]] & t.axis_3d[1][lo[1]][hi[1]] & t.axis_3d[2][lo[2]][hi[2]];
+    }
+};
+
+/*
+ * what the output iterator versions of the queries emit
+ * x, y (and z) are the lowest cell at the query depth, a leaf above the
+ * query depth covers size cells along every axis
+ */
+template <typename T>
+struct rect_hit
+{
+    std::uint64_t x;
+    std::uint64_t y;
+    std::uint64_t size;
+    T             value;
+};
+
+template <typename T>
+struct box_hit
+{
+    std::uint64_t x;
+    std::uint64_t y;
+    std::uint64_t z;
+    std::uint64_t size;
+    T             value;
+};
+
+namespace detail
+{
+    inline std::uint64_t mask(std::integral_constant<unsigned, 2>, const unsigned * lo, const unsigned * hi)
+    {
+        return region::mask_2d(lo, hi);
+    }
+
+    inline std::uint64_t mask(std::integral_constant<unsigned, 3>, const unsigned * lo, const unsigned * hi)
+    {
+        return region::mask_3d(lo, hi);
+    }
+
+    /*
+     * node local bounds of the part of the box [lo, hi] inside node
+     * false if node does not intersect it
+     */
+    template <unsigned Dim>
+    bool clip(const std::uint64_t * origin, const unsigned shift, const std::uint64_t * lo, const std::uint64_t * hi, unsigned * l, unsigned * h)
+    {
+        constexpr unsigned last { (1u << (6 / Dim)) - 1 };
+
+        for(unsigned d=0; d<Dim; ++d) {
+            if(hi[d] < origin[d]) {
+                return false;
+            }
+
+            const std::uint64_t bottom { lo[d] <= origin[d] ? 0 : (lo[d] - origin[d]) >> shift };
+            const std::uint64_t top    { (hi[d] - origin[d]) >> shift };
+
+            if(bottom > last) {
+                return false;
+            }
+
+            l[d] = static_cast<unsigned>(bottom);
+            h[d] = top < last ? static_cast<unsigned>(top) : last;
+        }
+
+        return true;
+    }
+
+    /*
+     * lowest cell of position pos of a node at origin
+     */
+    template <unsigned Dim>
+    void position_cell(const unsigned pos, const std::uint64_t * origin, const unsigned shift, std::uint64_t * cell)
+    {
+        std::uint64_t local[3];
+
+        if(Dim == 2) {
+            morton::decode_2d(pos, local[0], local[1]);
+        } else {
+            morton::decode_3d(pos, local[0], local[1], local[2]);
+        }
+
+        for(unsigned d=0; d<Dim; ++d) {
+            cell[d] = origin[d] + (local[d] << shift);
+        }
+    }
+
+    template <typename F, typename T>
+    void emit(std::integral_constant<unsigned, 2>, F & f, const std::uint64_t * cell, const std::uint64_t size, const T & value)
+    {
+        f(cell[0], cell[1], size, value);
+    }
+
+    template <typename F, typename T>
+    void emit(std::integral_constant<unsigned, 3>, F & f, const std::uint64_t * cell, const std::uint64_t size, const T & value)
+    {
+        f(cell[0], cell[1], cell[2], size, value);
+    }
+
+    /*
+     * origin is the lowest cell of node, shift the log2 of the cells one
+     * position covers, lo and hi the query box at full resolution
+     * node has to intersect the box
+     */
+    template <unsigned Dim, typename Node, typename F>
+    void range_walk(const Node & node, const std::uint64_t * origin, const unsigned shift, const std::uint64_t * lo, const std::uint64_t * hi, F & f)
+    {
+        constexpr unsigned axis_bits { 6 / Dim };
+
+        unsigned l[Dim];
+        unsigned h[Dim];
+
+        //only the root can miss, children are entered when they intersect
+        if(! clip<Dim>(origin, shift, lo, hi, l, h)) {
+            return;
+        }
+
+        const std::uint64_t leaves { node.leaf_mask() };
+        std::uint64_t       hits   { node.set_mask() & mask(std::integral_constant<unsigned, Dim> { }, l, h) };
+
+        while(hits != 0) {
+            const unsigned pos ( __builtin_ctzll(hits) );
+            std::uint64_t  cell[Dim];
+
+            hits &= hits - 1;
+            position_cell<Dim>(pos, origin, shift, cell);
+
+            if(shift == 0 || ((leaves >> pos) & 1)) {
+                emit(std::integral_constant<unsigned, Dim> { }, f, cell, std::uint64_t { 1 } << shift, node.get_value(pos));
+            } else {
+                range_walk<Dim>(*node.child(pos), cell, shift - axis_bits, lo, hi, f);
+            }
+        }
+    }
+};
+
+/*
+ * every set position inside the rectangle [x0, x1] x [y0, y1] of cells at
+ * depth, bounds inclusive, calls f(x, y, size, value) per hit
+ *
+ * each node costs one AND of chiset with a tabled region mask, so empty
+ * and outside positions are never looked at and the work follows the
+ * number of hits instead of the size of the tree
+ * works on tree, block_tree and frozen_node
+ */
+template <typename Node, typename F>
+void for_each_in_rect(const Node & root, const std::uint64_t x0, const std::uint64_t y0, const std::uint64_t x1, const std::uint64_t y1, const unsigned depth, F f)
+{
+    assert(depth > 0);
+    assert(depth <= morton::max_depth_2d);
+    assert(x0 <= x1 && y0 <= y1);
+
+    const std::uint64_t origin[2] { 0, 0 };
+    const std::uint64_t lo[2]     { x0, y0 };
+    const std::uint64_t hi[2]     { x1, y1 };
+
+    detail::range_walk<2>(root, origin, 3 * (depth - 1), lo, hi, f);
+}
+
+/*
+ * every set position inside the box [x0, x1] x [y0, y1] x [z0, z1] of
+ * cells at depth, calls f(x, y, z, size, value) per hit
+ */
+template <typename Node, typename F>
+void for_each_in_box(const Node & root, const std::uint64_t x0, const std::uint64_t y0, const std::uint64_t z0, const std::uint64_t x1, const std::uint64_t y1, const std::uint64_t z1, const unsigned depth, F f)
+{
+    assert(depth > 0);
+    assert(depth <= morton::max_depth_3d);
+    assert(x0 <= x1 && y0 <= y1 && z0 <= z1);
+
+    const std::uint64_t origin[3] { 0, 0, 0 };
+    const std::uint64_t lo[3]     { x0, y0, z0 };
+    const std::uint64_t hi[3]     { x1, y1, z1 };
+
+    detail::range_walk<3>(root, origin, 2 * (depth - 1), lo, hi, f);
+}
+
+/*
+ * same queries writing rect_hit / box_hit to out
+ */
+template <typename Node, typename OutputIterator>
+OutputIterator copy_in_rect(const Node & root, const std::uint64_t x0, const std::uint64_t y0, const std::uint64_t x1, const std::uint64_t y1, const unsigned depth, OutputIterator out)
+{
+    typedef typename std::remove_const<typename std::remove_reference<decltype(root.get_value(0))>::type>::type value_type;
+
+    for_each_in_rect(root, x0, y0, x1, y1, depth, [&out](const std::uint64_t x, const std::uint64_t y, const std::uint64_t size, const value_type & value) {
+        *out++ = rect_hit<value_type> { x, y, size, value };
+    });
+
+    return out;
+}
+
+template <typename Node, typename OutputIterator>
+OutputIterator copy_in_box(const Node & root, const std::uint64_t x0, const std::uint64_t y0, const std::uint64_t z0, const std::uint64_t x1, const std::uint64_t y1, const std::uint64_t z1, const unsigned depth, OutputIterator out)
+{
+    typedef typename std::remove_const<typename std::remove_reference<decltype(root.get_value(0))>::type>::type value_type;
+
+    for_each_in_box(root, x0, y0, z0, x1, y1, z1, depth, [&out](const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const std::uint64_t size, const value_type & value) {
+        *out++ = box_hit<value_type> { x, y, z, size, value };
+    });
+
+    return out;
+}
+
+};
+
+#endif
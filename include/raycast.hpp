@@ -0,0 +1,492 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_RAYCAST_H
+#define HCKT_RAYCAST_H
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "morton.hpp"
+#include "nearest.hpp"
+
+namespace hckt
+{
+
+/*
+ * ray traversal of 3d trees
+ *
+ * rays live in cell coordinates at the traversal depth, the tree spans
+ * [0, 4^depth) on every axis; a hit is reported as neighbor<box_hit<T>>
+ * whose distance is the ray parameter t where the ray enters the cell,
+ * so it is euclidean only for unit directions
+ *
+ * coordinates are doubles, so depth is limited to 26 (2^52 cells per axis)
+ */
+struct ray
+{
+    double origin[3];
+    double direction[3];
+};
+
+namespace detail
+{
+    constexpr unsigned max_ray_depth { 26 };
+
+    /*
+     * [t0, t1] where r is inside [lo, lo + size) on every axis, false if empty
+     */
+    inline bool slab(const double * origin, const double * inv, const double * lo, const double size, double & t0, double & t1)
+    {
+        for(unsigned d=0; d<3; ++d) {
+            const double hi { lo[d] + size };
+
+            if(std::isinf(inv[d])) {
+                if(origin[d] < lo[d] || origin[d] > hi) {
+                    return false;
+                }
+
+                continue;
+            }
+
+            double a { (lo[d] - origin[d]) * inv[d] };
+            double b { (hi - origin[d]) * inv[d] };
+
+            if(a > b) {
+                const double s { a };
+                a = b;
+                b = s;
+            }
+
+            t0 = a > t0 ? a : t0;
+            t1 = b < t1 ? b : t1;
+        }
+
+        return t0 <= t1;
+    }
+
+    /*
+     * steps through the 4x4x4 positions of a node in the order a ray
+     * crosses them, starting where it is at t0
+     */
+    class dda
+    {
+        const ray &    r;
+        const double * inv;
+        double         corner[3];
+        double         size;
+        int            idx[3];
+        int            step[3];
+        double         tnext[3]; //where the ray leaves the current position along each axis
+        double         t;        //where it entered the current position
+
+        double boundary(const unsigned d) const
+        {
+            if(step[d] == 0) {
+                return std::numeric_limits<double>::infinity();
+            }
+
+            return (corner[d] + (idx[d] + (step[d] > 0 ? 1 : 0)) * size - r.origin[d]) * inv[d];
+        }
+
+        unsigned axis() const
+        {
+            return tnext[0] < tnext[1] ? (tnext[0] < tnext[2] ? 0u : 2u) : (tnext[1] < tnext[2] ? 1u : 2u);
+        }
+
+    public:
+        dda(const ray & r, const double * inv, const std::uint64_t * node_corner, const unsigned shift, const double t0)
+            : r { r }, inv { inv }, corner { }, size ( static_cast<double>(std::uint64_t { 1 } << shift) ), idx { }, step { }, tnext { }, t { t0 }
+        {
+            for(unsigned d=0; d<3; ++d) {
+                corner[d] = static_cast<double>(node_corner[d]);
+
+                const double c { std::floor((r.origin[d] + r.direction[d] * t0 - corner[d]) / size) };
+
+                idx[d]  = c < 0 ? 0 : c > 3 ? 3 : static_cast<int>(c);
+                step[d] = r.direction[d] > 0 ? 1 : r.direction[d] < 0 ? -1 : 0;
+                tnext[d] = boundary(d);
+
+                //entering exactly on a face, start on the side the ray moves to
+                if(tnext[d] <= t0 && idx[d] + step[d] >= 0 && idx[d] + step[d] <= 3) {
+                    idx[d] += step[d];
+                    tnext[d] = boundary(d);
+                }
+            }
+        }
+
+        unsigned position() const
+        {
+            return (idx[0] & 1) << 2 | (idx[0] & 2) << 4 | (idx[1] & 1) << 1 | (idx[1] & 2) << 3 | (idx[2] & 1) | (idx[2] & 2) << 2;
+        }
+
+        void local(std::uint64_t * cell) const
+        {
+            for(unsigned d=0; d<3; ++d) {
+                cell[d] = static_cast<std::uint64_t>(idx[d]);
+            }
+        }
+
+        double enter() const
+        {
+            return t;
+        }
+
+        double leave() const
+        {
+            return tnext[axis()];
+        }
+
+        /*
+         * move to the next position, false once the ray left the node or passed t1
+         */
+        bool next(const double t1)
+        {
+            const unsigned a { axis() };
+
+            if(tnext[a] > t1) {
+                return false;
+            }
+
+            idx[a] += step[a];
+
+            if(idx[a] < 0 || idx[a] > 3) {
+                return false;
+            }
+
+            t = tnext[a];
+            tnext[a] = boundary(a);
+            return true;
+        }
+    };
+
+    /*
+     * DDA over the positions of node for t in [t0, t1]
+     * corner is the lowest cell of node, shift the log2 of the cells one
+     * position spans; set positions are visited in ray order, empty ones
+     * are stepped over without touching memory, children are only entered
+     * for the part of the ray inside their position
+     * returns false once f asked to stop
+     */
+    template <typename Node, typename F>
+    bool dda_walk(const Node & node, const std::uint64_t * corner, const unsigned shift, const ray & r, const double * inv, const double t0, const double t1, F & f)
+    {
+        const std::uint64_t set { node.set_mask() };
+
+        //whole 4x4x4 block empty
+        if(set == 0) {
+            return true;
+        }
+
+        const std::uint64_t leaves { node.leaf_mask() };
+        dda                 cells  { r, inv, corner, shift, t0 };
+
+        do {
+            const unsigned pos { cells.position() };
+
+            if(! ((set >> pos) & 1)) {
+                continue;
+            }
+
+            std::uint64_t cell[3];
+            cells.local(cell);
+
+            for(unsigned d=0; d<3; ++d) {
+                cell[d] = corner[d] + (cell[d] << shift);
+            }
+
+            if(shift == 0 || ((leaves >> pos) & 1)) {
+                if(! f(cell, std::uint64_t { 1 } << shift, node.get_value(pos), cells.enter())) {
+                    return false;
+                }
+            } else {
+                const double texit { cells.leave() < t1 ? cells.leave() : t1 };
+
+                if(! dda_walk(*node.child(pos), cell, shift - 2, r, inv, cells.enter(), texit, f)) {
+                    return false;
+                }
+            }
+        } while(cells.next(t1));
+
+        return true;
+    }
+
+    inline void inverse(const ray & r, double * inv)
+    {
+        for(unsigned d=0; d<3; ++d) {
+            inv[d] = r.direction[d] == 0 ? std::numeric_limits<double>::infinity() : 1.0 / r.direction[d];
+        }
+    }
+
+    /*
+     * clip r to the tree and walk it
+     */
+    template <typename Node, typename F>
+    void raycast(const Node & root, const ray & r, const unsigned depth, const double tmin, const double tmax, F & f)
+    {
+        assert(depth > 0);
+        assert(depth <= max_ray_depth);
+
+        const std::uint64_t corner[3] { 0, 0, 0 };
+        const double        lo[3]     { 0, 0, 0 };
+        double inv[3];
+        double t0 { tmin };
+        double t1 { tmax };
+
+        inverse(r, inv);
+
+        if(slab(r.origin, inv, lo, static_cast<double>(std::uint64_t { 1 } << (2 * depth)), t0, t1)) {
+            dda_walk(root, corner, 2 * (depth - 1), r, inv, t0, t1, f);
+        }
+    }
+};
+
+/*
+ * every set cell pierced by r for t in [tmin, tmax], nearest first
+ * calls f(x, y, z, size, value, t) and stops once it returns false
+ * works on tree, block_tree and frozen_node built from 3d coordinates
+ */
+template <typename Node, typename F>
+void for_each_on_ray(const Node & root, const ray & r, const unsigned depth, F f, const double tmin = 0, const double tmax = std::numeric_limits<double>::infinity())
+{
+    typedef typename std::remove_const<typename std::remove_reference<decltype(root.get_value(0))>::type>::type value_type;
+
+    auto forward = [&f](const std::uint64_t * cell, const std::uint64_t size, const value_type & value, const double t) -> bool {
+        return f(cell[0], cell[1], cell[2], size, value, t);
+    };
+
+    detail::raycast(root, r, depth, tmin, tmax, forward);
+}
+
+/*
+ * nearest set cell pierced by r, false if there is none within [tmin, tmax]
+ */
+template <typename Node, typename T>
+bool raycast_first(const Node & root, const ray & r, const unsigned depth, neighbor<box_hit<T>> & hit, const double tmin = 0, const double tmax = std::numeric_limits<double>::infinity())
+{
+    bool found { false };
+
+    auto first = [&hit, &found](const std::uint64_t * cell, const std::uint64_t size, const T & value, const double t) -> bool {
+        hit   = neighbor<box_hit<T>> { box_hit<T> { cell[0], cell[1], cell[2], size, value }, t };
+        found = true;
+        return false;
+    };
+
+    detail::raycast(root, r, depth, tmin, tmax, first);
+    return found;
+}
+
+/*
+ * every set cell pierced by r, nearest first, written to out
+ */
+template <typename Node, typename OutputIterator>
+OutputIterator raycast_all(const Node & root, const ray & r, const unsigned depth, OutputIterator out, const double tmin = 0, const double tmax = std::numeric_limits<double>::infinity())
+{
+    typedef typename std::remove_const<typename std::remove_reference<decltype(root.get_value(0))>::type>::type value_type;
+
+    auto all = [&out](const std::uint64_t * cell, const std::uint64_t size, const value_type & value, const double t) -> bool {
+        *out++ = neighbor<box_hit<value_type>> { box_hit<value_type> { cell[0], cell[1], cell[2], size, value }, t };
+        return true;
+    };
+
+    detail::raycast(root, r, depth, tmin, tmax, all);
+    return out;
+}
+
+namespace detail
+{
+    /*
+     * up to 64 rays sharing the signs of their directions
+     */
+    template <typename T>
+    struct ray_packet
+    {
+        const ray *            rays[64];
+        double                 inv[64][3];
+        double                 tmin[64];
+        double                 tmax[64];
+        neighbor<box_hit<T>> * hits[64];
+        bool *                 found[64];
+        unsigned               flip;    //position xor giving front to back order
+        std::uint64_t          pending; //rays without a hit yet
+    };
+
+    /*
+     * with all direction signs equal, morton order of the positions with
+     * the negative axes mirrored is front to back for every ray: a ray
+     * only moves up (or only down) each axis, and morton order is
+     * monotone in each coordinate; so the first hit a ray meets in this
+     * order is its nearest
+     *
+     * every node is loaded once per packet, each ray runs the DDA of
+     * dda_walk over it without touching memory to find the positions it
+     * crosses, then the packet visits the union of those in order
+     */
+    template <typename Node, typename T>
+    void packet_walk(const Node & node, const std::uint64_t * corner, const unsigned shift, ray_packet<T> & p, std::uint64_t active)
+    {
+        const std::uint64_t set { node.set_mask() };
+
+        if(set == 0) {
+            return;
+        }
+
+        const std::uint64_t leaves  { node.leaf_mask() };
+        const std::uint64_t size    { std::uint64_t { 1 } << shift };
+        const double        edge    ( static_cast<double>(size << 2) );
+        const double        lo[3]   { static_cast<double>(corner[0]), static_cast<double>(corner[1]), static_cast<double>(corner[2]) };
+        std::uint64_t       crossed { 0 };
+        std::uint64_t       rays_at[64];
+        double              enter[64];
+
+        for(std::uint64_t rays=active; rays != 0; rays &= rays - 1) {
+            const unsigned k ( __builtin_ctzll(rays) );
+            double t0 { p.tmin[k] };
+            double t1 { p.tmax[k] };
+
+            if(! slab(p.rays[k]->origin, p.inv[k], lo, edge, t0, t1)) {
+                continue;
+            }
+
+            dda cells { *p.rays[k], p.inv[k], corner, shift, t0 };
+
+            do {
+                const unsigned pos { cells.position() };
+
+                if(! ((set >> pos) & 1)) {
+                    continue;
+                }
+
+                if(! ((crossed >> pos) & 1)) {
+                    crossed |= std::uint64_t { 1 } << pos;
+                    rays_at[pos] = 0;
+                }
+
+                rays_at[pos] |= std::uint64_t { 1 } << k;
+
+                //only needed for hits, a ray hits at most one value per node
+                if(shift == 0 || ((leaves >> pos) & 1)) {
+                    enter[k] = cells.enter();
+                    break;
+                }
+            } while(cells.next(t1));
+        }
+
+        for(unsigned i=0; i<64 && crossed != 0; ++i) {
+            const unsigned pos { i ^ p.flip };
+
+            if(! ((crossed >> pos) & 1)) {
+                continue;
+            }
+
+            crossed &= ~(std::uint64_t { 1 } << pos);
+
+            const std::uint64_t hit { rays_at[pos] & p.pending };
+
+            if(hit == 0) {
+                continue;
+            }
+
+            std::uint64_t cell[3];
+            position_cell<3>(pos, corner, shift, cell);
+
+            if(shift == 0 || ((leaves >> pos) & 1)) {
+                for(std::uint64_t rays=hit; rays != 0; rays &= rays - 1) {
+                    const unsigned k ( __builtin_ctzll(rays) );
+
+                    *p.hits[k]  = neighbor<box_hit<T>> { box_hit<T> { cell[0], cell[1], cell[2], size, node.get_value(pos) }, enter[k] };
+                    *p.found[k] = true;
+                }
+
+                p.pending &= ~hit;
+            } else {
+                packet_walk(*node.child(pos), cell, shift - 2, p, hit);
+            }
+        }
+    }
+};
+
+/*
+ * first hits of amnt rays, like raycast_first for each of them
+ *
+ * rays are grouped by the signs of their directions into packets of up
+ * to 64 that descend the tree together, which pays off for coherent
+ * rays such as the primary rays of a camera
+ */
+template <typename Node, typename T>
+void raycast_packet(const Node & root, const ray * rays, const std::size_t amnt, const unsigned depth, neighbor<box_hit<T>> * hits, bool * found, const double tmin = 0, const double tmax = std::numeric_limits<double>::infinity())
+{
+    assert(depth > 0);
+    assert(depth <= detail::max_ray_depth);
+
+    const std::uint64_t corner[3] { 0, 0, 0 };
+    const double        lo[3]     { 0, 0, 0 };
+    const double        side      ( static_cast<double>(std::uint64_t { 1 } << (2 * depth)) );
+
+    std::vector<std::size_t> octants[8];
+
+    for(std::size_t i=0; i<amnt; ++i) {
+        const unsigned octant { (rays[i].direction[0] < 0 ? 4u : 0u) | (rays[i].direction[1] < 0 ? 2u : 0u) | (rays[i].direction[2] < 0 ? 1u : 0u) };
+
+        found[i] = false;
+        octants[octant].push_back(i);
+    }
+
+    detail::ray_packet<T> p;
+
+    for(unsigned octant=0; octant<8; ++octant) {
+        p.flip = ((octant & 4) ? 0x24u : 0u) | ((octant & 2) ? 0x12u : 0u) | ((octant & 1) ? 0x09u : 0u);
+
+        for(std::size_t base=0; base<octants[octant].size(); base += 64) {
+            const std::size_t size { octants[octant].size() - base < 64 ? octants[octant].size() - base : 64 };
+
+            p.pending = 0;
+
+            for(std::size_t k=0; k<size; ++k) {
+                const std::size_t i { octants[octant][base + k] };
+
+                p.rays[k]  = &rays[i];
+                p.hits[k]  = &hits[i];
+                p.found[k] = &found[i];
+                p.tmin[k]  = tmin;
+                p.tmax[k]  = tmax;
+                detail::inverse(rays[i], p.inv[k]);
+
+                if(detail::slab(rays[i].origin, p.inv[k], lo, side, p.tmin[k], p.tmax[k])) {
+                    p.pending |= std::uint64_t { 1 } << k;
+                }
+            }
+
+            detail::packet_walk(root, corner, 2 * (depth - 1), p, p.pending);
+        }
+    }
+}
+
+};
+
+#endif
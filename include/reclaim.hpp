@@ -0,0 +1,305 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_RECLAIM_H
+#define HCKT_RECLAIM_H
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "allocator.hpp"
+
+namespace hckt
+{
+
+/*
+ * deferred freeing of subtrees
+ *
+ * remove() and collapse() free a subtree before they return, for a deep
+ * one that is millions of nodes in the middle of a request
+ * a reclaimer takes detached subtrees instead and frees them later,
+ * a bounded amount at a time or on a thread of its own
+ *
+ * works on tree, whose nodes can be detached from their parents
+ */
+namespace detail
+{
+    /*
+     * free the node on top of pending, its children take its place
+     */
+    template <typename Tree>
+    void free_one(std::vector<Tree*> & pending)
+    {
+        Tree * const node { pending.back() };
+        pending.pop_back();
+
+        for(unsigned i=0, c_amnt=node->children_amnt(); i<c_amnt; ++i) {
+            pending.push_back(node->child_at(i));
+        }
+
+        node->clear_node();
+        Tree::delete_node(node);
+    }
+};
+
+/*
+ * frees retired subtrees when drained, from the thread that drains it
+ * single threaded like the tree it belongs to
+ */
+template <typename Tree>
+class deferred_reclaimer
+{
+    std::vector<Tree*> pending; //nodes left to free, their subtrees with them
+
+public:
+    deferred_reclaimer() : pending { }
+    {
+    }
+
+    deferred_reclaimer(const deferred_reclaimer &) = delete;
+    deferred_reclaimer & operator=(const deferred_reclaimer &) = delete;
+
+    ~deferred_reclaimer()
+    {
+        drain_all();
+    }
+
+    /*
+     * take a subtree from tree::detach() to free later
+     */
+    void retire(Tree * subtree)
+    {
+        pending.push_back(subtree);
+    }
+
+    /*
+     * node.remove(position), with the subtree below it left to drain
+     */
+    void remove(Tree & node, const unsigned position)
+    {
+        if(node.is_leaf(position)) {
+            node.remove(position);
+        } else {
+            retire(node.detach(position));
+        }
+    }
+
+    /*
+     * node.collapse(), every subtree of node left to drain
+     * a root emptied this way is destroyed in O(1)
+     */
+    void retire_children(Tree & node)
+    {
+        for(std::uint64_t dist=node.chidist(); dist != 0; dist &= dist - 1) {
+            retire(node.detach(__builtin_ctzll(dist)));
+        }
+    }
+
+    /*
+     * free up to budget nodes, returns how many were freed
+     */
+    std::size_t drain(const std::size_t budget)
+    {
+        std::size_t freed { 0 };
+
+        for(; freed < budget && ! pending.empty(); ++freed) {
+            detail::free_one(pending);
+        }
+
+        return freed;
+    }
+
+    /*
+     * free nodes until budget has passed, the clock is read every
+     * check nodes
+     */
+    template <typename Rep, typename Period>
+    std::size_t drain_for(const std::chrono::duration<Rep, Period> budget, const std::size_t check = 64)
+    {
+        const auto  until { std::chrono::steady_clock::now() + budget };
+        std::size_t freed { 0 };
+
+        while(! pending.empty()) {
+            freed += drain(check);
+
+            if(std::chrono::steady_clock::now() >= until) {
+                break;
+            }
+        }
+
+        return freed;
+    }
+
+    std::size_t drain_all()
+    {
+        std::size_t freed { 0 };
+
+        for(; ! pending.empty(); ++freed) {
+            detail::free_one(pending);
+        }
+
+        return freed;
+    }
+
+    /*
+     * nothing left to free
+     */
+    bool empty() const
+    {
+        return pending.empty();
+    }
+};
+
+/*
+ * frees retired subtrees on a thread of its own
+ * the tree's allocator is then used from two threads, so it has to be
+ * thread safe, see locked_allocator
+ */
+template <typename Tree>
+class background_reclaimer
+{
+    static_assert(is_thread_safe_allocator<typename detail::node_allocator<Tree>::type>::value, "background_reclaimer frees from its own thread, use heap_allocator or locked_allocator");
+
+    std::mutex               lock;
+    std::condition_variable  wake;
+    std::condition_variable  idle_cv;
+    std::vector<Tree*>       queue;
+    bool                     busy;
+    bool                     stop;
+    std::atomic<std::size_t> freed_amnt;
+    std::thread              worker;
+
+    void run()
+    {
+        std::vector<Tree*> pending;
+        std::unique_lock<std::mutex> guard { lock };
+
+        while(true) {
+            wake.wait(guard, [this] { return stop || ! queue.empty(); });
+
+            if(queue.empty()) {
+                return;
+            }
+
+            pending.swap(queue);
+            busy = true;
+            guard.unlock();
+
+            std::size_t freed { 0 };
+
+            for(; ! pending.empty(); ++freed) {
+                detail::free_one(pending);
+            }
+
+            freed_amnt.fetch_add(freed, std::memory_order_relaxed);
+
+            guard.lock();
+            busy = false;
+            idle_cv.notify_all();
+        }
+    }
+
+public:
+    background_reclaimer() : lock       { }
+                           , wake       { }
+                           , idle_cv    { }
+                           , queue      { }
+                           , busy       { false }
+                           , stop       { false }
+                           , freed_amnt { 0 }
+                           , worker     { }
+    {
+        worker = std::thread([this] { run(); });
+    }
+
+    background_reclaimer(const background_reclaimer &) = delete;
+    background_reclaimer & operator=(const background_reclaimer &) = delete;
+
+    /*
+     * frees whatever is still queued before returning
+     */
+    ~background_reclaimer()
+    {
+        {
+            std::lock_guard<std::mutex> guard { lock };
+            stop = true;
+        }
+
+        wake.notify_one();
+        worker.join();
+    }
+
+    void retire(Tree * subtree)
+    {
+        {
+            std::lock_guard<std::mutex> guard { lock };
+            queue.push_back(subtree);
+        }
+
+        wake.notify_one();
+    }
+
+    void remove(Tree & node, const unsigned position)
+    {
+        if(node.is_leaf(position)) {
+            node.remove(position);
+        } else {
+            retire(node.detach(position));
+        }
+    }
+
+    void retire_children(Tree & node)
+    {
+        for(std::uint64_t dist=node.chidist(); dist != 0; dist &= dist - 1) {
+            retire(node.detach(__builtin_ctzll(dist)));
+        }
+    }
+
+    /*
+     * block until everything retired so far is freed
+     */
+    void wait_idle()
+    {
+        std::unique_lock<std::mutex> guard { lock };
+        idle_cv.wait(guard, [this] { return queue.empty() && ! busy; });
+    }
+
+    /*
+     * nodes freed so far
+     */
+    std::size_t freed() const
+    {
+        return freed_amnt.load(std::memory_order_relaxed);
+    }
+};
+
+};
+
+#endif
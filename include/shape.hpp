@@ -0,0 +1,278 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_SHAPE_H
+#define HCKT_SHAPE_H
+
+#include <cassert>
+#include <cstdint>
+#include "util.hpp"
+
+namespace hckt
+{
+
+/*
+ * occupancy mask of a node with Words * 64 positions
+ */
+template <unsigned Words>
+struct bitmask
+{
+    std::uint64_t words[Words];
+
+    bitmask() : words { }
+    {
+    }
+
+    bool test(const unsigned position) const
+    {
+        assert(position < Words * 64);
+        return (words[position / 64] >> (position % 64)) & 1;
+    }
+
+    void set(const unsigned position)
+    {
+        assert(position < Words * 64);
+        words[position / 64] |= std::uint64_t { 1 } << (position % 64);
+    }
+
+    void reset(const unsigned position)
+    {
+        assert(position < Words * 64);
+        words[position / 64] &= ~(std::uint64_t { 1 } << (position % 64));
+    }
+
+    bool any() const
+    {
+        std::uint64_t all { 0 };
+
+        for(unsigned i=0; i<Words; ++i) {
+            all |= words[i];
+        }
+
+        return all != 0;
+    }
+
+    unsigned count() const
+    {
+        unsigned amount { 0 };
+
+        for(unsigned i=0; i<Words; ++i) {
+            amount += hckt::popcount(words[i]);
+        }
+
+        return amount;
+    }
+
+    /*
+     * number of set bits below position
+     * popcount of every word masked by the prefix ending at position, so
+     * there is no branch on which word position falls in
+     */
+    unsigned rank(const unsigned position) const
+    {
+        assert(position < Words * 64);
+
+        const unsigned      word { position / 64 };
+        const std::uint64_t low  { (std::uint64_t { 1 } << (position % 64)) - 1 };
+        unsigned            r    { 0 };
+
+        for(unsigned i=0; i<Words; ++i) {
+            const std::uint64_t m { i < word ? ~std::uint64_t { 0 } : (i == word ? low : 0) };
+            r += hckt::popcount(words[i] & m);
+        }
+
+        return r;
+    }
+
+    /*
+     * bits of this mask not set in other
+     */
+    bitmask without(const bitmask & other) const
+    {
+        bitmask r;
+
+        for(unsigned i=0; i<Words; ++i) {
+            r.words[i] = words[i] & ~other.words[i];
+        }
+
+        return r;
+    }
+};
+
+/*
+ * compile time node geometry
+ *
+ * a level resolves AxisBits bits of each of the Dim coordinates, so a
+ * node has 2^(Dim * AxisBits) positions: shape<2, 3> and shape<3, 2> are
+ * the 64 position nodes of hckt::tree, shape<3, 3> has 512 positions and
+ * needs a third fewer levels for the same resolution, shape<3, 1> is an
+ * octree with 8 byte masks
+ *
+ * positions interleave the node local coordinates like morton.hpp, bit k
+ * of axis a lands on bit k * Dim + (Dim - 1 - a), x highest
+ */
+template <unsigned Dim, unsigned AxisBits>
+struct shape
+{
+    static_assert(Dim == 2 || Dim == 3, "nodes map either 2d or 3d coordinates");
+    static_assert(AxisBits > 0 && Dim * AxisBits <= 9, "nodes have between 4 and 512 positions");
+
+    static constexpr unsigned dim        { Dim };
+    static constexpr unsigned axis_bits  { AxisBits };
+    static constexpr unsigned level_bits { Dim * AxisBits };
+    static constexpr unsigned fanout     { 1u << level_bits };
+    static constexpr unsigned words      { (fanout + 63) / 64 };
+    static constexpr unsigned axis_mask  { (1u << AxisBits) - 1 };
+
+    //deepest tree addressable with 64 bit coordinates
+    static constexpr unsigned max_depth  { 64 / AxisBits };
+
+    typedef hckt::bitmask<words> mask_type;
+
+    /*
+     * bits k.. of local coordinate c of axis a, placed into a position
+     */
+    static constexpr unsigned spread(const unsigned c, const unsigned a, const unsigned k = 0)
+    {
+        return k == AxisBits
+            ? 0
+            : (((c >> k) & 1u) << (k * Dim + (Dim - 1 - a))) | spread(c, a, k + 1);
+    }
+
+    /*
+     * local coordinate of axis a out of bits k.. of a position
+     */
+    static constexpr unsigned gather(const unsigned position, const unsigned a, const unsigned k = 0)
+    {
+        return k == AxisBits
+            ? 0
+            : (((position >> (k * Dim + (Dim - 1 - a))) & 1u) << k) | gather(position, a, k + 1);
+    }
+
+    static constexpr unsigned position(const unsigned x, const unsigned y)
+    {
+        return assert(Dim == 2), assert(x <= axis_mask), assert(y <= axis_mask),
+               spread(x, 0) | spread(y, 1);
+    }
+
+    static constexpr unsigned position(const unsigned x, const unsigned y, const unsigned z)
+    {
+        return assert(Dim == 3), assert(x <= axis_mask), assert(y <= axis_mask), assert(z <= axis_mask),
+               spread(x, 0) | spread(y, 1) | spread(z, 2);
+    }
+
+    static constexpr unsigned get_x(const unsigned position)
+    {
+        return gather(position, 0);
+    }
+
+    static constexpr unsigned get_y(const unsigned position)
+    {
+        return gather(position, 1);
+    }
+
+    static constexpr unsigned get_z(const unsigned position)
+    {
+        return assert(Dim == 3), gather(position, 2);
+    }
+
+    /*
+     * local coordinate of a full coordinate at a level, root is level 0
+     * of a tree depth levels deep
+     */
+    static constexpr unsigned local(const std::uint64_t c, const unsigned depth, const unsigned level)
+    {
+        return static_cast<unsigned>((c >> (AxisBits * (depth - 1 - level))) & axis_mask);
+    }
+
+    /*
+     * yields the position of every level of a coordinate, root first
+     */
+    class path
+    {
+        std::uint64_t coords[Dim];
+        unsigned      depth;
+        unsigned      level;
+
+    public:
+        path(const std::uint64_t x, const std::uint64_t y, const unsigned depth)
+            : coords { x, y }, depth { depth }, level { 0 }
+        {
+            static_assert(Dim == 2, "2d path takes x and y");
+            assert(depth > 0 && depth <= max_depth);
+        }
+
+        path(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth)
+            : coords { x, y, z }, depth { depth }, level { 0 }
+        {
+            static_assert(Dim == 3, "3d path takes x, y and z");
+            assert(depth > 0 && depth <= max_depth);
+        }
+
+        bool done() const
+        {
+            return level == depth;
+        }
+
+        /*
+         * true if the next position is the last one
+         */
+        bool last() const
+        {
+            return level + 1 == depth;
+        }
+
+        unsigned next()
+        {
+            assert(! done());
+
+            const unsigned l { level++ };
+
+            return Dim == 2
+                ? spread(local(coords[0], depth, l), 0) | spread(local(coords[1], depth, l), 1)
+                : spread(local(coords[0], depth, l), 0) | spread(local(coords[1], depth, l), 1) | spread(local(coords[Dim - 1], depth, l), 2);
+        }
+    };
+};
+
+template <unsigned Dim, unsigned AxisBits> constexpr unsigned shape<Dim, AxisBits>::dim;
+template <unsigned Dim, unsigned AxisBits> constexpr unsigned shape<Dim, AxisBits>::axis_bits;
+template <unsigned Dim, unsigned AxisBits> constexpr unsigned shape<Dim, AxisBits>::level_bits;
+template <unsigned Dim, unsigned AxisBits> constexpr unsigned shape<Dim, AxisBits>::fanout;
+template <unsigned Dim, unsigned AxisBits> constexpr unsigned shape<Dim, AxisBits>::words;
+template <unsigned Dim, unsigned AxisBits> constexpr unsigned shape<Dim, AxisBits>::axis_mask;
+template <unsigned Dim, unsigned AxisBits> constexpr unsigned shape<Dim, AxisBits>::max_depth;
+
+typedef shape<2, 3> shape_2d;     //64 positions, same layout as util.hpp and morton.hpp
+typedef shape<3, 2> shape_3d;     //64 positions
+typedef shape<2, 4> shape_2d_256; //256 positions
+typedef shape<3, 3> shape_3d_512; //512 positions
+
+//the layout of the default shapes is the one of get_position_2d/get_position_3d
+static_assert(shape_2d::position(get_x_2d(1, 2, 3), get_y_2d(1, 2, 3)) == get_position_2d(1, 2, 3), "2d shape matches util.hpp");
+static_assert(shape_3d::position(get_x_3d(5, 3), get_y_3d(5, 3), get_z_3d(5, 3)) == get_position_3d(5, 3), "3d shape matches util.hpp");
+
+};
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_SHAPED_TREE_H
+#define HCKT_SHAPED_TREE_H
+
+#include <cstdint>
+#include <iostream>
+#include "basic_tree.hpp"
+#include "shape.hpp"
+
+namespace hckt
+{
+
+/*
+ * hckt::tree with the node geometry fixed at compile time by Shape, see
+ * shape.hpp, so depth can be traded against node width per workload:
+ * wide nodes for dense data need fewer levels and cache misses, narrow
+ * ones waste less on sparse data
+ *
+ * both share the node code of basic_tree.hpp, positions go up to
+ * Shape::fanout and masks are Shape::mask_type instead of 64 bit words,
+ * so the helpers built on 64 bit masks (traversal.hpp and on) only take
+ * hckt::tree, block_tree and the like
+ */
+template <typename T, typename Shape = hckt::shape_2d, typename Alloc = hckt::pool_allocator, typename Growth = hckt::exact_growth>
+class shaped_tree : public hckt::basic_tree<shaped_tree<T, Shape, Alloc, Growth>, T, Shape, Alloc, Growth>
+{
+typedef T value_type;
+typedef Alloc allocator_type;
+typedef hckt::basic_tree<shaped_tree<T, Shape, Alloc, Growth>, T, Shape, Alloc, Growth> base;
+typedef typename base::mask_type mask_type;
+
+using base::chiset;
+using base::leaf;
+
+public:
+    using base::fanout;
+    using base::insert;
+
+    shaped_tree()
+    {
+    }
+
+    mask_type chidist() const
+    {
+        return this->child_bits();
+    }
+
+    const mask_type & set_mask() const
+    {
+        return chiset;
+    }
+
+    const mask_type & leaf_mask() const
+    {
+        return leaf;
+    }
+
+
+    /*
+     * coordinate level access, as in hckt::tree
+     * depth is the number of levels below this node, each resolving
+     * Shape::axis_bits bits of every coordinate
+     */
+
+    const value_type * find(const std::uint64_t x, const std::uint64_t y, const unsigned depth) const
+    {
+        typename Shape::path p { x, y, depth };
+        return this->find_path(p);
+    }
+
+    const value_type * find(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth) const
+    {
+        typename Shape::path p { x, y, z, depth };
+        return this->find_path(p);
+    }
+
+    void insert(const std::uint64_t x, const std::uint64_t y, const value_type value, const unsigned depth)
+    {
+        typename Shape::path p { x, y, depth };
+        this->insert_path(p, value);
+    }
+
+    void insert(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const value_type value, const unsigned depth)
+    {
+        typename Shape::path p { x, y, z, depth };
+        this->insert_path(p, value);
+    }
+
+
+    /************************************************
+     *
+     * BENCHMARKING CODE
+     *
+     ***********************************************/
+
+    void mem_usage_info() const
+    {
+        std::cout << "fanout:    " << fanout << std::endl;
+        base::mem_usage_info();
+    }
+
+};
+
+};
+
+#endif
@@ -0,0 +1,253 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_SIMD_H
+#define HCKT_SIMD_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "util.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HCKT_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace hckt
+{
+
+/*
+ * kernels working on many positions of one node at once
+ *
+ * every kernel has a scalar and an AVX2 version, the AVX2 one is
+ * compiled with a target attribute and picked at runtime, so binaries
+ * built without -mavx2 still use it where available
+ *
+ * positions are node positions (< 64) as produced by get_position_*
+ */
+namespace simd
+{
+    namespace scalar
+    {
+        inline void rank(const std::uint64_t mask, const std::uint32_t * positions, const std::size_t amnt, std::uint32_t * out)
+        {
+            for(std::size_t i=0; i<amnt; ++i) {
+                out[i] = hckt::rank(mask, positions[i]);
+            }
+        }
+
+        inline void test(const std::uint64_t mask, const std::uint32_t * positions, const std::size_t amnt, std::uint8_t * out)
+        {
+            for(std::size_t i=0; i<amnt; ++i) {
+                out[i] = (mask >> positions[i]) & 1;
+            }
+        }
+
+        template <typename T>
+        void gather(const T * values, const std::uint64_t mask, const std::uint32_t * positions, const std::size_t amnt, T * out)
+        {
+            for(std::size_t i=0; i<amnt; ++i) {
+                out[i] = values[hckt::rank(mask, positions[i])];
+            }
+        }
+    };
+
+#ifdef HCKT_SIMD_X86
+    namespace avx2
+    {
+        /*
+         * popcount of each 64 bit lane through a nibble lookup table
+         */
+        __attribute__((target("avx2")))
+        inline __m256i popcount_epi64(const __m256i v)
+        {
+            const __m256i lookup {
+                _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4)
+            };
+            const __m256i low_mask { _mm256_set1_epi8(0x0F) };
+
+            const __m256i lo  { _mm256_and_si256(v, low_mask) };
+            const __m256i hi  { _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask) };
+            const __m256i cnt { _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi)) };
+
+            return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+        }
+
+        /*
+         * ranks of 4 positions as 32 bit lanes
+         */
+        __attribute__((target("avx2")))
+        inline __m128i rank4(const __m256i mask, const std::uint32_t * positions)
+        {
+            const __m256i one   { _mm256_set1_epi64x(1) };
+            const __m256i pos   { _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(positions))) };
+            const __m256i below { _mm256_sub_epi64(_mm256_sllv_epi64(one, pos), one) };
+            const __m256i cnt   { popcount_epi64(_mm256_and_si256(mask, below)) };
+
+            return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(cnt, _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0)));
+        }
+
+        __attribute__((target("avx2")))
+        inline void rank(const std::uint64_t mask, const std::uint32_t * positions, const std::size_t amnt, std::uint32_t * out)
+        {
+            const __m256i m { _mm256_set1_epi64x(mask) };
+            std::size_t i { 0 };
+
+            for(; i + 8 <= amnt; i += 8) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),     rank4(m, positions + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), rank4(m, positions + i + 4));
+            }
+
+            for(; i + 4 <= amnt; i += 4) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), rank4(m, positions + i));
+            }
+
+            scalar::rank(mask, positions + i, amnt - i, out + i);
+        }
+
+        __attribute__((target("avx2")))
+        inline void test(const std::uint64_t mask, const std::uint32_t * positions, const std::size_t amnt, std::uint8_t * out)
+        {
+            const __m256i m { _mm256_set1_epi64x(mask) };
+            std::size_t i { 0 };
+
+            for(; i + 4 <= amnt; i += 4) {
+                const __m256i pos  { _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(positions + i))) };
+                const __m256i bits { _mm256_slli_epi64(_mm256_srlv_epi64(m, pos), 63) };
+                const int     set  { _mm256_movemask_pd(_mm256_castsi256_pd(bits)) };
+
+                out[i]     = (set >> 0) & 1;
+                out[i + 1] = (set >> 1) & 1;
+                out[i + 2] = (set >> 2) & 1;
+                out[i + 3] = (set >> 3) & 1;
+            }
+
+            scalar::test(mask, positions + i, amnt - i, out + i);
+        }
+
+        __attribute__((target("avx2")))
+        inline void gather32(const void * values, const std::uint64_t mask, const std::uint32_t * positions, const std::size_t amnt, void * out)
+        {
+            const __m256i m { _mm256_set1_epi64x(mask) };
+            const int *   v { static_cast<const int*>(values) };
+            char *        o { static_cast<char*>(out) };
+            std::size_t   i { 0 };
+
+            for(; i + 4 <= amnt; i += 4) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(o + 4 * i), _mm_i32gather_epi32(v, rank4(m, positions + i), 4));
+            }
+
+            scalar::gather(reinterpret_cast<const std::uint32_t*>(values), mask, positions + i, amnt - i, reinterpret_cast<std::uint32_t*>(o + 4 * i));
+        }
+
+        __attribute__((target("avx2")))
+        inline void gather64(const void * values, const std::uint64_t mask, const std::uint32_t * positions, const std::size_t amnt, void * out)
+        {
+            const __m256i     m { _mm256_set1_epi64x(mask) };
+            const long long * v { static_cast<const long long*>(values) };
+            char *            o { static_cast<char*>(out) };
+            std::size_t       i { 0 };
+
+            for(; i + 4 <= amnt; i += 4) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(o + 8 * i), _mm256_i32gather_epi64(v, rank4(m, positions + i), 8));
+            }
+
+            scalar::gather(reinterpret_cast<const std::uint64_t*>(values), mask, positions + i, amnt - i, reinterpret_cast<std::uint64_t*>(o + 8 * i));
+        }
+    };
+#endif
+
+    /*
+     * checked once, the kernels below branch on the cached result
+     */
+    inline bool has_avx2()
+    {
+#ifdef HCKT_SIMD_X86
+        static const bool supported { __builtin_cpu_supports("avx2") != 0 };
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    /*
+     * out[i] = number of bits of mask below positions[i]
+     * with mask = chidist() these are get_children_position,
+     * with mask = chiset get_value_position
+     */
+    inline void rank(const std::uint64_t mask, const std::uint32_t * positions, const std::size_t amnt, std::uint32_t * out)
+    {
+#ifdef HCKT_SIMD_X86
+        if(has_avx2()) {
+            avx2::rank(mask, positions, amnt, out);
+            return;
+        }
+#endif
+        scalar::rank(mask, positions, amnt, out);
+    }
+
+    /*
+     * out[i] = bit positions[i] of mask
+     * with mask = chiset this is is_set, with ~inv_leaf is_leaf
+     */
+    inline void test(const std::uint64_t mask, const std::uint32_t * positions, const std::size_t amnt, std::uint8_t * out)
+    {
+#ifdef HCKT_SIMD_X86
+        if(has_avx2()) {
+            avx2::test(mask, positions, amnt, out);
+            return;
+        }
+#endif
+        scalar::test(mask, positions, amnt, out);
+    }
+
+    /*
+     * out[i] = values[rank(mask, positions[i])]
+     * every position has to be set in mask
+     * 4 and 8 byte values use hardware gathers
+     */
+    template <typename T>
+    void gather(const T * values, const std::uint64_t mask, const std::uint32_t * positions, const std::size_t amnt, T * out)
+    {
+#ifdef HCKT_SIMD_X86
+        if(has_avx2() && sizeof(T) == 4) {
+            avx2::gather32(values, mask, positions, amnt, out);
+            return;
+        }
+
+        if(has_avx2() && sizeof(T) == 8) {
+            avx2::gather64(values, mask, positions, amnt, out);
+            return;
+        }
+#endif
+        scalar::gather(values, mask, positions, amnt, out);
+    }
+};
+
+};
+
+#endif
@@ -0,0 +1,526 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_TRAVERSAL_H
+#define HCKT_TRAVERSAL_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <vector>
+#include "morton.hpp"
+
+namespace hckt
+{
+
+/*
+ * iterators over the nodes or set positions of a tree, without recursion
+ *
+ * the path from the root is kept on an explicit stack and set bits are
+ * enumerated with tzcnt, so empty positions are never looked at and
+ * depth is only limited by memory
+ *
+ * they work on tree, block_tree and frozen_node, Node may be const;
+ * modifying a node below the current one invalidates the iterator, the
+ * exception being postorder, where the node just yielded may be destroyed
+ */
+
+/*
+ * stack of a traversal, room for Reserve frames is made up front so
+ * usual depths never reallocate while walking
+ */
+template <typename Frame, std::size_t Reserve = 32>
+class traversal_stack
+{
+    std::vector<Frame> frames;
+
+public:
+    traversal_stack() : frames { }
+    {
+    }
+
+    bool empty() const
+    {
+        return frames.empty();
+    }
+
+    std::size_t size() const
+    {
+        return frames.size();
+    }
+
+    Frame & operator[](const std::size_t i)
+    {
+        assert(i < frames.size());
+        return frames[i];
+    }
+
+    const Frame & operator[](const std::size_t i) const
+    {
+        assert(i < frames.size());
+        return frames[i];
+    }
+
+    Frame & top()
+    {
+        return frames.back();
+    }
+
+    const Frame & top() const
+    {
+        return frames.back();
+    }
+
+    void push(const Frame & f)
+    {
+        if(frames.capacity() == 0) {
+            frames.reserve(Reserve);
+        }
+
+        frames.push_back(f);
+    }
+
+    void pop()
+    {
+        assert(! frames.empty());
+        frames.pop_back();
+    }
+};
+
+template <typename Node>
+struct node_frame
+{
+    Node *        node;
+    std::uint64_t pending;  //positions still to visit, children or values depending on the iterator
+    unsigned      position; //position of node in its parent, or the current position for morton order
+    unsigned      next;     //index of the next child, children are stored in position order
+};
+
+/*
+ * a set position as yielded by morton order
+ */
+template <typename Node>
+struct position_ref
+{
+    Node *   node;
+    unsigned position;
+    unsigned level;
+
+    bool is_leaf() const
+    {
+        return node->is_leaf(position);
+    }
+
+    auto value() const -> decltype(node->get_value(0))
+    {
+        return node->get_value(position);
+    }
+};
+
+/*
+ * nodes depth first, parents before their children
+ * skip_children() leaves out the subtree below the current node
+ */
+template <typename Node>
+class preorder_iterator
+{
+    //ancestors of current that still have children to visit
+    traversal_stack<node_frame<Node>> stack;
+    node_frame<Node>                  current;
+
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Node                      value_type;
+    typedef std::ptrdiff_t            difference_type;
+    typedef Node *                    pointer;
+    typedef Node &                    reference;
+
+    //end
+    preorder_iterator() : stack { }, current { nullptr, 0, 0, 0 }
+    {
+    }
+
+    explicit preorder_iterator(Node & root) : stack { }, current { &root, root.chidist(), 0, 0 }
+    {
+    }
+
+    Node & operator*() const  { return *current.node; }
+    Node * operator->() const { return current.node; }
+
+    //0 for the root
+    unsigned level() const    { return stack.size(); }
+
+    //position of the current node in its parent
+    unsigned position() const { return current.position; }
+
+    void skip_children()
+    {
+        current.pending = 0;
+    }
+
+    preorder_iterator & operator++()
+    {
+        //nodes without children never go on the stack
+        if(current.pending != 0) {
+            stack.push(current);
+        }
+
+        while(! stack.empty()) {
+            node_frame<Node> & f = stack.top();
+
+            if(f.pending != 0) {
+                const unsigned pos ( __builtin_ctzll(f.pending) );
+                Node * c { f.node->child_at(f.next++) };
+
+                f.pending &= f.pending - 1;
+                current = node_frame<Node> { c, c->chidist(), pos, 0 };
+                return *this;
+            }
+
+            stack.pop();
+        }
+
+        current = node_frame<Node> { nullptr, 0, 0, 0 };
+        return *this;
+    }
+
+    preorder_iterator operator++(int)
+    {
+        preorder_iterator old { *this };
+        ++*this;
+        return old;
+    }
+
+    bool operator==(const preorder_iterator & other) const
+    {
+        return current.node == other.current.node && stack.size() == other.stack.size();
+    }
+
+    bool operator!=(const preorder_iterator & other) const
+    {
+        return ! (*this == other);
+    }
+};
+
+/*
+ * nodes depth first, children before their parents
+ * the node yielded last may be destroyed before incrementing, which is
+ * how subtrees are freed without recursion
+ */
+template <typename Node>
+class postorder_iterator
+{
+    //ancestors of current, current itself is never on the stack
+    traversal_stack<node_frame<Node>> stack;
+    node_frame<Node>                  current;
+
+    //yield the first node below the top frame without unvisited children
+    void descend()
+    {
+        for(;;) {
+            node_frame<Node> & f = stack.top();
+
+            if(f.pending == 0) {
+                current = f;
+                stack.pop();
+                return;
+            }
+
+            const unsigned pos ( __builtin_ctzll(f.pending) );
+            Node * c { f.node->child_at(f.next++) };
+            const std::uint64_t c_dist { c->chidist() };
+
+            f.pending &= f.pending - 1;
+
+            if(c_dist == 0) {
+                current = node_frame<Node> { c, 0, pos, 0 };
+                return;
+            }
+
+            stack.push(node_frame<Node> { c, c_dist, pos, 0 });
+        }
+    }
+
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Node                      value_type;
+    typedef std::ptrdiff_t            difference_type;
+    typedef Node *                    pointer;
+    typedef Node &                    reference;
+
+    postorder_iterator() : stack { }, current { nullptr, 0, 0, 0 }
+    {
+    }
+
+    explicit postorder_iterator(Node & root) : stack { }, current { nullptr, 0, 0, 0 }
+    {
+        stack.push(node_frame<Node> { &root, root.chidist(), 0, 0 });
+        descend();
+    }
+
+    Node & operator*() const  { return *current.node; }
+    Node * operator->() const { return current.node; }
+    unsigned level() const    { return stack.size(); }
+    unsigned position() const { return current.position; }
+
+    postorder_iterator & operator++()
+    {
+        if(stack.empty()) {
+            current = node_frame<Node> { nullptr, 0, 0, 0 };
+        } else {
+            descend();
+        }
+
+        return *this;
+    }
+
+    postorder_iterator operator++(int)
+    {
+        postorder_iterator old { *this };
+        ++*this;
+        return old;
+    }
+
+    bool operator==(const postorder_iterator & other) const
+    {
+        return current.node == other.current.node && stack.size() == other.stack.size();
+    }
+
+    bool operator!=(const postorder_iterator & other) const
+    {
+        return ! (*this == other);
+    }
+};
+
+/*
+ * nodes level by level, keeps one level of the tree in a queue
+ */
+template <typename Node>
+class breadth_first_iterator
+{
+    struct entry
+    {
+        Node *   node;
+        unsigned level;
+        unsigned position;
+    };
+
+    std::deque<entry> queue;
+
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Node                      value_type;
+    typedef std::ptrdiff_t            difference_type;
+    typedef Node *                    pointer;
+    typedef Node &                    reference;
+
+    breadth_first_iterator() : queue { }
+    {
+    }
+
+    explicit breadth_first_iterator(Node & root) : queue { }
+    {
+        queue.push_back(entry { &root, 0, 0 });
+    }
+
+    Node & operator*() const  { return *queue.front().node; }
+    Node * operator->() const { return queue.front().node; }
+    unsigned level() const    { return queue.front().level; }
+    unsigned position() const { return queue.front().position; }
+
+    breadth_first_iterator & operator++()
+    {
+        const entry e ( queue.front() );
+
+        queue.pop_front();
+
+        unsigned cpos { 0 };
+
+        for(std::uint64_t pending=e.node->chidist(); pending != 0; pending &= pending - 1) {
+            const unsigned pos ( __builtin_ctzll(pending) );
+            queue.push_back(entry { e.node->child_at(cpos++), e.level + 1, pos });
+        }
+
+        return *this;
+    }
+
+    breadth_first_iterator operator++(int)
+    {
+        breadth_first_iterator old { *this };
+        ++*this;
+        return old;
+    }
+
+    bool operator==(const breadth_first_iterator & other) const
+    {
+        return queue.size() == other.queue.size() && (queue.empty() || queue.front().node == other.queue.front().node);
+    }
+
+    bool operator!=(const breadth_first_iterator & other) const
+    {
+        return ! (*this == other);
+    }
+};
+
+/*
+ * every set position in morton (key) order, an interior position comes
+ * right before the positions of its subtree
+ */
+template <typename Node>
+class morton_iterator
+{
+    traversal_stack<node_frame<Node>> stack;
+    position_ref<Node>                current;
+
+    //move the top frame to its next set position, dropping exhausted frames
+    void next()
+    {
+        while(! stack.empty()) {
+            node_frame<Node> & f = stack.top();
+
+            if(f.pending != 0) {
+                f.position = __builtin_ctzll(f.pending);
+                f.pending &= f.pending - 1;
+                current = position_ref<Node> { f.node, f.position, static_cast<unsigned>(stack.size() - 1) };
+                return;
+            }
+
+            stack.pop();
+        }
+    }
+
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef position_ref<Node>        value_type;
+    typedef std::ptrdiff_t            difference_type;
+    typedef const position_ref<Node> * pointer;
+    typedef const position_ref<Node> & reference;
+
+    morton_iterator() : stack { }, current { nullptr, 0, 0 }
+    {
+    }
+
+    explicit morton_iterator(Node & root) : stack { }, current { nullptr, 0, 0 }
+    {
+        stack.push(node_frame<Node> { &root, root.set_mask(), 0, 0 });
+        next();
+    }
+
+    const position_ref<Node> & operator*() const  { return current; }
+    const position_ref<Node> * operator->() const { return &current; }
+
+    /*
+     * path key of the current position, 6 bits per level with the root
+     * in the highest used bits, see bulk_load.hpp
+     */
+    std::uint64_t key() const
+    {
+        assert(stack.size() <= morton::key_levels);
+
+        std::uint64_t k { 0 };
+
+        for(std::size_t i=0; i<stack.size(); ++i) {
+            k = (k << 6) | stack[i].position;
+        }
+
+        return k;
+    }
+
+    morton_iterator & operator++()
+    {
+        if(! current.node->is_leaf(current.position)) {
+            Node * c { current.node->child(current.position) };
+            stack.push(node_frame<Node> { c, c->set_mask(), 0, 0 });
+        }
+
+        next();
+        return *this;
+    }
+
+    morton_iterator operator++(int)
+    {
+        morton_iterator old { *this };
+        ++*this;
+        return old;
+    }
+
+    bool operator==(const morton_iterator & other) const
+    {
+        return stack.size() == other.stack.size()
+            && (stack.empty() || (stack.top().node == other.stack.top().node && stack.top().position == other.stack.top().position));
+    }
+
+    bool operator!=(const morton_iterator & other) const
+    {
+        return ! (*this == other);
+    }
+};
+
+/*
+ * begin/end pair for range based for
+ */
+template <typename Iterator>
+class traversal_range
+{
+    Iterator first;
+
+public:
+    explicit traversal_range(const Iterator & first) : first { first }
+    {
+    }
+
+    Iterator begin() const { return first; }
+    Iterator end() const   { return Iterator { }; }
+};
+
+template <typename Node>
+traversal_range<preorder_iterator<Node>> preorder(Node & root)
+{
+    return traversal_range<preorder_iterator<Node>> { preorder_iterator<Node> { root } };
+}
+
+template <typename Node>
+traversal_range<postorder_iterator<Node>> postorder(Node & root)
+{
+    return traversal_range<postorder_iterator<Node>> { postorder_iterator<Node> { root } };
+}
+
+template <typename Node>
+traversal_range<breadth_first_iterator<Node>> breadth_first(Node & root)
+{
+    return traversal_range<breadth_first_iterator<Node>> { breadth_first_iterator<Node> { root } };
+}
+
+template <typename Node>
+traversal_range<morton_iterator<Node>> morton_order(Node & root)
+{
+    return traversal_range<morton_iterator<Node>> { morton_iterator<Node> { root } };
+}
+
+};
+
+#endif
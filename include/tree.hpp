@@ -22,289 +22,161 @@
  * THE SOFTWARE.
  */
 
+
 #ifndef HCKT_TREE_H
 #define HCKT_TREE_H
 
 #include <cassert>
-#include <iostream>
-#include <bitset>
-#include "lmemvector.hpp"
+#include <cstdint>
+#include "basic_tree.hpp"
+#include "frozen_tree.hpp"
+#include "morton.hpp"
+#include "shape.hpp"
+#include "simd.hpp"
+#include "traversal.hpp"
 #include "util.hpp"
 
 namespace hckt
 {
 
-template <typename T>
-class tree
+/*
+ * 64 position nodes, the node code is the one of basic_tree.hpp with
+ * shape_2d masks, 3d coordinates use the same nodes through morton.hpp
+ * on top of it this adds the single word mask accessors used by the
+ * simd, bulk loading and freezing code
+ *
+ * Alloc is the allocator policy used for nodes and their value/children
+ * buffers, see allocator.hpp
+ * Growth decides the capacity of those buffers, see lmemvector.hpp
+ */
+template <typename T, typename Alloc = hckt::pool_allocator, typename Growth = hckt::exact_growth>
+class tree : public hckt::basic_tree<tree<T, Alloc, Growth>, T, hckt::shape_2d, Alloc, Growth>
 {
 typedef T value_type;
+typedef Alloc allocator_type;
+typedef hckt::basic_tree<tree<T, Alloc, Growth>, T, hckt::shape_2d, Alloc, Growth> base;
 
-protected:
-    std::bitset<64>                     chiset;   //is child set to this position
-    std::bitset<64>                     inv_leaf; //opposite of leaf
-    hckt::lmemvector<value_type>        values;
-    hckt::lmemvector<tree<value_type>*> children;
+using base::chiset;
+using base::leaf;
+using base::values;
+using base::children;
 
 public:
+    using base::insert;
 
-    tree() : chiset   { 0x0000000000000000 }
-           , inv_leaf { 0xFFFFFFFFFFFFFFFF }
-           , values   { }
-           , children { }
+    tree()
     {
     }
 
-    ~tree()
-    {
-        collapse();
-    }
-
     //counts number of set bits
-    static inline unsigned popcount(std::uint64_t x)
+    static inline unsigned popcount(const std::uint64_t x)
     {
-#ifdef __SSE4_2__
-        return _mm_popcnt_u64(x);
-#else
-        constexpr std::uint64_t m1  { 0x5555555555555555 };
-        constexpr std::uint64_t m2  { 0x3333333333333333 };
-        constexpr std::uint64_t m4  { 0x0f0f0f0f0f0f0f0f };
-        constexpr std::uint64_t h01 { 0x0101010101010101 };
-
-        x -= (x >> 1) & m1;
-        x  = (x & m2) + ((x >> 2) & m2);
-        x  = (x + (x >> 4)) & m4;
-
-        return (x * h01) >> 56;
-#endif
+        return hckt::popcount(x);
     }
 
     std::uint64_t chidist() const
     {
-        return (chiset.to_ullong() & inv_leaf.to_ullong());
-    }
-
-    unsigned children_amnt() const
-    {
-        return popcount(chidist());
-    }
-
-    unsigned leaf_amnt() const
-    {
-        return popcount(~inv_leaf.to_ullong());
+        return chiset.words[0] & ~leaf.words[0];
     }
 
-    unsigned value_amount() const
+    std::uint64_t set_mask() const
     {
-        return popcount(chiset.to_ullong());
+        return chiset.words[0];
     }
 
-    unsigned get_children_position(const unsigned position) const
+    std::uint64_t leaf_mask() const
     {
-        assert(position < 64);
-
-        return position == 0 ? position : popcount(chidist() << (64 - position));
+        return leaf.words[0];
     }
 
     /*
-     * check if we have any children
+     * many positions of this node at once, see simd.hpp
      */
-    bool has_children() const
+    void get_children_positions(const std::uint32_t * positions, const std::size_t amnt, std::uint32_t * out) const
     {
-        return chiset.any();
+        hckt::simd::rank(chidist(), positions, amnt, out);
     }
 
-    bool is_set(const unsigned position) const
+    void are_set(const std::uint32_t * positions, const std::size_t amnt, std::uint8_t * out) const
     {
-        assert(position < 64);
-        return chiset[position];
+        hckt::simd::test(chiset.words[0], positions, amnt, out);
     }
 
-    bool is_leaf(const unsigned position) const
+    void are_leaves(const std::uint32_t * positions, const std::size_t amnt, std::uint8_t * out) const
     {
-        assert(position < 64);
-        return !inv_leaf[position];
+        hckt::simd::test(leaf.words[0], positions, amnt, out);
     }
 
     /*
-     * destroy children
+     * every position has to be set
      */
-    void collapse()
+    void get_values(const std::uint32_t * positions, const std::size_t amnt, value_type * out) const
     {
-        const unsigned c_amnt { children_amnt() };
-
-        for(unsigned i=0; i<c_amnt; ++i) {
-            children[i]->collapse();
-        }
-
-        children.clear(c_amnt);
-        values.clear(c_amnt);
-        chiset.reset();
+        hckt::simd::gather(values.buf, chiset.words[0], positions, amnt, out);
     }
 
     /*
-     * insert a tree into position of tree
-     * position should be result of get_position
+     * fill an empty node in one go, used by bulk loading
+     * values holds one entry per bit in chiset, children one per bit in
+     * chiset & inv_leaf, both in position order, children must come from
+     * new_node() and are owned by this node afterwards
      */
-    void insert(const unsigned position, const value_type value)
+    void assign(const std::uint64_t new_chiset, const std::uint64_t new_inv_leaf, const value_type * new_values, tree * const * new_children)
     {
-        assert(position < 64);
-        assert(! is_set(position));
+        assert(! this->has_children());
 
-        const unsigned cpos   { get_children_position(position) };
-        const unsigned c_amnt { children_amnt() };
-
-        children.insert(cpos, new tree<value_type>(), c_amnt);
-        values.insert(cpos, value, c_amnt);
-        chiset.set(position);
-        inv_leaf.set(position);
+        chiset.words[0] = new_chiset;
+        leaf.words[0]   = new_chiset & ~new_inv_leaf;
+        values.assign(new_values, this->value_amount());
+        children.assign(new_children, this->children_amnt());
     }
 
     /*
-     * insert a leaf into position of tree
-     * position should be result of get_position
+     * coordinate level access
+     * depth is the number of levels below this node, a 2d level resolves
+     * 3 bits of x and y, a 3d level 2 bits of x, y and z
+     * all positions of a path are computed at once, see morton.hpp
      */
-    void insert_leaf(const unsigned position, const value_type value)
-    {
-        assert(position < 64);
-        assert(! is_set(position));
-
-        const unsigned cpos   { get_children_position(position) };
-        const unsigned c_amnt { children_amnt() };
-
-        values.insert(cpos, value, c_amnt);
-        chiset.set(position);
-        inv_leaf.reset(position);
-    }
-
-    /*
-     * removes an item from tree
-     * position should be result of get_position
-     */
-    void remove(const unsigned position)
-    {
-        assert(position < 64);
-        assert(is_set(position));
-        assert(! is_leaf(position));
-
-        const unsigned cpos   { get_children_position(position) };
-        const unsigned c_amnt { children_amnt() };
-
-        children[cpos]->collapse();
-        children.erase(cpos);
-        values.erase(cpos);
-        chiset.reset(position);
-    }
 
     /*
-     * get child node
-     * position should be result of get_position
+     * value stored for the cell, or nullptr if nothing is set there
+     * a leaf above the requested depth covers the cell and is returned
      */
-    tree<value_type> * child(const unsigned position) const
+    const value_type * find(const std::uint64_t x, const std::uint64_t y, const unsigned depth) const
     {
-        assert(position < 64);
-        assert(is_set(position));
-        assert(! is_leaf(position));
-
-        const unsigned cpos { get_children_position(position) };
-
-        return children[cpos];
+        hckt::morton::path<2> p { x, y, depth };
+        return this->find_path(p);
     }
 
-    /*
-     * sets node to specific value
-     * note: this does not check whether a value has been inserted here yet
-     * position should be result of get_position
-     */
-    void set_value(const unsigned position, const value_type value)
+    const value_type * find(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth) const
     {
-        assert(position < 64);
-        assert(is_set(position));
-
-        const unsigned cpos { get_children_position(position) };
-
-        values[cpos] = value;
+        hckt::morton::path<3> p { x, y, z, depth };
+        return this->find_path(p);
     }
 
     /*
-     * gets value from specific position
-     * note: this does not check whether a value has been inserted here yet
-     * position should be result of get_position
+     * set the value of a cell, creating nodes along the way
+     * new interior nodes get a default constructed value
      */
-    value_type get_value(const unsigned position) const
-    {
-        assert(position < 64);
-
-        const unsigned cpos { get_children_position(position) };
-
-        return values[cpos];
-    }
-
-
-    /************************************************
-     *
-     * BENCHMARKING CODE
-     *
-     ***********************************************/
-
-    std::size_t calculate_memory_size() const
-    {
-        const unsigned c_amnt { children_amnt() };
-        const unsigned v_amnt { value_amount() };
-
-        std::size_t size {
-              sizeof(chiset)
-            + sizeof(inv_leaf)
-            + sizeof(values)   + (v_amnt * sizeof(value_type))
-            + sizeof(children) + (c_amnt * sizeof(tree<value_type>*))
-        };
-
-        for(unsigned i=0; i<c_amnt; ++i) {
-            size += children[i]->calculate_memory_size();
-        }
-
-        return size;
-    }
-
-    std::size_t calculate_children_amnt() const
+    void insert(const std::uint64_t x, const std::uint64_t y, const value_type value, const unsigned depth)
     {
-        std::size_t amount { children_amnt() };
-
-        for(unsigned i=0, c_amnt = children_amnt(); i<c_amnt; ++i) {
-            amount += children[i]->calculate_children_amnt();
-        }
-
-        return amount;
+        hckt::morton::path<2> p { x, y, depth };
+        this->insert_path(p, value);
     }
 
-    std::size_t calculate_leaf_amount() const
+    void insert(const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const value_type value, const unsigned depth)
     {
-        std::size_t amount { leaf_amnt() };
-
-        for(unsigned i=0, c_amnt = children_amnt(); i<c_amnt; ++i) {
-            amount += children[i]->calculate_leaf_amount();
-        }
-
-        return amount;
+        hckt::morton::path<3> p { x, y, z, depth };
+        this->insert_path(p, value);
     }
 
-    void mem_usage_info() const
+    /*
+     * build an immutable flat copy of this tree, see frozen_tree.hpp
+     * dedup stores identical subtrees once
+     */
+    hckt::frozen_tree<value_type> freeze(const bool dedup = false) const
     {
-        const std::size_t memsize { calculate_memory_size() };
-        const std::size_t c_amnt  { calculate_children_amnt() };
-        const std::size_t l_amnt  { calculate_leaf_amount() };
-        const std::size_t v_amnt  { c_amnt + l_amnt };
-
-        std::cout << "total:     " << hckt::render_size(memsize) << std::endl;
-
-        std::cout << "tree-size: " << hckt::render_size(sizeof(tree<value_type>)) << std::endl;
-        std::cout << "val-size:  " << hckt::render_size(sizeof(value_type)) << std::endl;
-
-        std::cout << "values:    " << hckt::render_number(v_amnt) << std::endl;
-        std::cout << "children:  " << hckt::render_number(c_amnt) << std::endl;
-        std::cout << "leaves:    " << hckt::render_number(l_amnt) << std::endl;
-
-        std::cout << "per-val:   " << (static_cast<double>(memsize) / v_amnt) << " B" << std::endl;
-        std::cout << "overhead:  " << (static_cast<double>(memsize - (v_amnt * sizeof(value_type))) / v_amnt) << " B" << std::endl;
+        return hckt::frozen_tree<value_type>(*this, dedup);
     }
 
 };
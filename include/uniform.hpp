@@ -0,0 +1,288 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Jett
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef HCKT_UNIFORM_H
+#define HCKT_UNIFORM_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include "morton.hpp"
+#include "traversal.hpp"
+
+namespace hckt
+{
+
+/*
+ * uniform region collapsing
+ *
+ * a node whose 64 positions are all leaves holding the same value says
+ * no more than a single leaf with that value in its parent, and a node
+ * with nothing set says nothing at all
+ * the functions below keep a tree (tree, block_tree, ...) free of both:
+ * writes merge the nodes they make uniform and drop the nodes they
+ * empty, and a write inside a merged region splits it again first
+ * cells read back the same through find(), only the interior value a
+ * parent held for a merged node is replaced by the merged value
+ *
+ * they are opt in, the node level insert/set_value/remove and the
+ * coordinate insert of the trees themselves never merge
+ */
+namespace uniform
+{
+    /*
+     * whether node can become a single leaf, and with which value
+     */
+    template <typename Tree, typename T>
+    bool mergeable(const Tree & node, T & value)
+    {
+        if(node.set_mask() != ~std::uint64_t { 0 } || node.leaf_mask() != ~std::uint64_t { 0 }) {
+            return false;
+        }
+
+        value = node.get_value(0);
+
+        for(unsigned pos=1; pos<64; ++pos) {
+            if(! (node.get_value(pos) == value)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /*
+     * turn the leaf at position into a node of 64 leaves holding its value
+     */
+    template <typename Tree>
+    Tree * split(Tree & node, const unsigned position)
+    {
+        assert(node.is_set(position) && node.is_leaf(position));
+
+        const auto value = node.get_value(position);
+
+        node.remove(position);
+        node.insert(position, value);
+
+        Tree * c { node.child(position) };
+
+        for(unsigned pos=0; pos<64; ++pos) {
+            c->insert_leaf(pos, value);
+        }
+
+        return c;
+    }
+
+    /*
+     * after a write below (node, position), merge or drop the child
+     * there and repeat one level up for as long as something changes
+     * path[l] is the node at level l, positions[l] the position taken
+     */
+    template <typename Tree>
+    unsigned settle(Tree * const * path, const unsigned * positions, unsigned level)
+    {
+        unsigned changed { 0 };
+
+        while(level-- > 0) {
+            Tree &         node = *path[level];
+            const unsigned pos { positions[level] };
+
+            if(! node.is_set(pos) || node.is_leaf(pos)) {
+                continue;
+            }
+
+            const Tree * c { node.child(pos) };
+            typename std::decay<decltype(c->get_value(0))>::type value;
+
+            if(c->set_mask() == 0) {
+                node.remove(pos);
+            } else if(mergeable(*c, value)) {
+                node.remove(pos);
+                node.insert_leaf(pos, value);
+            } else {
+                break;
+            }
+
+            ++changed;
+        }
+
+        return changed;
+    }
+};
+
+/*
+ * set the value of a cell like tree::insert_path, a merged region the
+ * cell lies in is split down to it, and nodes left uniform afterwards
+ * are merged
+ */
+template <typename Tree, typename Path, typename T>
+void uniform_insert_path(Tree & root, Path & p, const T value)
+{
+    assert(! p.done());
+
+    Tree *   path[morton::max_depth_3d];
+    unsigned positions[morton::max_depth_3d];
+    unsigned level { 0 };
+    Tree *   node { &root };
+
+    while(true) {
+        const unsigned pos { p.next() };
+
+        path[level]      = node;
+        positions[level] = pos;
+        ++level;
+
+        if(p.done()) {
+            if(node->is_set(pos)) {
+                node->set_value(pos, value);
+            } else {
+                node->insert_leaf(pos, value);
+            }
+
+            break;
+        }
+
+        if(! node->is_set(pos)) {
+            node->insert(pos, T { });
+        } else if(node->is_leaf(pos)) {
+            if(node->get_value(pos) == value) {
+                return;
+            }
+
+            uniform::split(*node, pos);
+        }
+
+        node = node->child(pos);
+    }
+
+    //the cell itself is a leaf, settling starts at its parent
+    uniform::settle(path, positions, level - 1);
+}
+
+/*
+ * remove a cell, a merged region it lies in is split down to it first,
+ * nodes emptied by the removal are dropped
+ * false if nothing was set there
+ */
+template <typename Tree, typename Path>
+bool uniform_erase_path(Tree & root, Path & p)
+{
+    assert(! p.done());
+
+    Tree *   path[morton::max_depth_3d];
+    unsigned positions[morton::max_depth_3d];
+    unsigned level { 0 };
+    Tree *   node { &root };
+
+    while(true) {
+        const unsigned pos { p.next() };
+
+        if(! node->is_set(pos)) {
+            return false;
+        }
+
+        path[level]      = node;
+        positions[level] = pos;
+        ++level;
+
+        if(p.done()) {
+            node->remove(pos);
+            break;
+        }
+
+        node = node->is_leaf(pos) ? uniform::split(*node, pos) : node->child(pos);
+    }
+
+    uniform::settle(path, positions, level - 1);
+
+    return true;
+}
+
+template <typename Tree, typename T>
+void uniform_insert(Tree & root, const std::uint64_t x, const std::uint64_t y, const T value, const unsigned depth)
+{
+    morton::path<2> p { x, y, depth };
+    uniform_insert_path(root, p, value);
+}
+
+template <typename Tree, typename T>
+void uniform_insert(Tree & root, const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const T value, const unsigned depth)
+{
+    morton::path<3> p { x, y, z, depth };
+    uniform_insert_path(root, p, value);
+}
+
+template <typename Tree>
+bool uniform_erase(Tree & root, const std::uint64_t x, const std::uint64_t y, const unsigned depth)
+{
+    morton::path<2> p { x, y, depth };
+    return uniform_erase_path(root, p);
+}
+
+template <typename Tree>
+bool uniform_erase(Tree & root, const std::uint64_t x, const std::uint64_t y, const std::uint64_t z, const unsigned depth)
+{
+    morton::path<3> p { x, y, z, depth };
+    return uniform_erase_path(root, p);
+}
+
+/*
+ * merge every uniform node and drop every empty one, bottom up, for
+ * trees built without the functions above, ie. by bulk_load
+ * returns the number of nodes merged or dropped
+ */
+template <typename Tree>
+std::size_t merge_uniform(Tree & root)
+{
+    std::size_t changed { 0 };
+
+    //a node comes after its children, which are settled by then
+    for(postorder_iterator<Tree> it { root }, end { }; it != end; ++it) {
+        Tree & node = *it;
+
+        for(std::uint64_t dist=node.chidist(); dist != 0; dist &= dist - 1) {
+            const unsigned pos ( __builtin_ctzll(dist) );
+            const Tree *   c { node.child(pos) };
+            typename std::decay<decltype(c->get_value(0))>::type value;
+
+            if(c->set_mask() == 0) {
+                node.remove(pos);
+            } else if(uniform::mergeable(*c, value)) {
+                node.remove(pos);
+                node.insert_leaf(pos, value);
+            } else {
+                continue;
+            }
+
+            ++changed;
+        }
+    }
+
+    return changed;
+}
+
+};
+
+#endif
@@ -2,14 +2,47 @@
 #define HCKT_UTIL_H
 
 #include <cassert>
+#include <cstdint>
 #include <string>
 #include <iomanip>
 #include <locale>
 #include <sstream>
 #include <array>
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
 
 namespace hckt
 {
+    //counts number of set bits
+    inline unsigned popcount(std::uint64_t x)
+    {
+#ifdef __SSE4_2__
+        return _mm_popcnt_u64(x);
+#else
+        constexpr std::uint64_t m1  { 0x5555555555555555 };
+        constexpr std::uint64_t m2  { 0x3333333333333333 };
+        constexpr std::uint64_t m4  { 0x0f0f0f0f0f0f0f0f };
+        constexpr std::uint64_t h01 { 0x0101010101010101 };
+
+        x -= (x >> 1) & m1;
+        x  = (x & m2) + ((x >> 2) & m2);
+        x  = (x + (x >> 4)) & m4;
+
+        return (x * h01) >> 56;
+#endif
+    }
+
+    /*
+     * number of set bits below position
+     */
+    inline unsigned rank(const std::uint64_t x, const unsigned position)
+    {
+        assert(position < 64);
+
+        return position == 0 ? position : popcount(x << (64 - position));
+    }
+
     /*
      * 2d get position
      * convert three part positions to memory location
@@ -19,13 +52,10 @@ namespace hckt
      * y1:x1:y2:x2:y3:x3
      *
      */
-    unsigned get_position_2d(const unsigned d1, const unsigned d2, const unsigned d3)
+    constexpr unsigned get_position_2d(const unsigned d1, const unsigned d2, const unsigned d3)
     {
-        assert(d1 < 4);
-        assert(d2 < 4);
-        assert(d3 < 4);
-
-        return ((1 << 0) * ((d1 & 2) >> 1))
+        return assert(d1 < 4), assert(d2 < 4), assert(d3 < 4),
+               ((1 << 0) * ((d1 & 2) >> 1))
              + ((1 << 1) *  (d1 & 1))
              + ((1 << 2) * ((d2 & 2) >> 1))
              + ((1 << 3) *  (d2 & 1))
@@ -33,24 +63,18 @@ namespace hckt
              + ((1 << 5) *  (d3 & 1));
     }
 
-    unsigned get_x_2d(const unsigned d1, const unsigned d2, const unsigned d3)
+    constexpr unsigned get_x_2d(const unsigned d1, const unsigned d2, const unsigned d3)
     {
-        assert(d1 < 4);
-        assert(d2 < 4);
-        assert(d3 < 4);
-
-        return ((d1 & 1) << 0)
+        return assert(d1 < 4), assert(d2 < 4), assert(d3 < 4),
+               ((d1 & 1) << 0)
              + ((d2 & 1) << 1)
              + ((d3 & 1) << 2);
     }
 
-    unsigned get_y_2d(const unsigned d1, const unsigned d2, const unsigned d3)
+    constexpr unsigned get_y_2d(const unsigned d1, const unsigned d2, const unsigned d3)
     {
-        assert(d1 < 4);
-        assert(d2 < 4);
-        assert(d3 < 4);
-
-        return ((d1 & 2) >> 1 << 0)
+        return assert(d1 < 4), assert(d2 < 4), assert(d3 < 4),
+               ((d1 & 2) >> 1 << 0)
              + ((d2 & 2) >> 1 << 1)
              + ((d3 & 2) >> 1 << 2);
     }
@@ -64,12 +88,10 @@ namespace hckt
      * z1:y1:x1:z2:y2:x2
      *
      */
-    unsigned get_position_3d(const unsigned d1, const unsigned d2)
+    constexpr unsigned get_position_3d(const unsigned d1, const unsigned d2)
     {
-        assert(d1 < 8);
-        assert(d2 < 8);
-
-        return ((1 << 0) * ((d1 & 4) >> 2))
+        return assert(d1 < 8), assert(d2 < 8),
+               ((1 << 0) * ((d1 & 4) >> 2))
              + ((1 << 1) * ((d1 & 2) >> 1))
              + ((1 << 2) *  (d1 & 1))
              + ((1 << 3) * ((d2 & 4) >> 2))
@@ -77,34 +99,28 @@ namespace hckt
              + ((1 << 5) *  (d2 & 1));
     }
 
-    unsigned get_x_3d(const unsigned d1, const unsigned d2)
+    constexpr unsigned get_x_3d(const unsigned d1, const unsigned d2)
     {
-        assert(d1 < 8);
-        assert(d2 < 8);
-
-        return ((d1 & 1) << 0)
+        return assert(d1 < 8), assert(d2 < 8),
+               ((d1 & 1) << 0)
              + ((d2 & 1) << 1);
     }
 
-    unsigned get_y_3d(const unsigned d1, const unsigned d2)
+    constexpr unsigned get_y_3d(const unsigned d1, const unsigned d2)
     {
-        assert(d1 < 8);
-        assert(d2 < 8);
-
-        return ((d1 & 2) >> 1 << 0)
+        return assert(d1 < 8), assert(d2 < 8),
+               ((d1 & 2) >> 1 << 0)
              + ((d2 & 2) >> 1 << 1);
     }
 
-    unsigned get_z_3d(const unsigned d1, const unsigned d2)
+    constexpr unsigned get_z_3d(const unsigned d1, const unsigned d2)
     {
-        assert(d1 < 8);
-        assert(d2 < 8);
-
-        return ((d1 & 4) >> 2 << 0)
+        return assert(d1 < 8), assert(d2 < 8),
+               ((d1 & 4) >> 2 << 0)
              + ((d2 & 4) >> 2 << 1);
     }
 
-    std::string render_size(const std::uint64_t size)
+    inline std::string render_size(const std::uint64_t size)
     {
         constexpr uint64_t exbibytes { 1024ULL * 1024ULL * 1024ULL * 1024ULL * 1024ULL * 1024ULL };
         const std::array<std::string, 7> sizes = {{ "EiB", "PiB", "TiB", "GiB", "MiB", "KiB", "B" }};
@@ -112,7 +128,7 @@ namespace hckt
         std::string result { };
         std::uint64_t multiplier { exbibytes };
 
-        for(int i=0; i<sizes.size(); i++, multiplier /= 1024) {   
+        for(std::size_t i=0; i<sizes.size(); i++, multiplier /= 1024) {   
             if(size < multiplier) {
                 continue;
             }
@@ -131,7 +147,7 @@ namespace hckt
     }
 
     template <typename NType>
-    std::string render_number(const NType number)
+    inline std::string render_number(const NType number)
     {
         std::stringstream ss;
         ss.imbue(std::locale(""));